@@ -40,7 +40,7 @@ class DigitViewer {
 public:
   DigitViewer();
   ~DigitViewer();
-  void setData(const std::vector<int> &dataSample);
+  void setData(const Math::MatrixView<int> &dataSample);
   void draw(Vector2 position, float rotation, float scale);
 
 private:
@@ -62,14 +62,15 @@ inline DigitViewer::~DigitViewer() {
 }
 
 // Set Data to Viewer and render the 2D texture
-inline void DigitViewer::setData(const std::vector<int> &dataSample) {
+inline void DigitViewer::setData(const Math::MatrixView<int> &dataSample) {
   if (texture.id != 0)
     UnloadTexture(texture);
 
   std::vector<unsigned char> pixelData;
   pixelData.reserve(64);
 
-  for (int val : dataSample) {
+  for (int j = 0; j < dataSample.cols(); j++) {
+    int val = dataSample.at(0, j);
     int scaledVal = static_cast<int>((val / 16.0f) * 255.0f);
     pixelData.push_back(static_cast<unsigned char>(scaledVal));
   }
@@ -270,7 +271,7 @@ inline void drawNetworkConnections(
     const auto &layerIn = layout.xy[layerId];
     const auto &layerOut = layout.xy[layerId + 1];
 
-    const std::vector<T> *wData = nullptr;
+    const Math::AlignedVector<T> *wData = nullptr;
     int wCols = 0;
     if (useWeights && (layerId * 2) < params.size()) {
       auto weightMatrix = params[layerId * 2];
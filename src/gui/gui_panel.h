@@ -13,6 +13,8 @@
 enum class ActivationType { ReLU, Tanh, Sigmoid, Linear, Softmax };
 enum class CostType { MSE, CrossEntropy, MAE };
 enum class OptimizerType { Adam, SGD };
+// Tipo escalar de todo el pipeline (datos, modelo, pérdidas)
+enum class PrecisionType { Float32, Float64 };
 
 struct ModelConfig {
   std::vector<int> topology;
@@ -21,6 +23,7 @@ struct ModelConfig {
   CostType costFunction;
   OptimizerType optimizer;
   float learningRate;
+  PrecisionType precision;
 };
 
 // -------------------------------------------------------------------------
@@ -40,6 +43,8 @@ public:
   bool costEdit = false;
   int optimizerIndex = 0;
   bool optimizerEdit = false;
+  int precisionIndex = 1;
+  bool precisionEdit = false;
 
   float learningRate = 0.01f;
   int activeControl = -1;
@@ -161,13 +166,15 @@ public:
     Rectangle outputDropRec = {160, controlsY + 35, 90, 25};
     Rectangle costDropRec = {160, controlsY + 70, 90, 25};
     Rectangle optimDropRec = {160, controlsY + 105, 90, 25};
+    Rectangle precisionDropRec = {160, controlsY + 140, 90, 25};
 
     GuiLabel((Rectangle){25, controlsY, 130, 25}, "Hidden Act.:");
     GuiLabel((Rectangle){25, controlsY + 35, 130, 25}, "Output Act.:");
     GuiLabel((Rectangle){25, controlsY + 70, 130, 25}, "Cost Func.:");
     GuiLabel((Rectangle){25, controlsY + 105, 130, 25}, "Optimizer:");
+    GuiLabel((Rectangle){25, controlsY + 140, 130, 25}, "Precision:");
 
-    float lrY = controlsY + 140;
+    float lrY = controlsY + 175;
     GuiLabel((Rectangle){25, lrY, 130, 25}, "Learning Rate:");
     GuiSlider((Rectangle){160, lrY, 90, 20}, NULL,
               TextFormat("%.4f", learningRate), &learningRate, 0.0001f, 0.1f);
@@ -180,6 +187,7 @@ public:
       outputActEdit = false;
       costEdit = false;
       optimizerEdit = false;
+      precisionEdit = false;
     }
 
     // GRAPH
@@ -196,9 +204,18 @@ public:
              (int)dataPos.y + (int)(8 * scale) + 10, 20, RAYWHITE);
 
     // DROPDOWNS
+    if (GuiDropdownBox(precisionDropRec, "Float32;Float64", &precisionIndex,
+                       precisionEdit)) {
+      precisionEdit = !precisionEdit;
+      optimizerEdit = false;
+      costEdit = false;
+      outputActEdit = false;
+      hiddenActEdit = false;
+    }
     if (GuiDropdownBox(optimDropRec, "Adam;SGD", &optimizerIndex,
                        optimizerEdit)) {
       optimizerEdit = !optimizerEdit;
+      precisionEdit = false;
       costEdit = false;
       outputActEdit = false;
       hiddenActEdit = false;
@@ -206,6 +223,7 @@ public:
     if (GuiDropdownBox(costDropRec, "MSE;CrossEntropy;MAE", &costIndex,
                        costEdit)) {
       costEdit = !costEdit;
+      precisionEdit = false;
       optimizerEdit = false;
       outputActEdit = false;
       hiddenActEdit = false;
@@ -213,6 +231,7 @@ public:
     if (GuiDropdownBox(outputDropRec, "Linear;Softmax", &outputActIndex,
                        outputActEdit)) {
       outputActEdit = !outputActEdit;
+      precisionEdit = false;
       optimizerEdit = false;
       costEdit = false;
       hiddenActEdit = false;
@@ -220,6 +239,7 @@ public:
     if (GuiDropdownBox(hiddenDropRec, "ReLU;Tanh;Sigmoid", &hiddenActIndex,
                        hiddenActEdit)) {
       hiddenActEdit = !hiddenActEdit;
+      precisionEdit = false;
       optimizerEdit = false;
       outputActEdit = false;
       costEdit = false;
@@ -292,6 +312,14 @@ public:
       config.optimizer = OptimizerType::Adam;
       break;
     }
+    switch (precisionIndex) {
+    case 0:
+      config.precision = PrecisionType::Float32;
+      break;
+    default:
+      config.precision = PrecisionType::Float64;
+      break;
+    }
     rebuildRequested = false;
     return config;
   }
@@ -2,6 +2,7 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <type_traits>
 
 #include "raylib.h"
 #define RAYGUI_IMPLEMENTATION
@@ -42,10 +43,65 @@ const float GUI_PANEL_WIDTH = 280.0f;
 void CheckWindowResize(NetworkLayout &layout, Vector2 &dataPos, Topology &topo,
                        double radius);
 void ToggleAppFullscreen();
-void RebuildNetworkModel(NetworkGui &gui, NN::Model<double> &model,
-                         Topology &topology, NetworkLayout &layout,
-                         int inputSize, int outputSize, int screenW,
-                         int screenH, double radius, float panelW);
+template <typename T>
+void RebuildNetworkModel(const ModelConfig &cfg, NN::Model<T> &model);
+
+/*********************************************************************************************************
+ *
+ * Training Pipeline: datasets, model and validation loss in one scalar type
+ *
+ *********************************************************************************************************/
+
+template <typename T> struct TrainingPipeline {
+  // Labels stay as class indices, one-hot targets only exist for MSE / MAE
+  Utils::TrainTestSplit<T, int> dataset;
+  Math::Matrix<T> Y_trainOneHot, Y_valOneHot;
+  Math::Matrix<T> X_viewer_all;
+  NN::Model<T> model;
+  bool sparseLabels = false;
+  int numClasses;
+
+  // Convert the integer features once, straight into the aligned storage
+  TrainingPipeline(const Math::Matrix<int> &srcFeat,
+                   const Math::Matrix<int> &srcLabels,
+                   const Math::Matrix<int> &viewerFeat, int outputSize)
+      : X_viewer_all(toScalar(viewerFeat)), numClasses(outputSize) {
+    Math::Matrix<T> X_source = toScalar(srcFeat);
+    dataset = Utils::SplitShuffle::split(X_source, srcLabels, 0.8f, 42);
+  }
+
+  void rebuild(const ModelConfig &cfg) {
+    RebuildNetworkModel(cfg, model);
+    sparseLabels = cfg.costFunction == CostType::CrossEntropy;
+    if (!sparseLabels && Y_trainOneHot.size() == 0) {
+      Y_trainOneHot = Data::Encoder::toOneHot<T>(dataset.Y_train, numClasses);
+      Y_valOneHot = Data::Encoder::toOneHot<T>(dataset.Y_val, numClasses);
+    }
+  }
+
+  // One epoch on the training split, then the loss on the validation split
+  void trainEpoch(NetworkGui &gui) {
+    T trainLoss, valLoss;
+    if (sparseLabels) {
+      trainLoss = model.train_step(dataset.X_train, dataset.Y_train);
+      valLoss = model.evaluate(dataset.X_val, dataset.Y_val);
+    } else {
+      trainLoss = model.train_step(dataset.X_train, Y_trainOneHot);
+      valLoss = model.evaluate(dataset.X_val, Y_valOneHot);
+    }
+    gui.AddLosses((double)trainLoss, (double)valLoss);
+  }
+
+  int predict(size_t sampleId) {
+    Math::Matrix<T> x_in = X_viewer_all.viewRow(sampleId);
+    return Data::Encoder::argMax(model.predict(x_in).data());
+  }
+
+  static Math::Matrix<T> toScalar(const Math::Matrix<int> &m) {
+    Math::AlignedVector<T> values(m.data().begin(), m.data().end());
+    return Math::Matrix<T>(std::move(values), m.shape());
+  }
+};
 
 /*********************************************************************************************************
  *
@@ -111,18 +167,6 @@ int main(int argc, char *argv[]) {
   // Number of Classes
   size_t outputSize = 10;
 
-  // Create Data as Matrix
-  std::vector<double> srcFeatDbl(srcFeat.data().begin(), srcFeat.data().end());
-  Math::Matrix<double> X_source(std::move(srcFeatDbl), srcFeat.shape());
-
-  // One-Hot Enconding of Labels
-  Math::Matrix<double> Y_source =
-      Data::Encoder::toOneHot<double>(srcLabels, (int)outputSize);
-
-  // Split Data in Training and Validation
-  std::cout << "[INFO] Split Data..." << std::endl;
-  auto dataset = Utils::SplitShuffle::split(X_source, Y_source, 0.8f, 42);
-
   // -------------------------------------------------------------------------
   // Test Data
   // -------------------------------------------------------------------------
@@ -141,11 +185,31 @@ int main(int argc, char *argv[]) {
   const auto &viewerLabels = viewerSource.getLabels();
   size_t totalViewerSamples = viewerFeatures.shape()[0];
 
-  // Create Features and labels as Matrix
-  std::vector<double> viewerFeatDbl(viewerFeatures.data().begin(),
-                                    viewerFeatures.data().end());
-  Math::Matrix<double> X_viewer_all(std::move(viewerFeatDbl),
-                                    viewerFeatures.shape());
+  // Create Data as Matrix and Split in Training and Validation for the
+  // compiled precision only. Switching precision builds the other pipeline
+  // (same seed, same split) and releases this one. Labels stay as class
+  // indices.
+  std::unique_ptr<TrainingPipeline<float>> pipelineF32;
+  std::unique_ptr<TrainingPipeline<double>> pipelineF64;
+  PrecisionType precision = PrecisionType::Float64;
+
+  // Run `fn` on the pipeline of the compiled precision
+  auto withPipeline = [&](auto &&fn) {
+    auto run = [&](auto &pipeline, auto &other) {
+      using Pipeline = typename std::decay_t<decltype(pipeline)>::element_type;
+      if (!pipeline) {
+        std::cout << "[INFO] Split Data..." << std::endl;
+        pipeline = std::make_unique<Pipeline>(srcFeat, srcLabels,
+                                              viewerFeatures, (int)outputSize);
+        other.reset();
+      }
+      fn(*pipeline);
+    };
+    if (precision == PrecisionType::Float64)
+      run(pipelineF64, pipelineF32);
+    else
+      run(pipelineF32, pipelineF64);
+  };
 
   // -------------------------------------------------------------------------
   // GUI Initial Set Up
@@ -153,7 +217,7 @@ int main(int argc, char *argv[]) {
   NetworkGui gui;
   size_t currentSampleId = 0;
   DigitViewer viewer;
-  viewer.setData(viewerFeatures.atRow(currentSampleId).data());
+  viewer.setData(viewerFeatures.viewRow(currentSampleId));
 
   // Initial Network Layout
   Topology topology = {(int)inputSize, 20, 10, (int)outputSize};
@@ -161,12 +225,6 @@ int main(int argc, char *argv[]) {
       calculateNetworkLayout(topology, GetScreenWidth(), GetScreenHeight(),
                              (float)neuronRadius, GUI_PANEL_WIDTH);
 
-  // Default Model
-  NN::Model<double> model;
-  std::shared_ptr<NN::Optimizer::Optimizer<double>> optimizer = nullptr;
-
-  std::shared_ptr<NN::CostFunc::Loss<double>> currentLossFunc = nullptr;
-
   gui.rebuildRequested = true;
   int predictedLabel = -1;
   int targetLabel = -1;
@@ -180,45 +238,35 @@ int main(int argc, char *argv[]) {
 
     // Rebuild the Model
     if (gui.rebuildRequested) {
-      RebuildNetworkModel(gui, model, topology, layout, (int)inputSize,
-                          (int)outputSize, GetScreenWidth(), GetScreenHeight(),
-                          neuronRadius, GUI_PANEL_WIDTH);
-
       ModelConfig cfg = gui.GetConfig((int)inputSize, (int)outputSize);
-      if (cfg.costFunction == CostType::MSE)
-        currentLossFunc =
-            std::make_shared<NN::CostFunc::MeanSquareError<double>>();
-      else if (cfg.costFunction == CostType::MAE)
-        currentLossFunc =
-            std::make_shared<NN::CostFunc::MeanAbsoluteError<double>>();
-      else
-        currentLossFunc =
-            std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>();
-
-      // Initial inference
-      std::vector<double> curRow = X_viewer_all.atRow(currentSampleId).data();
-      Math::Matrix<double> x_in(curRow, {1, (int)inputSize});
-      predictedLabel = Data::Encoder::argMax(model.predict(x_in).data());
-      targetLabel = viewerLabels.atRow(currentSampleId).data()[0];
+
+      // Update Draws
+      topology = cfg.topology;
+      layout = calculateNetworkLayout(topology, GetScreenWidth(),
+                                      GetScreenHeight(), (float)neuronRadius,
+                                      GUI_PANEL_WIDTH);
+
+      precision = cfg.precision;
+      withPipeline([&](auto &pipeline) {
+        pipeline.rebuild(cfg);
+        // Initial inference
+        predictedLabel = pipeline.predict(currentSampleId);
+      });
+      targetLabel = viewerLabels.data()[currentSampleId];
+
+      // Clear Loss Plot and Loss data
+      gui.ClearHistory();
     }
 
     // Train the Model
     if (IsKeyPressed(KEY_SPACE)) {
-      // Forward and Backward pass and get the Training Loss
-      double trainLoss = model.train_step(dataset.X_train, dataset.Y_train);
-
-      // Forward on Validation Data and get the Validation Loss
-      auto valPreds = model.predict(dataset.X_val);
-      double valLoss = currentLossFunc->forward(valPreds, dataset.Y_val);
-
-      // Update the inference
-      std::vector<double> curRow = X_viewer_all.atRow(currentSampleId).data();
-      Math::Matrix<double> x_in(curRow, {1, (int)inputSize});
-      predictedLabel = Data::Encoder::argMax(model.predict(x_in).data());
-      targetLabel = viewerLabels.atRow(currentSampleId).data()[0];
-
-      // Update the Loss Plot
-      gui.AddLosses(trainLoss, valLoss);
+      withPipeline([&](auto &pipeline) {
+        // Forward and Backward pass, Validation Loss and Loss Plot update
+        pipeline.trainEpoch(gui);
+        // Update the inference
+        predictedLabel = pipeline.predict(currentSampleId);
+      });
+      targetLabel = viewerLabels.data()[currentSampleId];
     }
 
     // Select the Test Sample to Predict using Left and Right Arrows
@@ -234,12 +282,12 @@ int main(int argc, char *argv[]) {
 
     // Only Predict if Test Sample Change
     if (gui.sampleChanged) {
-      viewer.setData(viewerFeatures.atRow(currentSampleId).data());
+      viewer.setData(viewerFeatures.viewRow(currentSampleId));
       // Make the inference
-      std::vector<double> curRow = X_viewer_all.atRow(currentSampleId).data();
-      Math::Matrix<double> x_in(curRow, {1, (int)inputSize});
-      predictedLabel = Data::Encoder::argMax(model.predict(x_in).data());
-      targetLabel = viewerLabels.atRow(currentSampleId).data()[0];
+      withPipeline([&](auto &pipeline) {
+        predictedLabel = pipeline.predict(currentSampleId);
+      });
+      targetLabel = viewerLabels.data()[currentSampleId];
       gui.sampleChanged = false;
     }
 
@@ -249,7 +297,9 @@ int main(int argc, char *argv[]) {
     drawFPSInfo(10, GREEN);
 
     drawNetwork(layout);
-    drawNetworkConnections(layout, model.get_parameters());
+    withPipeline([&](auto &pipeline) {
+      drawNetworkConnections(layout, pipeline.model.get_parameters());
+    });
     viewer.draw(dataSamplePos, 0.0f, (float)digitScale);
 
     int textY = (int)dataSamplePos.y + (8 * (int)digitScale) + 10;
@@ -279,82 +329,70 @@ int main(int argc, char *argv[]) {
  *
  **********************************************************************************************************************/
 
-void RebuildNetworkModel(NetworkGui &gui, NN::Model<double> &model,
-                         Topology &topology, NetworkLayout &layout,
-                         int inputSize, int outputSize, int screenW,
-                         int screenH, double radius, float panelW) {
+template <typename T>
+void RebuildNetworkModel(const ModelConfig &cfg, NN::Model<T> &model) {
 
-  std::cout << "[INFO] Building new model..." << std::endl;
-
-  // Get new model
-  ModelConfig cfg = gui.GetConfig(inputSize, outputSize);
-
-  // Update Draws
-  topology = cfg.topology;
-  layout =
-      calculateNetworkLayout(topology, screenW, screenH, (float)radius, panelW);
+  std::cout << "[INFO] Building new model ("
+            << (std::is_same_v<T, float> ? "float32" : "float64") << ")..."
+            << std::endl;
 
   // Init Sequential Layer
-  auto sequential = std::make_shared<NN::Layer::Sequential<double>>();
+  auto sequential = std::make_shared<NN::Layer::Sequential<T>>();
 
   // Hidden Layers
   for (size_t i = 1; i < cfg.topology.size() - 1; ++i) {
-    std::shared_ptr<NN::Ops::Operation<double>> act;
+    std::shared_ptr<NN::Ops::Operation<T>> act;
     switch (cfg.hiddenActivation) {
     case ActivationType::ReLU:
-      act = std::make_shared<NN::ActFunc::ReLU<double>>();
+      act = std::make_shared<NN::ActFunc::ReLU<T>>();
       break;
     case ActivationType::Tanh:
-      act = std::make_shared<NN::ActFunc::Tanh<double>>();
+      act = std::make_shared<NN::ActFunc::Tanh<T>>();
       break;
     case ActivationType::Sigmoid:
-      act = std::make_shared<NN::ActFunc::Sigmoid<double>>();
+      act = std::make_shared<NN::ActFunc::Sigmoid<T>>();
       break;
     default:
-      act = std::make_shared<NN::ActFunc::ReLU<double>>();
+      act = std::make_shared<NN::ActFunc::ReLU<T>>();
       break;
     }
-    sequential->add(
-        std::make_shared<NN::Layer::Dense<double>>(cfg.topology[i], act));
+    sequential->add(std::make_shared<NN::Layer::Dense<T>>(cfg.topology[i], act));
   }
 
   // Output Layer
-  std::shared_ptr<NN::Ops::Operation<double>> outAct;
+  std::shared_ptr<NN::Ops::Operation<T>> outAct;
   if (cfg.outputActivation == ActivationType::Softmax)
-    outAct = std::make_shared<NN::ActFunc::Softmax<double>>();
+    outAct = std::make_shared<NN::ActFunc::Softmax<T>>();
   else
-    outAct = std::make_shared<NN::ActFunc::Linear<double>>();
+    outAct = std::make_shared<NN::ActFunc::Linear<T>>();
   sequential->add(
-      std::make_shared<NN::Layer::Dense<double>>(outputSize, outAct));
+      std::make_shared<NN::Layer::Dense<T>>(cfg.topology.back(), outAct));
 
   // Conf Loss
-  std::shared_ptr<NN::CostFunc::Loss<double>> lossFunc;
+  std::shared_ptr<NN::CostFunc::Loss<T>> lossFunc;
   switch (cfg.costFunction) {
   case CostType::MSE:
-    lossFunc = std::make_shared<NN::CostFunc::MeanSquareError<double>>();
+    lossFunc = std::make_shared<NN::CostFunc::MeanSquareError<T>>();
     break;
   case CostType::MAE:
-    lossFunc = std::make_shared<NN::CostFunc::MeanAbsoluteError<double>>();
+    lossFunc = std::make_shared<NN::CostFunc::MeanAbsoluteError<T>>();
     break;
   case CostType::CrossEntropy:
     lossFunc =
-        std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>();
+        std::make_shared<NN::CostFunc::SparseCategoricalCrossEntropy<T>>();
     break;
   }
 
   // Conf Optimizer
-  std::shared_ptr<NN::Optimizer::Optimizer<double>> optimizer;
+  std::shared_ptr<NN::Optimizer::Optimizer<T>> optimizer;
   if (cfg.optimizer == OptimizerType::Adam)
-    optimizer = std::make_shared<NN::Optimizer::Adam<double>>(cfg.learningRate);
+    optimizer = std::make_shared<NN::Optimizer::Adam<T>>(cfg.learningRate);
   else
-    optimizer = std::make_shared<NN::Optimizer::SGD<double>>(cfg.learningRate);
+    optimizer = std::make_shared<NN::Optimizer::SGD<T>>(cfg.learningRate);
 
   // Compile Model
   model.set_layers(sequential);
   model.compile(lossFunc, optimizer);
-
-  // Clear Loss Plot and Loss data
-  gui.ClearHistory();
 }
 
 void ToggleAppFullscreen() {
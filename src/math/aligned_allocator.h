@@ -0,0 +1,57 @@
+#pragma once
+#include "arena.h"
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/********************************************************************************
+ *
+ * Aligned storage for Matrix buffers
+ *
+ * Every buffer starts on a 64-byte boundary: one cache line and one full
+ * AVX-512 register, so vector loads never split a line. Buffers come from the
+ * active Memory::Arena of the calling thread when there is one (see arena.h)
+ * and from the heap otherwise.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+constexpr std::size_t MATRIX_ALIGNMENT = 64;
+
+template <typename T, std::size_t Alignment = MATRIX_ALIGNMENT>
+class AlignedAllocator {
+public:
+  using value_type = T;
+
+  template <typename U> struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() noexcept = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(Memory::allocate(n * sizeof(T), Alignment));
+  }
+
+  void deallocate(T *p, std::size_t) noexcept {
+    Memory::deallocate(p, Alignment);
+  }
+};
+
+template <typename T, typename U, std::size_t A>
+bool operator==(const AlignedAllocator<T, A> &, const AlignedAllocator<U, A> &) {
+  return true;
+}
+
+template <typename T, typename U, std::size_t A>
+bool operator!=(const AlignedAllocator<T, A> &, const AlignedAllocator<U, A> &) {
+  return false;
+}
+
+// Storage type of Matrix
+template <typename T> using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+} // namespace Math
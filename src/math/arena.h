@@ -0,0 +1,220 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/********************************************************************************
+ *
+ * Arena (bump) allocation for short-lived Matrix buffers
+ *
+ * A training step or an inference call creates dozens of temporary matrices.
+ * Inside an ArenaScope every Matrix buffer allocated on that thread is carved
+ * out of an Arena by bumping a pointer, freeing it is a no-op, and the whole
+ * arena is rewound in O(1) when the outermost scope ends. Blocks are kept, so
+ * after the first step the loop stops touching the global allocator.
+ *
+ *   {
+ *     Memory::ArenaScope step(arena);
+ *     auto out = network->forward(x);     // temporaries come from `arena`
+ *   }                                     // arena.reset()
+ *
+ * Buffers that must outlive the scope (weights, gradients, optimizer state,
+ * layer caches) are allocated inside a PersistentScope, which suspends the
+ * arena on this thread. Thread pool workers never see the arena.
+ *
+ ********************************************************************************/
+
+namespace Math {
+namespace Memory {
+
+class Arena {
+public:
+  static constexpr size_t DEFAULT_BLOCK_BYTES = (size_t)1 << 20;
+  static constexpr size_t HUGE_PAGE_BYTES = (size_t)2 << 20;
+  static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+  // hugePages backs blocks of at least HUGE_PAGE_BYTES with transparent huge
+  // pages when the platform supports it (Linux, madvise)
+  explicit Arena(size_t blockBytes = DEFAULT_BLOCK_BYTES,
+                 bool hugePages = false)
+      : blockBytes_(blockBytes), hugePages_(hugePages) {}
+
+  ~Arena() {
+    for (auto &block : blocks_) {
+      _release(block);
+    }
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void *allocate(size_t bytes, size_t alignment) {
+    while (current_ < blocks_.size()) {
+      Block &block = blocks_[current_];
+      uintptr_t address = reinterpret_cast<uintptr_t>(block.base) + offset_;
+      size_t start = offset_ + (size_t)((alignment - address % alignment) %
+                                        alignment);
+      if (start + bytes <= block.size) {
+        offset_ = start + bytes;
+        used_ += bytes;
+        return block.base + start;
+      }
+      current_++;
+      offset_ = 0;
+    }
+
+    // No kept block has room: grow. Big requests get a block of their own.
+    Block block = _acquire(std::max(blockBytes_, bytes + alignment));
+    blocks_.push_back(block);
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return allocate(bytes, alignment);
+  }
+
+  // Rewind to the first block. Every pointer handed out becomes invalid.
+  void reset() {
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+  }
+
+  size_t used() const { return used_; }
+  size_t capacity() const {
+    size_t total = 0;
+    for (const auto &block : blocks_) {
+      total += block.size;
+    }
+    return total;
+  }
+
+private:
+  friend class ArenaScope;
+
+  struct Block {
+    char *base;
+    size_t size;
+    bool mapped;
+  };
+
+  size_t blockBytes_;
+  bool hugePages_;
+  std::vector<Block> blocks_;
+  size_t current_{0};
+  size_t offset_{0};
+  size_t used_{0};
+  int depth_{0};
+
+  Block _acquire(size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (hugePages_ && bytes >= HUGE_PAGE_BYTES) {
+      bytes = (bytes + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+      void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p != MAP_FAILED) {
+        madvise(p, bytes, MADV_HUGEPAGE);
+        return {static_cast<char *>(p), bytes, true};
+      }
+    }
+#endif
+    char *p = static_cast<char *>(
+        ::operator new(bytes, std::align_val_t(BLOCK_ALIGNMENT)));
+    return {p, bytes, false};
+  }
+
+  static void _release(const Block &block) {
+#if defined(__linux__)
+    if (block.mapped) {
+      munmap(block.base, block.size);
+      return;
+    }
+#endif
+    ::operator delete(block.base, std::align_val_t(BLOCK_ALIGNMENT));
+  }
+};
+
+// Arena receiving the Matrix allocations of this thread (nullptr: heap)
+inline Arena *&active_arena() {
+  thread_local Arena *arena = nullptr;
+  return arena;
+}
+
+// Route this thread's Matrix allocations to `arena` until the scope ends.
+// Scopes nest, the arena is reset when its outermost scope closes.
+class ArenaScope {
+public:
+  explicit ArenaScope(Arena &arena) : arena_(arena), prev_(active_arena()) {
+    arena_.depth_++;
+    active_arena() = &arena_;
+  }
+
+  ~ArenaScope() {
+    active_arena() = prev_;
+    if (--arena_.depth_ == 0) {
+      arena_.reset();
+    }
+  }
+
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+  Arena &arena_;
+  Arena *prev_;
+};
+
+// Suspend the active arena: allocations in this scope come from the heap and
+// may outlive any enclosing ArenaScope
+class PersistentScope {
+public:
+  PersistentScope() : prev_(active_arena()) { active_arena() = nullptr; }
+  ~PersistentScope() { active_arena() = prev_; }
+
+  PersistentScope(const PersistentScope &) = delete;
+  PersistentScope &operator=(const PersistentScope &) = delete;
+
+private:
+  Arena *prev_;
+};
+
+/*******************************************************
+ * Buffer allocation used by AlignedAllocator
+ *******************************************************/
+
+// Every buffer is preceded by `alignment` bytes whose last byte records where
+// it came from, so it can be released correctly from any thread.
+enum class Source : unsigned char { Heap = 0, Arena = 1 };
+
+inline void *allocate(size_t bytes, size_t alignment) {
+  char *base;
+  Source source;
+
+  if (Arena *arena = active_arena()) {
+    base = static_cast<char *>(arena->allocate(bytes + alignment, alignment));
+    source = Source::Arena;
+  } else {
+    base = static_cast<char *>(
+        ::operator new(bytes + alignment, std::align_val_t(alignment)));
+    source = Source::Heap;
+  }
+
+  char *user = base + alignment;
+  user[-1] = static_cast<char>(source);
+  return user;
+}
+
+inline void deallocate(void *p, size_t alignment) {
+  char *user = static_cast<char *>(p);
+  // Arena buffers are released all at once by Arena::reset
+  if (static_cast<Source>(user[-1]) == Source::Heap) {
+    ::operator delete(user - alignment, std::align_val_t(alignment));
+  }
+}
+
+} // namespace Memory
+} // namespace Math
@@ -0,0 +1,205 @@
+#pragma once
+#include "../utils/asserts.h"
+#include "matrix.h"
+#include "matrix_view.h"
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <utility>
+
+/********************************************************************************
+ *
+ * FixedMatrix: R x C matrix with compile-time dimensions
+ *
+ * Storage is an aligned array inside the object (on the stack for locals), so
+ * creating one never allocates. Shape errors between fixed matrices are
+ * compile errors, and loops over a row of at most UNROLL columns are fully
+ * unrolled:
+ *
+ *   FixedMatrix<float, 1, 64> x(sample);                  // copy from a view
+ *   FixedMatrix<float, 1, 20> h = matmul(x, W);           // W: 64 x 20
+ *
+ * Meant for small, fixed layers (see Layer::FixedDense). Large or dynamic
+ * shapes belong in Matrix.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+namespace Fixed {
+
+// Widest row that is unrolled instead of looped
+constexpr int UNROLL = 32;
+
+// f(0), f(1), ..., f(N - 1) with compile-time indices
+template <typename F, int... I>
+inline void unroll(F &&f, std::integer_sequence<int, I...>) {
+  (f(std::integral_constant<int, I>{}), ...);
+}
+
+template <int N, typename F> inline void for_each(F &&f) {
+  if constexpr (N <= UNROLL) {
+    unroll(f, std::make_integer_sequence<int, N>{});
+  } else {
+#pragma omp simd
+    for (int i = 0; i < N; i++) {
+      f(i);
+    }
+  }
+}
+
+} // namespace Fixed
+
+template <typename T, int R, int C> class FixedMatrix {
+  static_assert(R > 0 && C > 0, "FixedMatrix: dimensions must be positive");
+
+public:
+  using value_type = T;
+  static constexpr int ROWS = R;
+  static constexpr int COLS = C;
+  static constexpr int SIZE = R * C;
+
+  FixedMatrix() : data_{} {}
+  FixedMatrix(std::initializer_list<T> values);
+  // Copy of a Matrix or view with the same shape
+  explicit FixedMatrix(const MatrixView<T> &m);
+
+  static constexpr int rows() { return R; }
+  static constexpr int cols() { return C; }
+  static constexpr size_t size() { return (size_t)SIZE; }
+
+  T &operator()(int i, int j) { return data_[i * C + j]; }
+  const T &operator()(int i, int j) const { return data_[i * C + j]; }
+  T *data() { return data_; }
+  const T *data() const { return data_; }
+  T *row(int i) { return data_ + i * C; }
+  const T *row(int i) const { return data_ + i * C; }
+
+  // Read in place by the Matrix kernels
+  MatrixView<T> view() const { return MatrixView<T>(data_, R, C, C); }
+  Matrix<T> to_matrix() const {
+    return Matrix<T>(AlignedVector<T>(data_, data_ + SIZE), {R, C});
+  }
+
+  void fill(T value) {
+    Fixed::for_each<SIZE>([&](int i) { data_[i] = value; });
+  }
+
+  FixedMatrix &operator+=(const FixedMatrix &o) {
+    Fixed::for_each<SIZE>([&](int i) { data_[i] += o.data_[i]; });
+    return *this;
+  }
+  FixedMatrix &operator-=(const FixedMatrix &o) {
+    Fixed::for_each<SIZE>([&](int i) { data_[i] -= o.data_[i]; });
+    return *this;
+  }
+  // Element-wise (Hadamard) product
+  FixedMatrix &operator*=(const FixedMatrix &o) {
+    Fixed::for_each<SIZE>([&](int i) { data_[i] *= o.data_[i]; });
+    return *this;
+  }
+  FixedMatrix &operator*=(T s) {
+    Fixed::for_each<SIZE>([&](int i) { data_[i] *= s; });
+    return *this;
+  }
+  FixedMatrix &operator+=(T s) {
+    Fixed::for_each<SIZE>([&](int i) { data_[i] += s; });
+    return *this;
+  }
+
+private:
+  alignas(64) T data_[SIZE];
+};
+
+template <typename T, int R, int C>
+FixedMatrix<T, R, C>::FixedMatrix(std::initializer_list<T> values) : data_{} {
+  assert_eq(values.size(), (size_t)SIZE, "FixedMatrix::Const::ValueError.");
+  std::copy(values.begin(), values.end(), data_);
+}
+
+template <typename T, int R, int C>
+FixedMatrix<T, R, C>::FixedMatrix(const MatrixView<T> &m) {
+  assert_shape(m.shape(), Shape(R, C), "FixedMatrix::Const");
+  for (int i = 0; i < R; i++) {
+    const T *src = m.data_ptr() + (size_t)i * m.ld();
+    std::copy(src, src + C, data_ + i * C);
+  }
+}
+
+/*******************************************************
+ * Operators
+ *******************************************************/
+
+template <typename T, int R, int C>
+FixedMatrix<T, R, C> operator+(FixedMatrix<T, R, C> a,
+                               const FixedMatrix<T, R, C> &b) {
+  return a += b;
+}
+
+template <typename T, int R, int C>
+FixedMatrix<T, R, C> operator-(FixedMatrix<T, R, C> a,
+                               const FixedMatrix<T, R, C> &b) {
+  return a -= b;
+}
+
+template <typename T, int R, int C>
+FixedMatrix<T, R, C> operator*(FixedMatrix<T, R, C> a,
+                               const FixedMatrix<T, R, C> &b) {
+  return a *= b;
+}
+
+template <typename T, int R, int C>
+FixedMatrix<T, R, C> operator*(FixedMatrix<T, R, C> a, T s) {
+  return a *= s;
+}
+
+template <typename T, int R, int C>
+FixedMatrix<T, R, C> operator*(T s, FixedMatrix<T, R, C> a) {
+  return a *= s;
+}
+
+template <typename T, int R, int C>
+std::ostream &operator<<(std::ostream &os, const FixedMatrix<T, R, C> &m) {
+  os << "FixedMatrix(";
+  for (int i = 0; i < R * C; i++) {
+    os << (i ? ", " : "") << m.data()[i];
+  }
+  return os << ", shape=(" << R << "," << C << "))";
+}
+
+/*******************************************************
+ * Linear Algebra
+ *******************************************************/
+
+namespace Linalg {
+
+// out = a * b. Each row of out accumulates the rows of b scaled by a[i][k];
+// the row update is unrolled when C <= Fixed::UNROLL.
+template <typename T, int R, int K, int C>
+FixedMatrix<T, R, C> matmul(const FixedMatrix<T, R, K> &a,
+                            const FixedMatrix<T, K, C> &b) {
+  FixedMatrix<T, R, C> out;
+  for (int i = 0; i < R; i++) {
+    T *c = out.row(i);
+    for (int k = 0; k < K; k++) {
+      const T aik = a(i, k);
+      const T *bRow = b.row(k);
+      Fixed::for_each<C>([&](int j) { c[j] += aik * bRow[j]; });
+    }
+  }
+  return out;
+}
+
+template <typename T, int R, int C>
+FixedMatrix<T, C, R> transpose(const FixedMatrix<T, R, C> &a) {
+  FixedMatrix<T, C, R> out;
+  for (int i = 0; i < R; i++) {
+    for (int j = 0; j < C; j++) {
+      out(j, i) = a(i, j);
+    }
+  }
+  return out;
+}
+
+} // namespace Linalg
+} // namespace Math
@@ -1,65 +1,157 @@
 #pragma once
+#include "../utils/thread_pool.h"
 #include "matrix.h"
+#include "vmath.h"
 #include <cmath>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace Math {
 namespace Func {
 
-// Apply a function to a Matrix Element-Wise
-template <typename T, typename F> Matrix<T> apply(const Matrix<T> &m, F func) {
-  size_t size = m.size();
-  std::vector<T> result(size);
+// Apply a function Element-Wise into a preallocated output. The input may be
+// a MatrixView (row range, column) or `out` itself.
+template <typename T, typename F>
+void apply(const nondeduced_t<MatrixView<T>> &m, F func, Matrix<T> &out) {
+  bool inPlace = (m.data_ptr() == out.data_ptr() && m.contiguous() &&
+                  m.shape() == out.shape());
+  if (!inPlace) {
+    if (overlaps(m, out)) {
+      throw std::invalid_argument("Func::Apply::Output aliases the input");
+    }
+    out.resize(m.rows(), m.cols());
+  }
 
   const T *pIn = m.data_ptr();
-  T *pOut = result.data();
+  T *pOut = out.data_ptr();
 
-#pragma omp parallel for
-  for (size_t i = 0; i < size; i++) {
-    pOut[i] = func(pIn[i]);
+  if (m.contiguous()) {
+    Utils::parallel_for(0, m.size(), Utils::MIN_PARALLEL_WORK,
+                        [&](size_t lo, size_t hi) {
+                          for (size_t i = lo; i < hi; i++) {
+                            pOut[i] = func(pIn[i]);
+                          }
+                        });
+    return;
   }
 
-  return {result, m.shape()};
+  size_t cols = (size_t)m.cols();
+  size_t ld = m.ld();
+
+  Utils::parallel_for(0, (size_t)m.rows(), Utils::grain_for(cols),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t r = lo; r < hi; r++) {
+                          for (size_t c = 0; c < cols; c++) {
+                            pOut[r * cols + c] = func(pIn[r * ld + c]);
+                          }
+                        }
+                      });
 }
 
-// Exp
-template <typename T> Matrix<T> sqrt(const Matrix<T> &m) {
-  return apply<T>(m, [](T x) { return std::sqrt(x); });
+// Apply a function to a Matrix Element-Wise
+template <typename T, typename F> Matrix<T> apply(const Matrix<T> &m, F func) {
+  Matrix<T> out;
+  apply<T>(m, func, out);
+  return out;
+}
+
+template <typename T, typename F>
+Matrix<T> apply(const MatrixView<T> &m, F func) {
+  Matrix<T> out;
+  apply<T>(m, func, out);
+  return out;
+}
+
+/*******************************************************
+ * Lazy element-wise functions
+ *
+ * These return expression nodes (see matrix_expr.h), so chains such as
+ * sigmoid(x) or sqrt(v) + eps are evaluated in one pass when assigned to a
+ * Matrix.
+ *******************************************************/
+
+namespace Op {
+
+struct Sqrt {
+  template <typename T> T operator()(T x) const { return std::sqrt(x); }
+};
+
+// Transcendental functions run on the VMath kernels. A node evaluated on its
+// own uses the array kernels in the current VMath::precision(); inside a
+// larger fused expression the inline Accurate version is used per element.
+template <typename K> struct Transcendental {
+  static constexpr bool ARRAY_KERNEL = true;
+  VMath::Precision precision = VMath::precision();
+
+  template <typename T> T operator()(T x) const {
+    return K::template f<VMath::Precision::Accurate>(x);
+  }
+  template <typename T> void array(const T *x, T *out, size_t n) const {
+    VMath::map<K>(x, out, n, precision);
+  }
+};
+
+using Exp = Transcendental<VMath::Kernel::Exp>;
+using Log = Transcendental<VMath::Kernel::Log>;
+using Tanh = Transcendental<VMath::Kernel::Tanh>;
+using Sigmoid = Transcendental<VMath::Kernel::Sigmoid>;
+
+template <typename T> struct Pow {
+  T power;
+  T operator()(T x) const { return std::pow(x, power); }
+};
+
+struct Abs {
+  template <typename T> T operator()(T x) const { return std::abs(x); }
+};
+
+struct ReLU {
+  template <typename T> T operator()(T x) const { return x > (T)0 ? x : (T)0; }
+};
+
+} // namespace Op
+
+// Sqrt
+template <typename E, Expr::enable_if_expr<E> = 0> auto sqrt(E &&m) {
+  return Expr::make_unary(Op::Sqrt{}, std::forward<E>(m));
 }
 
 // Exp
-template <typename T> Matrix<T> exp(const Matrix<T> &m) {
-  return apply<T>(m, [](T x) { return std::exp(x); });
+template <typename E, Expr::enable_if_expr<E> = 0> auto exp(E &&m) {
+  return Expr::make_unary(Op::Exp{}, std::forward<E>(m));
 }
 
 // log
-template <typename T> Matrix<T> log(const Matrix<T> &m) {
-  return apply<T>(m, [](T x) { return std::log(x); });
+template <typename E, Expr::enable_if_expr<E> = 0> auto log(E &&m) {
+  return Expr::make_unary(Op::Log{}, std::forward<E>(m));
 }
 
 // Sigmoid
-template <typename T> Matrix<T> sigmoid(const Matrix<T> &m) {
-  return (T)1.0 / ((T)1.0 + exp((T)-1.0 * m));
+template <typename E, Expr::enable_if_expr<E> = 0> auto sigmoid(E &&m) {
+  return Expr::make_unary(Op::Sigmoid{}, std::forward<E>(m));
 }
 
 // Tanh
-template <typename T> Matrix<T> tanh(const Matrix<T> &m) {
-  return apply<T>(m, [](T x) { return std::tanh(x); });
+template <typename E, Expr::enable_if_expr<E> = 0> auto tanh(E &&m) {
+  return Expr::make_unary(Op::Tanh{}, std::forward<E>(m));
 }
 
 // Pow
-template <typename T> Matrix<T> pow(const Matrix<T> &m, T power) {
-  return apply<T>(m, [power](T x) { return std::pow(x, power); });
+template <typename E, Expr::enable_if_expr<E> = 0>
+auto pow(E &&m, Expr::value_t<E> power) {
+  return Expr::make_unary(Op::Pow<Expr::value_t<E>>{power},
+                          std::forward<E>(m));
 }
 
-// Pow
-template <typename T> Matrix<T> abs(const Matrix<T> &m) {
-  return apply<T>(m, [](T x) { return std::abs(x); });
+// Abs
+template <typename E, Expr::enable_if_expr<E> = 0> auto abs(E &&m) {
+  return Expr::make_unary(Op::Abs{}, std::forward<E>(m));
 }
 
 // ReLU
-template <typename T> Matrix<T> relu(const Matrix<T> &m) {
-  return apply<T>(m, [](T x) { return x > (T)0 ? x : (T)0; });
+template <typename E, Expr::enable_if_expr<E> = 0> auto relu(E &&m) {
+  return Expr::make_unary(Op::ReLU{}, std::forward<E>(m));
 }
 
 } // namespace Func
@@ -0,0 +1,576 @@
+#pragma once
+#include "../utils/thread_pool.h"
+#include "aligned_allocator.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/********************************************************************************
+ *
+ * Blocked GEMM engine: C = alpha * A * B + beta * C (row-major)
+ *
+ * Follows the classic Goto/BLIS loop nest:
+ *   - B is packed into KC x NC panels (NR columns wide) that stay in L3/L2.
+ *   - A is packed into MC x KC blocks (MR rows tall) that stay in L2.
+ *   - A register-tiled MR x NR micro-kernel streams both micro-panels from L1
+ *     and keeps the whole C tile in registers for the full KC loop.
+ *
+ * An optional epilogue ep(rowPtr, col, n) is applied to every finished tile
+ * row before it is stored: rowPtr points at the n values being finished, which
+ * belong to C starting at column col. Element-wise work such as bias +
+ * activation therefore needs no extra pass over C.
+ *
+ ********************************************************************************/
+
+namespace Math {
+namespace Gemm {
+
+// Width of the widest vector ISA enabled at compile time (SSE2 is the x86-64
+// baseline).
+#if defined(__AVX512F__)
+constexpr int VECTOR_BYTES = 64;
+#elif defined(__AVX__)
+constexpr int VECTOR_BYTES = 32;
+#else
+constexpr int VECTOR_BYTES = 16;
+#endif
+
+// Blocking parameters. MR x NR is the register tile (two vector registers per
+// row), KC x NR micro-panel of B targets L1, MC x KC block of A targets L2 and
+// KC x NC panel of B targets L3.
+template <typename T> struct Blocking {
+  static constexpr int MR = 6;
+  static constexpr int NR = 2 * VECTOR_BYTES / (int)sizeof(T);
+  static constexpr int KC = 256;
+  static constexpr int MC = 96;
+  static constexpr int NC = 2048;
+};
+
+// Operand layout, BLAS style: Trans::Yes reads the stored matrix as its
+// transpose without materializing it.
+enum class Trans { No, Yes };
+
+// Below this amount of work (M * N * K) packing costs more than it saves.
+constexpr size_t SMALL_GEMM_THRESHOLD = 32 * 32 * 32;
+
+// Epilogue that stores C as computed
+struct NoEpilogue {};
+
+namespace detail {
+
+// Pack an mc x kc block of op(A) into MR-row micro-panels. Inside every panel
+// the MR values of one column are contiguous, rows past mc are zero padded.
+// With Trans::Yes A is stored k-major, so every column is already contiguous.
+template <typename T>
+void pack_a(Trans trans, int mc, int kc, const T *A, int lda, T *pack) {
+  constexpr int MR = Blocking<T>::MR;
+
+  for (int i = 0; i < mc; i += MR) {
+    int mr = std::min(MR, mc - i);
+    for (int p = 0; p < kc; p++) {
+      if (trans == Trans::No) {
+        for (int r = 0; r < mr; r++) {
+          pack[r] = A[(size_t)(i + r) * lda + p];
+        }
+      } else {
+        const T *pA = A + (size_t)p * lda + i;
+        for (int r = 0; r < mr; r++) {
+          pack[r] = pA[r];
+        }
+      }
+      for (int r = mr; r < MR; r++) {
+        pack[r] = (T)0;
+      }
+      pack += MR;
+    }
+  }
+}
+
+// Pack a kc x nc panel of op(B) into NR-column micro-panels. Inside every
+// panel the NR values of one row are contiguous, columns past nc are zero
+// padded. With Trans::Yes B is stored n-major and is gathered with stride ldb.
+template <typename T>
+void pack_b(Trans trans, int kc, int nc, const T *B, int ldb, T *pack) {
+  constexpr int NR = Blocking<T>::NR;
+
+  for (int j = 0; j < nc; j += NR) {
+    int nr = std::min(NR, nc - j);
+    for (int p = 0; p < kc; p++) {
+      if (trans == Trans::No) {
+        const T *pB = B + (size_t)p * ldb + j;
+        for (int c = 0; c < nr; c++) {
+          pack[c] = pB[c];
+        }
+      } else {
+        const T *pB = B + (size_t)j * ldb + p;
+        for (int c = 0; c < nr; c++) {
+          pack[c] = pB[(size_t)c * ldb];
+        }
+      }
+      for (int c = nr; c < NR; c++) {
+        pack[c] = (T)0;
+      }
+      pack += NR;
+    }
+  }
+}
+
+#if defined(__GNUC__)
+// Native vector registers through GCC/Clang vector extensions.
+template <typename T> struct Vec {
+  typedef T type __attribute__((vector_size(VECTOR_BYTES)));
+  static constexpr int LANES = VECTOR_BYTES / sizeof(T);
+};
+#endif
+
+// Register-tiled micro-kernel: C[mr x nr] = alpha * Ap * Bp + beta * C.
+// The accumulator has fixed MR x NR extents so it lives in vector registers
+// during the whole KC loop and is only spilled once to C. On the last K block
+// (`last`) the epilogue runs on the spilled rows, col is the first column of
+// the tile in C.
+template <typename T, typename Epilogue = NoEpilogue>
+inline void micro_kernel(int kc, const T *__restrict a, const T *__restrict b,
+                         T *C, int ldc, int mr, int nr, T alpha, T beta,
+                         const Epilogue &ep = Epilogue(), int col = 0,
+                         bool last = false) {
+  constexpr int MR = Blocking<T>::MR;
+  constexpr int NR = Blocking<T>::NR;
+
+  alignas(64) T acc[MR * NR];
+
+#if defined(__GNUC__)
+  if constexpr (NR % Vec<T>::LANES == 0) {
+    using V = typename Vec<T>::type;
+    constexpr int NV = NR / Vec<T>::LANES;
+
+    V c[MR][NV] = {};
+
+    for (int p = 0; p < kc; p++) {
+      V bv[NV];
+      for (int v = 0; v < NV; v++) {
+        std::memcpy(&bv[v], b + v * Vec<T>::LANES, sizeof(V));
+      }
+      for (int i = 0; i < MR; i++) {
+        for (int v = 0; v < NV; v++) {
+          c[i][v] += a[i] * bv[v];
+        }
+      }
+      a += MR;
+      b += NR;
+    }
+
+    for (int i = 0; i < MR; i++) {
+      for (int v = 0; v < NV; v++) {
+        std::memcpy(acc + i * NR + v * Vec<T>::LANES, &c[i][v], sizeof(V));
+      }
+    }
+  } else
+#endif
+  {
+    for (int i = 0; i < MR * NR; i++) {
+      acc[i] = (T)0;
+    }
+    for (int p = 0; p < kc; p++) {
+      for (int i = 0; i < MR; i++) {
+        T ai = a[i];
+        for (int j = 0; j < NR; j++) {
+          acc[i * NR + j] += ai * b[j];
+        }
+      }
+      a += MR;
+      b += NR;
+    }
+  }
+
+  // beta == 0 must not read C, it may hold uninitialized values
+  if constexpr (std::is_same_v<Epilogue, NoEpilogue>) {
+    for (int i = 0; i < mr; i++) {
+      T *pC = C + (size_t)i * ldc;
+      const T *pAcc = acc + i * NR;
+      if (beta == (T)0) {
+        for (int j = 0; j < nr; j++) {
+          pC[j] = alpha * pAcc[j];
+        }
+      } else {
+        for (int j = 0; j < nr; j++) {
+          pC[j] = alpha * pAcc[j] + beta * pC[j];
+        }
+      }
+    }
+  } else {
+    // Finish each row in the spill buffer, then store it once
+    for (int i = 0; i < mr; i++) {
+      T *pC = C + (size_t)i * ldc;
+      T *pAcc = acc + i * NR;
+      if (beta == (T)0) {
+        for (int j = 0; j < nr; j++) {
+          pAcc[j] = alpha * pAcc[j];
+        }
+      } else {
+        for (int j = 0; j < nr; j++) {
+          pAcc[j] = alpha * pAcc[j] + beta * pC[j];
+        }
+      }
+      if (last) {
+        ep(pAcc, col, nr);
+      }
+      std::copy(pAcc, pAcc + nr, pC);
+    }
+  }
+}
+
+// Reference kernel for tiny products (single samples, bias-sized matrices).
+// i-p-j order streams rows of B and C, so it is still cache friendly.
+template <typename T, typename Epilogue = NoEpilogue>
+void gemm_small(Trans transA, Trans transB, int M, int N, int K, T alpha,
+                const T *A, int lda, const T *B, int ldb, T beta, T *C,
+                int ldc, const Epilogue &ep = Epilogue()) {
+  for (int i = 0; i < M; i++) {
+    T *pC = C + (size_t)i * ldc;
+
+    if (beta == (T)0) {
+      std::fill(pC, pC + N, (T)0);
+    } else if (beta != (T)1) {
+      for (int j = 0; j < N; j++) {
+        pC[j] *= beta;
+      }
+    }
+
+    for (int p = 0; p < K; p++) {
+      T aip = alpha * ((transA == Trans::No) ? A[(size_t)i * lda + p]
+                                             : A[(size_t)p * lda + i]);
+      if (transB == Trans::No) {
+        const T *pB = B + (size_t)p * ldb;
+#pragma omp simd
+        for (int j = 0; j < N; j++) {
+          pC[j] += aip * pB[j];
+        }
+      } else {
+        for (int j = 0; j < N; j++) {
+          pC[j] += aip * B[(size_t)j * ldb + p];
+        }
+      }
+    }
+
+    if constexpr (!std::is_same_v<Epilogue, NoEpilogue>) {
+      ep(pC, 0, N);
+    }
+  }
+}
+
+} // namespace detail
+
+// C[M x N] = ep(alpha * op(A)[M x K] * op(B)[K x N] + beta * C[M x N])
+// All operands are row-major with leading dimensions lda, ldb and ldc; op(X)
+// is X or X^T depending on the Trans flag, transposes are never materialized.
+// The epilogue sees every element of C exactly once (see micro_kernel).
+template <typename T, typename Epilogue = NoEpilogue>
+void gemm(Trans transA, Trans transB, int M, int N, int K, T alpha, const T *A,
+          int lda, const T *B, int ldb, T beta, T *C, int ldc,
+          const Epilogue &ep = Epilogue()) {
+  using Blk = Blocking<T>;
+
+  if (M == 0 || N == 0) {
+    return;
+  }
+
+  if ((size_t)M * N * K <= SMALL_GEMM_THRESHOLD) {
+    detail::gemm_small(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta,
+                       C, ldc, ep);
+    return;
+  }
+
+  // Pack buffers are reused across calls, keep them out of any step arena
+  thread_local AlignedVector<T> packB;
+  {
+    Memory::PersistentScope persistent;
+    packB.resize((size_t)Blk::KC * (Blk::NC + Blk::NR));
+  }
+
+  for (int jc = 0; jc < N; jc += Blk::NC) {
+    int nc = std::min(Blk::NC, N - jc);
+
+    for (int pc = 0; pc < K; pc += Blk::KC) {
+      int kc = std::min(Blk::KC, K - pc);
+
+      // Only the first K block applies the caller's beta, later blocks
+      // accumulate on top of it.
+      T beta_k = (pc == 0) ? beta : (T)1;
+      bool last = pc + kc >= K;
+
+      const T *pB = (transB == Trans::No) ? B + (size_t)pc * ldb + jc
+                                          : B + (size_t)jc * ldb + pc;
+      detail::pack_b(transB, kc, nc, pB, ldb, packB.data());
+      const T *pBp = packB.data();
+
+      // Row panels of A are independent: one pool task per MC block. Each
+      // worker packs into its own thread_local buffer.
+      size_t blocks = (size_t)(M + Blk::MC - 1) / Blk::MC;
+      Utils::parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+        thread_local AlignedVector<T> packA;
+        {
+          Memory::PersistentScope persistent;
+          packA.resize((size_t)(Blk::MC + Blk::MR) * Blk::KC);
+        }
+
+        for (size_t blk = lo; blk < hi; blk++) {
+          int ic = (int)blk * Blk::MC;
+          int mc = std::min(Blk::MC, M - ic);
+
+          const T *pA = (transA == Trans::No) ? A + (size_t)ic * lda + pc
+                                              : A + (size_t)pc * lda + ic;
+          detail::pack_a(transA, mc, kc, pA, lda, packA.data());
+
+          for (int jr = 0; jr < nc; jr += Blk::NR) {
+            int nr = std::min(Blk::NR, nc - jr);
+
+            for (int ir = 0; ir < mc; ir += Blk::MR) {
+              int mr = std::min(Blk::MR, mc - ir);
+
+              detail::micro_kernel(kc, packA.data() + (size_t)ir * kc,
+                                   pBp + (size_t)jr * kc,
+                                   C + (size_t)(ic + ir) * ldc + jc + jr, ldc,
+                                   mr, nr, alpha, beta_k, ep, jc + jr, last);
+            }
+          }
+        }
+      });
+    }
+  }
+}
+
+/*******************************************************
+ * int8 GEMM with int32 accumulation
+ *******************************************************/
+
+// Register tile of the integer kernel: MR rows x NR int32 columns (two
+// vector registers per row)
+#if defined(__AVX512BW__)
+constexpr int S8_MR = 6;
+constexpr int S8_NR = 32;
+#elif defined(__AVX2__)
+constexpr int S8_MR = 4;
+constexpr int S8_NR = 16;
+#else
+constexpr int S8_MR = 4;
+constexpr int S8_NR = 8;
+#endif
+
+// int8 B[K x N] packed for gemm_s8. NR-column panels; inside a panel the
+// values of rows 2p and 2p+1 of a column are adjacent, which is the operand
+// layout of the 16-bit multiply-add (pmaddwd). K is padded to even with
+// zeros. The last panel keeps its real width (N % NR columns), so a small
+// head such as 10 classes takes 10 bytes per pair of rows, not NR.
+struct PackedS8 {
+  AlignedVector<int8_t> data;
+  int K = 0;
+  int N = 0;
+  int Kp = 0;
+
+  int panels() const { return (N + S8_NR - 1) / S8_NR; }
+  int width(int c) const { return std::min(S8_NR, N - c * S8_NR); }
+  size_t bytes() const { return data.size(); }
+  const int8_t *panel(int c) const {
+    return data.data() + (size_t)c * Kp * S8_NR;
+  }
+};
+
+inline PackedS8 pack_s8(int K, int N, const int8_t *B, int ldb) {
+  PackedS8 packed;
+  packed.K = K;
+  packed.N = N;
+  packed.Kp = (K + 1) & ~1;
+  packed.data.assign((size_t)packed.Kp * N, 0);
+
+  for (int c = 0; c < packed.panels(); c++) {
+    int8_t *dst = packed.data.data() + (size_t)c * packed.Kp * S8_NR;
+    int nr = packed.width(c);
+    for (int p = 0; p < K; p++) {
+      const int8_t *src = B + (size_t)p * ldb + c * S8_NR;
+      int8_t *row = dst + (size_t)(p / 2) * 2 * nr + (p & 1);
+      for (int j = 0; j < nr; j++) {
+        row[2 * j] = src[j];
+      }
+    }
+  }
+  return packed;
+}
+
+namespace detail {
+
+// Vector operations of the integer kernel: widen a run of packed int8 values
+// of B to int16 and multiply-add pairs of int16 into int32 lanes
+#if defined(__AVX512BW__)
+struct S8Vec {
+  using V = __m512i;
+  static V zero() { return _mm512_setzero_si512(); }
+  static V widen(const int8_t *b) {
+    return _mm512_cvtepi8_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b)));
+  }
+  static V pair(int32_t a) { return _mm512_set1_epi32(a); }
+  static V madd(V acc, V a, V b) {
+    return _mm512_add_epi32(acc, _mm512_madd_epi16(a, b));
+  }
+};
+#elif defined(__AVX2__)
+struct S8Vec {
+  using V = __m256i;
+  static V zero() { return _mm256_setzero_si256(); }
+  static V widen(const int8_t *b) {
+    return _mm256_cvtepi8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+  }
+  static V pair(int32_t a) { return _mm256_set1_epi32(a); }
+  static V madd(V acc, V a, V b) {
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+  }
+};
+#elif defined(__SSE2__)
+struct S8Vec {
+  using V = __m128i;
+  static V zero() { return _mm_setzero_si128(); }
+  static V widen(const int8_t *b) {
+    // Sign extension without SSE4.1: duplicate every byte, shift back
+    __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(b));
+    return _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+  }
+  static V pair(int32_t a) { return _mm_set1_epi32(a); }
+  static V madd(V acc, V a, V b) {
+    return _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+  }
+};
+#endif
+
+// C[R x nr] = A[R x Kp] * panel, A holds int8 values widened to int16
+template <int R>
+inline void micro_kernel_s8(int Kp, const int16_t *A, int lda,
+                            const int8_t *b, int32_t *C, int ldc, int nr) {
+  alignas(64) int32_t acc[R][S8_NR];
+
+#if defined(__AVX512BW__) || defined(__AVX2__) || defined(__SSE2__)
+  using V = S8Vec::V;
+  constexpr int LANES = (int)(sizeof(V) / sizeof(int32_t));
+  static_assert(2 * LANES == S8_NR, "two registers per row");
+
+  V c0[R], c1[R];
+  for (int r = 0; r < R; r++) {
+    c0[r] = S8Vec::zero();
+    c1[r] = S8Vec::zero();
+  }
+
+  for (int p = 0; p < Kp / 2; p++) {
+    V b0 = S8Vec::widen(b);
+    V b1 = S8Vec::widen(b + S8_NR);
+    for (int r = 0; r < R; r++) {
+      int32_t pair;
+      std::memcpy(&pair, A + (size_t)r * lda + 2 * p, sizeof(pair));
+      V a = S8Vec::pair(pair);
+      c0[r] = S8Vec::madd(c0[r], a, b0);
+      c1[r] = S8Vec::madd(c1[r], a, b1);
+    }
+    b += 2 * S8_NR;
+  }
+
+  for (int r = 0; r < R; r++) {
+    std::memcpy(acc[r], &c0[r], sizeof(V));
+    std::memcpy(acc[r] + LANES, &c1[r], sizeof(V));
+  }
+#else
+  for (int r = 0; r < R; r++) {
+    for (int j = 0; j < S8_NR; j++) {
+      acc[r][j] = 0;
+    }
+  }
+  for (int p = 0; p < Kp / 2; p++) {
+    for (int r = 0; r < R; r++) {
+      int32_t a0 = A[(size_t)r * lda + 2 * p];
+      int32_t a1 = A[(size_t)r * lda + 2 * p + 1];
+      for (int j = 0; j < S8_NR; j++) {
+        acc[r][j] += a0 * b[2 * j] + a1 * b[2 * j + 1];
+      }
+    }
+    b += 2 * S8_NR;
+  }
+#endif
+
+  for (int r = 0; r < R; r++) {
+    std::copy(acc[r], acc[r] + nr, C + (size_t)r * ldc);
+  }
+}
+
+// Same on the narrow last panel (nr < NR columns, packed at width nr)
+template <int R>
+inline void micro_kernel_s8_tail(int Kp, const int16_t *A, int lda,
+                                 const int8_t *b, int32_t *C, int ldc,
+                                 int nr) {
+  alignas(64) int32_t acc[R][S8_NR] = {};
+  for (int p = 0; p < Kp / 2; p++) {
+    for (int r = 0; r < R; r++) {
+      int32_t a0 = A[(size_t)r * lda + 2 * p];
+      int32_t a1 = A[(size_t)r * lda + 2 * p + 1];
+      for (int j = 0; j < nr; j++) {
+        acc[r][j] += a0 * b[2 * j] + a1 * b[2 * j + 1];
+      }
+    }
+    b += 2 * nr;
+  }
+
+  for (int r = 0; r < R; r++) {
+    std::copy(acc[r], acc[r] + nr, C + (size_t)r * ldc);
+  }
+}
+
+} // namespace detail
+
+// C[M x N] = A[M x K] * B[K x N] with int8 values and int32 accumulation
+// (no overflow for K < 2^17). A is row-major int16 holding values in
+// [-127, 127], with K padded to B.Kp; B is packed once with pack_s8.
+inline void gemm_s8(int M, const int16_t *A, int lda, const PackedS8 &B,
+                    int32_t *C, int ldc) {
+  size_t blocks = (size_t)(M + S8_MR - 1) / S8_MR;
+  size_t work = (size_t)S8_MR * B.Kp * B.N;
+
+  Utils::parallel_for(0, blocks, Utils::grain_for(work), [&](size_t lo,
+                                                             size_t hi) {
+    for (int c = 0; c < B.panels(); c++) {
+      const int8_t *panel = B.panel(c);
+      int nr = B.width(c);
+      auto kernel = nr == S8_NR ? detail::micro_kernel_s8<S8_MR>
+                                : detail::micro_kernel_s8_tail<S8_MR>;
+      auto kernel1 = nr == S8_NR ? detail::micro_kernel_s8<1>
+                                 : detail::micro_kernel_s8_tail<1>;
+
+      for (size_t blk = lo; blk < hi; blk++) {
+        int i = (int)blk * S8_MR;
+        const int16_t *a = A + (size_t)i * lda;
+        int32_t *pC = C + (size_t)i * ldc + c * S8_NR;
+
+        if (i + S8_MR <= M) {
+          kernel(B.Kp, a, lda, panel, pC, ldc, nr);
+        } else {
+          for (; i < M; i++, a += lda, pC += ldc) {
+            kernel1(B.Kp, a, lda, panel, pC, ldc, nr);
+          }
+        }
+      }
+    }
+  });
+}
+
+// C = alpha * A * B + beta * C, both operands in their stored layout.
+template <typename T>
+void gemm(int M, int N, int K, T alpha, const T *A, int lda, const T *B,
+          int ldb, T beta, T *C, int ldc) {
+  gemm(Trans::No, Trans::No, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+} // namespace Gemm
+} // namespace Math
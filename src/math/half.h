@@ -0,0 +1,308 @@
+#pragma once
+#include "arena.h"
+#include "matrix.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+/********************************************************************************
+ *
+ * 16-bit floating point storage: bfloat16 and IEEE binary16 (fp16)
+ *
+ * Values are only stored in 16 bits; every kernel widens them back to float
+ * (or double) before computing, so arithmetic keeps full precision:
+ *
+ *   HalfMatrix<float> packed;
+ *   packed.store(activations, StorageFormat::BF16);   // 2 bytes per value
+ *   Matrix<float> a = packed.load();                  // widened copy
+ *
+ *   bf16: 8 exponent bits, 7 mantissa bits. Same range as float, ~3 digits.
+ *   fp16: 5 exponent bits, 10 mantissa bits. Max 65504, ~3.3 digits.
+ *
+ * Narrowing rounds to nearest even; overflow gives inf, NaN stays NaN. The
+ * conversions are branch-free and vectorize; fp16 uses the F16C instructions
+ * when the CPU has them.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+enum class StorageFormat { FP32, BF16, FP16 };
+
+inline const char *format_name(StorageFormat format) {
+  switch (format) {
+  case StorageFormat::BF16:
+    return "bf16";
+  case StorageFormat::FP16:
+    return "fp16";
+  default:
+    return "fp32";
+  }
+}
+
+namespace Half {
+
+namespace detail {
+inline uint32_t bits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float from_bits(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+} // namespace detail
+
+/*******************************************************
+ * Scalar conversions
+ *******************************************************/
+
+inline uint16_t bf16_from_float(float f) {
+  uint32_t u = detail::bits(f);
+  // Round to nearest even on the 16 dropped bits; NaN keeps a mantissa bit
+  uint32_t rounded = (u + 0x7FFFu + ((u >> 16) & 1u)) >> 16;
+  uint32_t quiet = (u >> 16) | 0x40u;
+  bool nan = (u & 0x7FFFFFFFu) > 0x7F800000u;
+  return (uint16_t)(nan ? quiet : rounded);
+}
+
+inline float bf16_to_float(uint16_t h) {
+  return detail::from_bits((uint32_t)h << 16);
+}
+
+inline uint16_t fp16_from_float(float f) {
+  const uint32_t F32_INF = 255u << 23;
+  const uint32_t F16_MAX = (127u + 16u) << 23; // first value that overflows
+  const uint32_t DENORM_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  uint32_t u = detail::bits(f);
+  uint32_t sign = u & 0x80000000u;
+  u ^= sign;
+
+  // Subnormal results: let the float adder align and round the mantissa
+  uint32_t sub = detail::bits(detail::from_bits(u) +
+                              detail::from_bits(DENORM_MAGIC)) -
+                 DENORM_MAGIC;
+  // Normal results: rebias the exponent and round to nearest even
+  uint32_t norm = (u + ((uint32_t)(15 - 127) << 23) + 0xFFFu +
+                   ((u >> 13) & 1u)) >>
+                  13;
+  uint32_t special = u > F32_INF ? 0x7E00u : 0x7C00u;
+
+  uint32_t h = u >= F16_MAX ? special : (u < (113u << 23) ? sub : norm);
+  return (uint16_t)(h | (sign >> 16));
+}
+
+inline float fp16_to_float(uint16_t h) {
+  const uint32_t SHIFTED_EXP = 0x7C00u << 13;
+  const float MAGIC = detail::from_bits(113u << 23);
+
+  uint32_t u = ((uint32_t)h & 0x7FFFu) << 13;
+  uint32_t exp = u & SHIFTED_EXP;
+  u += (uint32_t)(127 - 15) << 23;
+
+  uint32_t inf_nan = u + ((uint32_t)(128 - 16) << 23);
+  uint32_t denorm = detail::bits(detail::from_bits(u + (1u << 23)) - MAGIC);
+
+  u = exp == SHIFTED_EXP ? inf_nan : (exp == 0 ? denorm : u);
+  return detail::from_bits(u | (((uint32_t)h & 0x8000u) << 16));
+}
+
+inline uint16_t from_float(StorageFormat format, float f) {
+  return format == StorageFormat::FP16 ? fp16_from_float(f)
+                                       : bf16_from_float(f);
+}
+
+inline float to_float(StorageFormat format, uint16_t h) {
+  return format == StorageFormat::FP16 ? fp16_to_float(h) : bf16_to_float(h);
+}
+
+// Value after a round trip through the 16-bit format
+template <typename T> T round(StorageFormat format, T v) {
+  if (format == StorageFormat::FP32) {
+    return v;
+  }
+  return (T)to_float(format, from_float(format, (float)v));
+}
+
+/*******************************************************
+ * Array conversions
+ *******************************************************/
+
+namespace scalar {
+template <typename T>
+void narrow(StorageFormat format, const T *src, uint16_t *dst, size_t n) {
+  if (format == StorageFormat::FP16) {
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = fp16_from_float((float)src[i]);
+    }
+  } else {
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = bf16_from_float((float)src[i]);
+    }
+  }
+}
+
+template <typename T>
+void widen(StorageFormat format, const uint16_t *src, T *dst, size_t n) {
+  if (format == StorageFormat::FP16) {
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = (T)fp16_to_float(src[i]);
+    }
+  } else {
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = (T)bf16_to_float(src[i]);
+    }
+  }
+}
+} // namespace scalar
+
+#if BRAINSIM_SIMD_X86
+namespace f16c {
+inline bool available() {
+  static bool has = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+  }();
+  return has;
+}
+
+__attribute__((target("avx,f16c"))) inline void
+narrow(const float *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+  }
+  for (; i < n; i++) {
+    dst[i] = fp16_from_float(src[i]);
+  }
+}
+
+__attribute__((target("avx,f16c"))) inline void
+widen(const uint16_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  for (; i < n; i++) {
+    dst[i] = fp16_to_float(src[i]);
+  }
+}
+} // namespace f16c
+#endif // BRAINSIM_SIMD_X86
+
+// dst[i] = 16-bit encoding of src[i]
+template <typename T>
+void narrow(StorageFormat format, const T *src, uint16_t *dst, size_t n) {
+#if BRAINSIM_SIMD_X86
+  if constexpr (std::is_same_v<T, float>) {
+    if (format == StorageFormat::FP16 && f16c::available()) {
+      return f16c::narrow(src, dst, n);
+    }
+  }
+#endif
+  scalar::narrow(format, src, dst, n);
+}
+
+// dst[i] = value encoded in src[i]
+template <typename T>
+void widen(StorageFormat format, const uint16_t *src, T *dst, size_t n) {
+#if BRAINSIM_SIMD_X86
+  if constexpr (std::is_same_v<T, float>) {
+    if (format == StorageFormat::FP16 && f16c::available()) {
+      return f16c::widen(src, dst, n);
+    }
+  }
+#endif
+  scalar::widen(format, src, dst, n);
+}
+
+// dst = src rounded to the 16-bit format, kept in full precision storage
+template <typename T>
+void round_into(StorageFormat format, const Matrix<T> &src, Matrix<T> &dst) {
+  assert_shape(src.shape(), dst.shape(), "Half::round_into");
+  const T *s = src.data_ptr();
+  T *d = dst.data_ptr();
+  if (format == StorageFormat::FP32) {
+    std::copy(s, s + src.size(), d);
+    return;
+  }
+
+  // Through a small stack buffer, so no allocation per call
+  constexpr size_t CHUNK = 1024;
+  uint16_t packed[CHUNK];
+  for (size_t i = 0; i < src.size(); i += CHUNK) {
+    size_t len = std::min(CHUNK, src.size() - i);
+    narrow(format, s + i, packed, len);
+    widen(format, packed, d + i, len);
+  }
+}
+
+} // namespace Half
+
+/********************************************************************************
+ *
+ * HalfMatrix: the values of a Matrix<T> kept in bf16 or fp16
+ *
+ * Used for caches that live between the forward and the backward pass. The
+ * buffer is heap storage (it outlives the step arena) and is reused between
+ * calls; load() widens into a new Matrix<T> from the active allocator.
+ *
+ ********************************************************************************/
+
+template <typename T> class HalfMatrix {
+public:
+  HalfMatrix() = default;
+
+  void store(const Matrix<T> &value, StorageFormat format) {
+    if (format == StorageFormat::FP32) {
+      throw std::invalid_argument("HalfMatrix::store: format must be 16-bit");
+    }
+    {
+      Memory::PersistentScope persistent;
+      bits_.resize(value.size());
+    }
+    Half::narrow(format, value.data_ptr(), bits_.data(), value.size());
+    shape_ = value.shape();
+    format_ = format;
+  }
+
+  Matrix<T> load() const {
+    AlignedVector<T> values(bits_.size());
+    Half::widen(format_, bits_.data(), values.data(), bits_.size());
+    return Matrix<T>(std::move(values), shape_);
+  }
+
+  void clear() {
+    bits_.clear();
+    shape_ = Shape();
+  }
+
+  bool empty() const { return bits_.empty(); }
+  const Shape &shape() const { return shape_; }
+  StorageFormat format() const { return format_; }
+  size_t size() const { return bits_.size(); }
+  size_t bytes() const { return bits_.size() * sizeof(uint16_t); }
+  const uint16_t *data_ptr() const { return bits_.data(); }
+
+private:
+  AlignedVector<uint16_t> bits_;
+  Shape shape_;
+  StorageFormat format_{StorageFormat::BF16};
+};
+
+} // namespace Math
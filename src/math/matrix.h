@@ -1,6 +1,12 @@
 #pragma once
 #include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "aligned_allocator.h"
+#include "matrix_expr.h"
+#include "matrix_view.h"
+#include "shape.h"
 #include <cstddef>
+#include <initializer_list>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -13,113 +19,110 @@ template <typename T> class Matrix;
 template <typename T>
 std::ostream &operator<<(std::ostream &os, const Matrix<T> &matrix);
 
-template <typename T>
-Matrix<T> operator+(const Matrix<T> &left, const Matrix<T> &right);
-
+// Broadcast a std::vector over the rows of a Matrix (eager). Element-wise
+// operators between matrices, expressions and scalars are lazy, see
+// matrix_expr.h
 template <typename T>
 Matrix<T> operator+(const Matrix<T> &left, const std::vector<T> &vector);
 
 template <typename T>
 Matrix<T> operator+(const std::vector<T> &vector, const Matrix<T> &left);
 
-template <typename T>
-Matrix<T> operator+(const T &scalar, const Matrix<T> &matrix);
-
-template <typename T>
-Matrix<T> operator+(const Matrix<T> &matrix, const T &scalar);
-
-template <typename T>
-Matrix<T> operator-(const Matrix<T> &left, const Matrix<T> &right);
-
-template <typename T>
-Matrix<T> operator-(const T &scalar, const Matrix<T> &matrix);
-
-template <typename T>
-Matrix<T> operator-(const Matrix<T> &matrix, const T &scalar);
-
-template <typename T>
-Matrix<T> operator*(const T &scalar, const Matrix<T> &matrix);
-
-template <typename T>
-Matrix<T> operator*(const Matrix<T> &right, const T &scalar);
-
-template <typename T>
-Matrix<T> operator*(const Matrix<T> &left, const Matrix<T> &right);
-
-template <typename T>
-Matrix<T> operator/(const T &scalar, const Matrix<T> &matrix);
-
-template <typename T>
-Matrix<T> operator/(const Matrix<T> &right, const T &scalar);
-
-template <typename T>
-Matrix<T> operator/(const Matrix<T> &left, const Matrix<T> &right);
-
 // Class Matrix implementation
 
-template <typename T> class Matrix {
+template <typename T> class Matrix : public Expr::MatExpr<Matrix<T>> {
 
 public:
-  Matrix(std::vector<T> vectorIn, const std::vector<int> &shapeIn);
-  Matrix(const std::vector<std::vector<T>> &matrix,
-         const std::vector<int> &shapeIn);
+  using value_type = T;
+
+  Matrix();
+  Matrix(AlignedVector<T> vectorIn, const Shape &shapeIn);
+  Matrix(const std::vector<T> &vectorIn, const Shape &shapeIn);
+  Matrix(std::initializer_list<T> values, const Shape &shapeIn);
+  Matrix(const std::vector<std::vector<T>> &matrix, const Shape &shapeIn);
   Matrix(const Matrix<T> &other);
   Matrix(Matrix<T> &&other) noexcept;
+  template <typename E> Matrix(const Expr::MatExpr<E> &expr);
   friend std::ostream &operator<< <>(std::ostream &os, const Matrix<T> &matrix);
-  friend Matrix<T> operator+ <>(const Matrix<T> &left, const Matrix<T> &right);
-  friend Matrix<T> operator+
-      <>(const Matrix<T> &left, const std::vector<T> &bias);
-  friend Matrix<T> operator+
-      <>(const std::vector<T> &bias, const Matrix<T> &left);
-  friend Matrix<T> operator+ <>(const T &scalar, const Matrix<T> &matrix);
-  friend Matrix<T> operator+ <>(const Matrix<T> &matrix, const T &scalar);
-  friend Matrix<T> operator- <>(const Matrix<T> &left, const Matrix<T> &right);
-  friend Matrix<T> operator- <>(const T &scalar, const Matrix<T> &matrix);
-  friend Matrix<T> operator- <>(const Matrix<T> &matrix, const T &scalar);
-  friend Matrix<T> operator* <>(const T &scalar, const Matrix<T> &matrix);
-  friend Matrix<T> operator* <>(const Matrix<T> &right, const T &scalar);
-  friend Matrix<T> operator* <>(const Matrix<T> &left, const Matrix<T> &right);
-  friend Matrix<T> operator/ <>(const T &scalar, const Matrix<T> &matrix);
-  friend Matrix<T> operator/ <>(const Matrix<T> &right, const T &scalar);
-  friend Matrix<T> operator/ <>(const Matrix<T> &left, const Matrix<T> &right);
   Matrix<T> &operator=(Matrix<T> &&other) noexcept;
   Matrix<T> &operator=(const Matrix<T> &other);
+  template <typename E> Matrix<T> &operator=(const Expr::MatExpr<E> &expr);
+
+  // In-place arithmetic, the right-hand side must broadcast to this shape
+  template <typename E> Matrix<T> &operator+=(const Expr::MatExpr<E> &expr);
+  template <typename E> Matrix<T> &operator-=(const Expr::MatExpr<E> &expr);
+  template <typename E> Matrix<T> &operator*=(const Expr::MatExpr<E> &expr);
+  template <typename E> Matrix<T> &operator/=(const Expr::MatExpr<E> &expr);
+  Matrix<T> &operator+=(const T &scalar);
+  Matrix<T> &operator-=(const T &scalar);
+  Matrix<T> &operator*=(const T &scalar);
+  Matrix<T> &operator/=(const T &scalar);
 
   const size_t &size() const;
-  const std::vector<int> &shape() const;
-  const std::vector<T> &data() const;
+  const Shape &shape() const;
+  const AlignedVector<T> &data() const;
   const T *data_ptr() const;
+  T *data_ptr();
+  Matrix<T> &resize(int rows, int cols);
   Matrix<T> &reshape(const std::vector<int> &new_shape);
   Matrix<T> &view(std::vector<int> new_shape);
   T at(size_t row, size_t col);
   Matrix<T> atRow(size_t row) const;
   Matrix<T> atCol(size_t col) const;
 
+  // Zero-copy slices (see matrix_view.h). Not available on temporaries, the
+  // view would outlive its data.
+  MatrixView<T> viewRows(size_t begin, size_t end) const &;
+  MatrixView<T> viewRow(size_t row) const &;
+  MatrixView<T> viewCol(size_t col) const &;
+  MatrixView<T> viewRows(size_t begin, size_t end) const && = delete;
+  MatrixView<T> viewRow(size_t row) const && = delete;
+  MatrixView<T> viewCol(size_t col) const && = delete;
+
 private:
-  std::vector<T> _data;
-  std::vector<int> _shape;
+  AlignedVector<T> _data;
+  Shape _shape;
   size_t _size{};
 
-  size_t _getSize(const std::vector<int> &shapeIn);
-  std::vector<T> _squeezeMatrix(const std::vector<std::vector<T>> &matrix);
+  size_t _getSize(const Shape &shapeIn);
+  AlignedVector<T> _squeezeMatrix(const std::vector<std::vector<T>> &matrix);
   void print_recursive(std::ostream &os, size_t dim_index, size_t &offset,
                        size_t indent_level) const;
+  template <typename E> Matrix<T> &_update(const Expr::MatExpr<E> &expr);
 };
 
 // **************************************
 // Constructors
 // **************************************
+
+// Empty 0 x 0 matrix, used for destination buffers filled later
+template <typename T> Matrix<T>::Matrix() : _shape(0, 0), _size(0) {}
+
+// Take ownership of an already aligned buffer (no copy)
 template <typename T>
-Matrix<T>::Matrix(std::vector<T> vectorIn, const std::vector<int> &shapeIn)
+Matrix<T>::Matrix(AlignedVector<T> vectorIn, const Shape &shapeIn)
     : _data(std::move(vectorIn)), _shape(shapeIn), _size(_getSize(shapeIn)) {
-  assert_eq(_shape.size(), (size_t)2, "Matrix::Const::Dimension mismatch");
   assert_eq(_size, _data.size(), "Matrix::Const::ValueError.");
 }
+
+// Copy a std::vector into aligned storage
+template <typename T>
+Matrix<T>::Matrix(const std::vector<T> &vectorIn, const Shape &shapeIn)
+    : _data(vectorIn.begin(), vectorIn.end()), _shape(shapeIn),
+      _size(_getSize(shapeIn)) {
+  assert_eq(_size, _data.size(), "Matrix::Const::ValueError.");
+}
+
+template <typename T>
+Matrix<T>::Matrix(std::initializer_list<T> values, const Shape &shapeIn)
+    : _data(values), _shape(shapeIn), _size(_getSize(shapeIn)) {
+  assert_eq(_size, _data.size(), "Matrix::Const::ValueError.");
+}
+
 template <typename T>
 Matrix<T>::Matrix(const std::vector<std::vector<T>> &matrix,
-                  const std::vector<int> &shapeIn)
+                  const Shape &shapeIn)
     : _data(_squeezeMatrix(matrix)), _shape(shapeIn), _size(_getSize(shapeIn)) {
-  assert_eq(_shape.size(), (size_t)2, "Matrix::Const::Dimension mismatch");
   assert_eq(_size, _data.size(), "Matrix::Const::ValueError.");
 }
 
@@ -129,15 +132,25 @@ Matrix<T>::Matrix(const Matrix<T> &other)
 
 template <typename T>
 Matrix<T>::Matrix(Matrix<T> &&other) noexcept
-    : _data(std::move(other._data)), _shape(std::move(other._shape)),
-      _size(other._size) {
+    : _data(std::move(other._data)), _shape(other._shape), _size(other._size) {
+  other._shape = Shape(0, 0);
   other._size = 0;
 }
+
+// Evaluate a lazy expression (see matrix_expr.h) in a single pass
+template <typename T>
+template <typename E>
+Matrix<T>::Matrix(const Expr::MatExpr<E> &expr)
+    : _shape(expr.self().rows(), expr.self().cols()) {
+  _size = (size_t)_shape[0] * (size_t)_shape[1];
+  _data.resize(_size);
+  Expr::assign(_data.data(), expr.self());
+}
 // ***************************************************************
 // Utils Methods
 // ***************************************************************
 template <typename T>
-size_t Matrix<T>::_getSize(const std::vector<int> &shapeIn) {
+size_t Matrix<T>::_getSize(const Shape &shapeIn) {
   size_t sizeInt{1};
   for (const auto &element : shapeIn) {
     assert_lineq(element, 0, "Matrix: shape dimensions cannot be negative.");
@@ -147,10 +160,10 @@ size_t Matrix<T>::_getSize(const std::vector<int> &shapeIn) {
 }
 
 template <typename T>
-std::vector<T>
+AlignedVector<T>
 Matrix<T>::_squeezeMatrix(const std::vector<std::vector<T>> &matrix) {
 
-  std::vector<T> output;
+  AlignedVector<T> output;
 
   size_t totalElements = 0;
   for (const auto &row : matrix)
@@ -165,9 +178,6 @@ Matrix<T>::_squeezeMatrix(const std::vector<std::vector<T>> &matrix) {
 template <typename T>
 void Matrix<T>::print_recursive(std::ostream &os, size_t dim_index,
                                 size_t &offset, size_t indent_level) const {
-  if (shape().empty())
-    return;
-
   int current_dim_size = shape()[dim_index];
   bool is_last_dim = (dim_index == shape().size() - 1);
 
@@ -226,15 +236,16 @@ std::ostream &operator<<(std::ostream &os, const Matrix<T> &matrix) {
  *******************************************************************************/
 
 template <typename T> const size_t &Matrix<T>::size() const { return _size; }
-template <typename T> const std::vector<int> &Matrix<T>::shape() const {
+template <typename T> const Shape &Matrix<T>::shape() const {
   return _shape;
 }
-template <typename T> const std::vector<T> &Matrix<T>::data() const {
+template <typename T> const AlignedVector<T> &Matrix<T>::data() const {
   return _data;
 }
 template <typename T> const T *Matrix<T>::data_ptr() const {
   return _data.data();
 }
+template <typename T> T *Matrix<T>::data_ptr() { return _data.data(); }
 
 /*****************************************************
  *
@@ -246,8 +257,9 @@ template <typename T>
 Matrix<T> &Matrix<T>::operator=(Matrix<T> &&other) noexcept {
   if (this != &other) {
     _data = std::move(other._data);
-    _shape = std::move(other._shape);
+    _shape = other._shape;
     _size = other._size;
+    other._shape = Shape(0, 0);
     other._size = 0;
   }
   return *this;
@@ -265,243 +277,117 @@ template <typename T> Matrix<T> &Matrix<T>::operator=(const Matrix<T> &other) {
   return *this;
 }
 
+// Assign an expression. When the shape is unchanged the result is written in
+// place: every element reads only its own position of this matrix, unless a
+// broadcast operand views this matrix, which goes through a temporary.
 template <typename T>
-Matrix<T> operator+(const Matrix<T> &left, const Matrix<T> &right) {
-
-  if (left.shape() == right.shape()) { // Shall do Matrix sum?
-
-    size_t size{left.size()};
-    std::vector<T> sum(size);
+template <typename E>
+Matrix<T> &Matrix<T>::operator=(const Expr::MatExpr<E> &expr) {
+  const E &e = expr.self();
 
-    const T *pLeft = left.data_ptr();
-    const T *pRight = right.data_ptr();
-    T *pSum = sum.data();
-
-#pragma omp simd
-    for (size_t i = 0; i < size; i++) {
-      pSum[i] = pLeft[i] + pRight[i];
-    }
-
-    return {sum, left.shape()};
+  if (_shape[0] == e.rows() && _shape[1] == e.cols() &&
+      !Expr::broadcast_alias(e, *this, e.rows(), e.cols())) {
+    Expr::assign(_data.data(), e);
+  } else {
+    *this = Matrix<T>(expr);
   }
 
-  // If not we shall do Broadcasting Sum
-  else if (right.shape()[0] == 1 && right.shape()[1] == left.shape()[1]) {
-
-    return left + right.data();
-  } else if (left.shape()[0] == 1 && left.shape()[1] == right.shape()[1]) {
-    return right + left.data();
-  }
-  // Else throw an error
-  else {
-    throw std::invalid_argument("Dimension mismatch: Shapes are incompatible "
-                                "for Element-wise or Broadcast sum.");
-  }
+  return *this;
 }
 
+// Evaluate an expression into this matrix without changing its shape
 template <typename T>
-Matrix<T> operator+(const Matrix<T> &matrix, const std::vector<T> &bias) {
-
-  assert_eq(bias.size(), (size_t)matrix.shape()[1], "BroadcastAdd::ValueError");
-
-  std::vector<T> output = matrix.data();
-
-  T *pOut = output.data();
-  const T *pBias = bias.data();
+template <typename E>
+Matrix<T> &Matrix<T>::_update(const Expr::MatExpr<E> &expr) {
+  const E &e = expr.self();
 
-  int rows = matrix.shape()[0];
-  int cols = matrix.shape()[1];
-
-#pragma omp parallel for collapse(2)
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-
-      int idx = i * cols + j;
-
-      pOut[idx] += pBias[j];
-    }
+  if (_shape[0] != e.rows() || _shape[1] != e.cols()) {
+    throw std::invalid_argument(
+        "Matrix::CompoundAssign::Shape mismatch: " + shape_to_string(_shape) +
+        " != " + shape_to_string(Shape(e.rows(), e.cols())));
   }
-
-  return {output, matrix.shape()};
-}
-
-template <typename T>
-Matrix<T> operator+(const std::vector<T> &bias, const Matrix<T> &left) {
-  return left + bias;
-}
-
-template <typename T>
-Matrix<T> operator+(const Matrix<T> &matrix, const T &scalar) {
-
-  std::vector<T> output = matrix.data();
-  T *pOut = output.data();
-
-  size_t size = matrix.size();
-
-#pragma omp simd
-  for (size_t i = 0; i < size; i++) {
-    pOut[i] += scalar;
+  if (Expr::broadcast_alias(e, *this, e.rows(), e.cols())) {
+    *this = Matrix<T>(expr);
+    return *this;
   }
+  Expr::assign(_data.data(), e);
 
-  return {output, matrix.shape()};
+  return *this;
 }
 
 template <typename T>
-Matrix<T> operator+(const T &scalar, const Matrix<T> &matrix) {
-  return matrix + scalar;
+template <typename E>
+Matrix<T> &Matrix<T>::operator+=(const Expr::MatExpr<E> &expr) {
+  return _update(*this + expr.self());
 }
 
 template <typename T>
-Matrix<T> operator-(const Matrix<T> &matrix, const T &scalar) {
-
-  std::vector<T> output = matrix.data();
-  T *pOut = output.data();
-
-  size_t size = matrix.size();
-
-#pragma omp simd
-  for (size_t i = 0; i < size; i++) {
-    pOut[i] -= scalar;
-  }
-
-  return {output, matrix.shape()};
+template <typename E>
+Matrix<T> &Matrix<T>::operator-=(const Expr::MatExpr<E> &expr) {
+  return _update(*this - expr.self());
 }
 
 template <typename T>
-Matrix<T> operator-(const T &scalar, const Matrix<T> &matrix) {
-  return matrix - scalar;
+template <typename E>
+Matrix<T> &Matrix<T>::operator*=(const Expr::MatExpr<E> &expr) {
+  return _update(*this * expr.self());
 }
 
 template <typename T>
-Matrix<T> operator-(const Matrix<T> &left, const Matrix<T> &right) {
-  assert_eq(left.shape().size(), right.shape().size(),
-            "Matrix::Operation::Dimension mismatch");
-  assert_shape(left.shape(), right.shape(),
-               "Matrix::Operation::Dimension mismatch");
-
-  size_t size{left.size()};
-  std::vector<T> diff(size);
-
-  const T *pLeft = left.data().data();
-  const T *pRight = right.data().data();
-  T *pDiff = diff.data();
-
-#pragma omp simd
-  for (size_t i = 0; i < size; i++) {
-    pDiff[i] = pLeft[i] - pRight[i];
-  }
-
-  return {diff, left.shape()};
+template <typename E>
+Matrix<T> &Matrix<T>::operator/=(const Expr::MatExpr<E> &expr) {
+  return _update(*this / expr.self());
 }
 
-template <typename T>
-Matrix<T> operator*(const T &scalar, const Matrix<T> &right) {
-
-  size_t size{right.size()};
-  std::vector<T> output(size);
-
-  const T *pRight = right.data().data();
-  T *pOut = output.data();
-
-#pragma omp simd
-  for (size_t i = 0; i < size; i++) {
-    pOut[i] = scalar * pRight[i];
-  }
-
-  return {output, right.shape()};
+template <typename T> Matrix<T> &Matrix<T>::operator+=(const T &scalar) {
+  return _update(*this + scalar);
 }
 
-template <typename T>
-Matrix<T> operator*(const Matrix<T> &right, const T &scalar) {
-  return scalar * right;
+template <typename T> Matrix<T> &Matrix<T>::operator-=(const T &scalar) {
+  return _update(*this - scalar);
 }
 
-// Element-wise Matrix multiplication.
-template <typename T>
-Matrix<T> operator*(const Matrix<T> &left, const Matrix<T> &right) {
-
-  assert_shape(left.shape(), right.shape(),
-               "Matrix::ElementWiseMult::Shapes must match exactly.");
-
-  std::vector<T> out(left.size());
-  T *pOut = out.data();
-  const T *pLeft = left.data_ptr();
-  const T *pRight = right.data_ptr();
-
-#pragma omp simd
-  for (size_t i = 0; i < left.size(); i++) {
-    pOut[i] = pLeft[i] * pRight[i];
-  }
-
-  return {out, left.shape()};
+template <typename T> Matrix<T> &Matrix<T>::operator*=(const T &scalar) {
+  return _update(*this * scalar);
 }
 
-template <typename T>
-Matrix<T> operator/(const Matrix<T> &matrix, const T &scalar) {
-
-  assert_ineq(scalar, (T)0, "Matrix::Zero division");
-
-  std::vector<T> output = matrix.data();
-  T *pOut = output.data();
-
-  size_t size = matrix.size();
-  T reciprocal = (T)1.0 / scalar;
-
-#pragma omp simd
-  for (size_t i = 0; i < size; i++) {
-    pOut[i] *= reciprocal;
-  }
-
-  return {output, matrix.shape()};
+template <typename T> Matrix<T> &Matrix<T>::operator/=(const T &scalar) {
+  return _update(*this / scalar);
 }
 
+// Adds `bias` to every row. The vector is read in place as a 1 x N row, so
+// the result is written in a single pass.
 template <typename T>
-Matrix<T> operator/(const T &scalar, const Matrix<T> &matrix) {
-
-  std::vector<T> output = matrix.data();
-  T *pOut = output.data();
-
-  size_t size = matrix.size();
-
-  for (size_t i = 0; i < size; i++) {
-
-    assert_ineq(pOut[i], (T)0, "Matrix::Operation::ValueError::Zero Division");
-
-    pOut[i] = scalar / pOut[i];
-  }
-
-  return {output, matrix.shape()};
+Matrix<T> operator+(const Matrix<T> &matrix, const std::vector<T> &bias) {
+  assert_eq(bias.size(), (size_t)matrix.shape()[1], "BroadcastAdd::ValueError");
+  return matrix + MatrixView<T>(bias.data(), 1, (int)bias.size(), bias.size());
 }
 
-// Element-wise division
 template <typename T>
-Matrix<T> operator/(const Matrix<T> &left, const Matrix<T> &right) {
-
-  assert_shape(left.shape(), right.shape(),
-               "Matrix::Division::ValueError::Dimensions mismatch");
-
-  std::vector<T> output = left.data();
-  T *pOut = output.data();
-  const T *pRight = right.data_ptr();
-
-  size_t size = left.size();
-
-  for (size_t i = 0; i < size; i++) {
-
-    assert_ineq(pRight[i], (T)0,
-                "Matrix::Operation::ValueError::Zero Division");
-
-    pOut[i] /= pRight[i];
-  }
-
-  return {output, left.shape()};
+Matrix<T> operator+(const std::vector<T> &bias, const Matrix<T> &left) {
+  return left + bias;
 }
+
 /********************************************************************************
  *
  * LinAlg Methods
  *
  *********************************************************************************/
 
+// Turn this into a rows x cols matrix. The current buffer is reused when it
+// is large enough, so destination buffers stop allocating once warmed up.
+// Contents are unspecified after a size change.
+template <typename T> Matrix<T> &Matrix<T>::resize(int rows, int cols) {
+  assert_lineq(rows, 0, "Matrix::Resize::Dimensions can't be negative.");
+  assert_lineq(cols, 0, "Matrix::Resize::Dimensions can't be negative.");
+
+  _size = (size_t)rows * (size_t)cols;
+  _data.resize(_size);
+  _shape = Shape(rows, cols);
+
+  return *this;
+}
+
 template <typename T>
 Matrix<T> &Matrix<T>::reshape(const std::vector<int> &new_shape) {
   size_t new_total_size = 1;
@@ -552,36 +438,29 @@ template <typename T> T Math::Matrix<T>::at(size_t row, size_t col) {
   return _data[row * ncols + col];
 }
 
-// Get a requested row
+// Get a requested row (copy)
 template <typename T> Matrix<T> Matrix<T>::atRow(size_t row) const {
-  size_t nrows = (size_t)_shape[0];
-  size_t ncols = (size_t)_shape[1];
-
-  Math::assert_lt(row, nrows, "Matrix::atRow");
-
-  size_t start_idx = row * ncols;
-  size_t end_idx = start_idx + ncols;
-
-  std::vector<T> row_data(_data.begin() + start_idx, _data.begin() + end_idx);
-
-  return Matrix<T>(std::move(row_data), {1, (int)ncols});
+  Math::assert_lt(row, (size_t)_shape[0], "Matrix::atRow");
+  return Matrix<T>(viewRow(row));
 }
 
-// Get a requested col
+// Get a requested col (copy)
 template <typename T> Matrix<T> Matrix<T>::atCol(size_t col) const {
-  size_t nrows = (size_t)_shape[0];
-  size_t ncols = (size_t)_shape[1];
-
-  Math::assert_lt(col, ncols, "Matrix::atCol");
+  Math::assert_lt(col, (size_t)_shape[1], "Matrix::atCol");
+  return Matrix<T>(viewCol(col));
+}
 
-  std::vector<T> col_data;
-  col_data.reserve(nrows);
+template <typename T>
+MatrixView<T> Matrix<T>::viewRows(size_t begin, size_t end) const & {
+  return MatrixView<T>(*this).viewRows(begin, end);
+}
 
-  for (size_t i = 0; i < nrows; ++i) {
-    col_data.push_back(_data[i * ncols + col]);
-  }
+template <typename T> MatrixView<T> Matrix<T>::viewRow(size_t row) const & {
+  return MatrixView<T>(*this).viewRow(row);
+}
 
-  return Matrix<T>(std::move(col_data), {(int)nrows, 1});
+template <typename T> MatrixView<T> Matrix<T>::viewCol(size_t col) const & {
+  return MatrixView<T>(*this).viewCol(col);
 }
 
 } // namespace Math
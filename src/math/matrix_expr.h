@@ -0,0 +1,605 @@
+#pragma once
+#include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "simd.h"
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/********************************************************************************
+ *
+ * Expression templates for element-wise Matrix arithmetic.
+ *
+ * Operators on matrices (and on other expressions) return lightweight nodes
+ * instead of new matrices. Nothing is computed until the expression is
+ * assigned to a Matrix, which evaluates the whole tree in one loop:
+ *
+ *   W = W - (m_hat / (sqrt(v_hat) + eps)) * lr;   // single pass, no temporaries
+ *
+ * Shapes are checked when the node is built, so errors are still reported at
+ * the operator call. Lvalue matrices are captured by reference and rvalue
+ * matrices are moved into the node, so `auto e = f(x) + 1.0;` never dangles.
+ *
+ * Every binary operator broadcasts with the NumPy rule: on each axis the sizes
+ * must match or one of them must be 1. A leaf reads a size-1 axis with stride
+ * 0, so the expanded operand is never materialized:
+ *
+ *   Y = (X - mean) / std * gamma + beta;   // 1 x N statistics, one pass
+ *   P = E / rowSums;                       // M x 1 column
+ *   D = col - row;                         // M x 1 (op) 1 x N -> M x N
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+template <typename T> class Matrix;
+template <typename T> class MatrixView;
+
+namespace Expr {
+
+// CRTP base shared by Matrix and every expression node
+template <typename E> struct MatExpr {
+  const E &self() const { return static_cast<const E &>(*this); }
+};
+
+template <typename X>
+struct is_expr
+    : std::is_base_of<MatExpr<std::decay_t<X>>, std::decay_t<X>> {};
+template <typename X> constexpr bool is_expr_v = is_expr<X>::value;
+
+template <typename X> struct is_matrix : std::false_type {};
+template <typename T> struct is_matrix<Matrix<T>> : std::true_type {};
+
+template <typename X> struct is_view : std::false_type {};
+template <typename T> struct is_view<MatrixView<T>> : std::true_type {};
+
+template <typename X> using value_t = typename std::decay_t<X>::value_type;
+
+template <typename X>
+using enable_if_expr = std::enable_if_t<is_expr_v<X>, int>;
+
+/*******************************************************
+ * Leaf Nodes
+ *******************************************************/
+
+// Materialized operand. A size-1 axis gets a zero stride (1 x N: rows,
+// M x 1: columns), so the same node broadcasts over a larger result.
+template <typename T> class Ref : public MatExpr<Ref<T>> {
+public:
+  using value_type = T;
+  static constexpr bool IS_SCALAR = false;
+
+  explicit Ref(const Matrix<T> &m)
+      : p_(m.data_ptr()), rows_(m.shape()[0]), cols_(m.shape()[1]),
+        rs_(rows_ == 1 ? 0 : (size_t)cols_), cs_(cols_ == 1 ? 0 : 1) {}
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  bool flat() const { return true; }
+
+  bool col_broadcast() const { return false; }
+
+  T eval(size_t r, size_t c) const { return p_[r * rs_ + c * cs_]; }
+  T eval_row(size_t r, size_t c) const { return p_[r * rs_ + c]; }
+  T eval_flat(size_t i) const { return p_[i]; }
+  const T *row_ptr(size_t r) const { return p_ + r * rs_; }
+
+private:
+  const T *p_;
+  int rows_, cols_;
+  size_t rs_, cs_;
+};
+
+// Same as Ref but owns a temporary Matrix that was moved into the expression
+template <typename T> class Owned : public MatExpr<Owned<T>> {
+public:
+  using value_type = T;
+  static constexpr bool IS_SCALAR = false;
+
+  explicit Owned(Matrix<T> &&m)
+      : m_(std::move(m)), rows_(m_.shape()[0]), cols_(m_.shape()[1]),
+        rs_(rows_ == 1 ? 0 : (size_t)cols_), cs_(cols_ == 1 ? 0 : 1) {}
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  bool flat() const { return true; }
+
+  bool col_broadcast() const { return false; }
+
+  T eval(size_t r, size_t c) const {
+    return m_.data_ptr()[r * rs_ + c * cs_];
+  }
+  T eval_row(size_t r, size_t c) const { return m_.data_ptr()[r * rs_ + c]; }
+  T eval_flat(size_t i) const { return m_.data_ptr()[i]; }
+  const T *row_ptr(size_t r) const { return m_.data_ptr() + r * rs_; }
+
+private:
+  Matrix<T> m_;
+  int rows_, cols_;
+  size_t rs_, cs_;
+};
+
+// Scalar operand, broadcast to the shape of the other side
+template <typename T> class Scalar : public MatExpr<Scalar<T>> {
+public:
+  using value_type = T;
+  static constexpr bool IS_SCALAR = true;
+
+  explicit Scalar(T value) : v_(value) {}
+
+  int rows() const { return 1; }
+  int cols() const { return 1; }
+  bool flat() const { return true; }
+
+  bool col_broadcast() const { return false; }
+
+  T eval(size_t, size_t) const { return v_; }
+  T eval_row(size_t, size_t) const { return v_; }
+  T eval_flat(size_t) const { return v_; }
+  const T *row_ptr(size_t) const { return &v_; }
+
+private:
+  T v_;
+};
+
+/*******************************************************
+ * Element-wise Operators
+ *******************************************************/
+
+// Size of a broadcast axis, -1 when a and b are incompatible
+inline int broadcast_dim(int a, int b) {
+  if (a == b || b == 1) {
+    return a;
+  }
+  return a == 1 ? b : -1;
+}
+
+struct Add {
+  static constexpr Simd::BinOp SIMD = Simd::BinOp::Add;
+  static const char *error() {
+    return "Dimension mismatch: Shapes are incompatible for Element-wise or "
+           "Broadcast sum.";
+  }
+  template <typename T> static T apply(T a, T b) { return a + b; }
+};
+
+struct Sub {
+  static constexpr Simd::BinOp SIMD = Simd::BinOp::Sub;
+  static const char *error() { return "Matrix::Operation::Dimension mismatch"; }
+  template <typename T> static T apply(T a, T b) { return a - b; }
+};
+
+struct Mul {
+  static constexpr Simd::BinOp SIMD = Simd::BinOp::Mul;
+  static const char *error() {
+    return "Matrix::ElementWiseMult::Shapes cannot be broadcast together.";
+  }
+  template <typename T> static T apply(T a, T b) { return a * b; }
+};
+
+struct Div {
+  static constexpr Simd::BinOp SIMD = Simd::BinOp::Div;
+  static const char *error() {
+    return "Matrix::Division::ValueError::Dimensions mismatch";
+  }
+  template <typename T> static T apply(T a, T b) { return a / b; }
+};
+
+/*******************************************************
+ * Inner Nodes
+ *******************************************************/
+
+template <typename Op, typename L, typename R>
+class Binary : public MatExpr<Binary<Op, L, R>> {
+public:
+  using value_type = std::conditional_t<L::IS_SCALAR, typename R::value_type,
+                                        typename L::value_type>;
+  static constexpr bool IS_SCALAR = false;
+
+  Binary(L left, R right) : l_(std::move(left)), r_(std::move(right)) {
+    rows_ = broadcast_dim(l_.rows(), r_.rows());
+    cols_ = broadcast_dim(l_.cols(), r_.cols());
+    if (rows_ < 0 || cols_ < 0) {
+      throw std::invalid_argument(
+          std::string(Op::error()) + ": " +
+          shape_to_string(std::vector<int>{l_.rows(), l_.cols()}) + " != " +
+          shape_to_string(std::vector<int>{r_.rows(), r_.cols()}));
+    }
+    // Scalars read the same value at every flat index
+    broadcast_ = (!L::IS_SCALAR && (l_.rows() != rows_ || l_.cols() != cols_)) ||
+                 (!R::IS_SCALAR && (r_.rows() != rows_ || r_.cols() != cols_));
+    colBroadcast_ = (!L::IS_SCALAR && l_.cols() != cols_) ||
+                    (!R::IS_SCALAR && r_.cols() != cols_) ||
+                    l_.col_broadcast() || r_.col_broadcast();
+  }
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  bool flat() const { return !broadcast_ && l_.flat() && r_.flat(); }
+  // True when some M x 1 operand in the tree repeats its value along a row
+  bool col_broadcast() const { return colBroadcast_; }
+
+  value_type eval(size_t r, size_t c) const {
+    return Op::apply(l_.eval(r, c), r_.eval(r, c));
+  }
+  // eval() for trees without column broadcast: unit stride along the row
+  value_type eval_row(size_t r, size_t c) const {
+    return Op::apply(l_.eval_row(r, c), r_.eval_row(r, c));
+  }
+  value_type eval_flat(size_t i) const {
+    return Op::apply(l_.eval_flat(i), r_.eval_flat(i));
+  }
+
+  const L &left() const { return l_; }
+  const R &right() const { return r_; }
+
+private:
+  L l_;
+  R r_;
+  int rows_{}, cols_{};
+  bool broadcast_{false};
+  bool colBroadcast_{false};
+};
+
+template <typename F, typename E> class Unary : public MatExpr<Unary<F, E>> {
+public:
+  using value_type = typename E::value_type;
+  static constexpr bool IS_SCALAR = false;
+
+  Unary(F func, E expr) : f_(std::move(func)), e_(std::move(expr)) {}
+
+  int rows() const { return e_.rows(); }
+  int cols() const { return e_.cols(); }
+  bool flat() const { return e_.flat(); }
+  bool col_broadcast() const { return e_.col_broadcast(); }
+
+  value_type eval(size_t r, size_t c) const { return f_(e_.eval(r, c)); }
+  value_type eval_row(size_t r, size_t c) const {
+    return f_(e_.eval_row(r, c));
+  }
+  value_type eval_flat(size_t i) const { return f_(e_.eval_flat(i)); }
+
+  const F &func() const { return f_; }
+  const E &expr() const { return e_; }
+
+private:
+  F f_;
+  E e_;
+};
+
+/*******************************************************
+ * Node Construction
+ *******************************************************/
+
+// Lvalue matrices are referenced, rvalue matrices are moved into the node and
+// nested expressions are stored by value.
+template <typename X> auto capture(X &&x) {
+  using D = std::decay_t<X>;
+  if constexpr (is_matrix<D>::value) {
+    if constexpr (std::is_lvalue_reference_v<X>) {
+      return Ref<typename D::value_type>(x);
+    } else {
+      return Owned<typename D::value_type>(std::move(x));
+    }
+  } else {
+    return D(std::forward<X>(x));
+  }
+}
+
+template <typename X> using capture_t = decltype(capture(std::declval<X>()));
+
+template <typename Op, typename L, typename R>
+Binary<Op, capture_t<L>, capture_t<R>> make_binary(L &&l, R &&r) {
+  return {capture(std::forward<L>(l)), capture(std::forward<R>(r))};
+}
+
+template <typename F, typename E>
+Unary<F, capture_t<E>> make_unary(F func, E &&e) {
+  return {std::move(func), capture(std::forward<E>(e))};
+}
+
+// True when any element of a rows x cols block with leading dimension ld is 0
+template <typename T>
+bool has_zero(const T *p, size_t rows, size_t cols, size_t ld) {
+  bool found = false;
+  for (size_t r = 0; r < rows; r++) {
+    for (size_t c = 0; c < cols; c++) {
+      found |= (p[r * ld + c] == (T)0);
+    }
+  }
+  return found;
+}
+
+// Materialized divisors (matrices and views) are scanned once up front, lazy
+// divisors follow IEEE semantics.
+template <typename X> void check_divisor(const X &x) {
+  using D = std::decay_t<X>;
+  bool found = false;
+  if constexpr (is_matrix<D>::value) {
+    found = has_zero(x.data_ptr(), 1, x.size(), 0);
+  } else if constexpr (is_view<D>::value) {
+    found = has_zero(x.data_ptr(), x.rows(), x.cols(), x.ld());
+  }
+  if (found) {
+    throw std::invalid_argument("Matrix::Operation::ValueError::Zero Division");
+  }
+}
+
+/*******************************************************
+ * Evaluation
+ *******************************************************/
+
+// Leaves that expose their rows in memory (row_ptr)
+template <typename X> struct is_memory_leaf : std::false_type {};
+template <typename T> struct is_memory_leaf<Ref<T>> : std::true_type {};
+template <typename T> struct is_memory_leaf<Owned<T>> : std::true_type {};
+template <typename T> struct is_memory_leaf<Scalar<T>> : std::true_type {};
+template <typename T> struct is_memory_leaf<MatrixView<T>> : std::true_type {};
+
+// A single operator between two memory leaves maps onto one Simd kernel
+template <typename E> struct is_simd_binary : std::false_type {};
+template <typename Op, typename L, typename R>
+struct is_simd_binary<Binary<Op, L, R>>
+    : std::bool_constant<is_memory_leaf<L>::value &&
+                         is_memory_leaf<R>::value &&
+                         !(L::IS_SCALAR && R::IS_SCALAR) &&
+                         Simd::has_kernels<typename L::value_type>> {};
+
+template <typename T, typename Op, typename L, typename R>
+void assign_simd(T *out, const Binary<Op, L, R> &e) {
+  constexpr Simd::Form F = L::IS_SCALAR   ? Simd::Form::SV
+                           : R::IS_SCALAR ? Simd::Form::VS
+                                          : Simd::Form::VV;
+  const L &l = e.left();
+  const R &r = e.right();
+  size_t rows = (size_t)e.rows();
+  size_t cols = (size_t)e.cols();
+
+  if (e.flat()) {
+    const T *pl = l.row_ptr(0);
+    const T *pr = r.row_ptr(0);
+    Utils::parallel_for(0, rows * cols, Utils::MIN_PARALLEL_WORK,
+                        [&](size_t lo, size_t hi) {
+                          Simd::binary<Op::SIMD, F>(
+                              L::IS_SCALAR ? pl : pl + lo,
+                              R::IS_SCALAR ? pr : pr + lo, out + lo, hi - lo);
+                        });
+    return;
+  }
+
+  // Row by row. An M x 1 operand contributes one value per row, so its rows
+  // take the scalar form of the kernel.
+  bool lCol = !L::IS_SCALAR && l.cols() == 1 && cols > 1;
+  bool rCol = !R::IS_SCALAR && r.cols() == 1 && cols > 1;
+  Utils::parallel_for(
+      0, rows, Utils::grain_for(cols), [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+          if (lCol) {
+            Simd::binary<Op::SIMD, Simd::Form::SV>(l.row_ptr(i), r.row_ptr(i),
+                                                   out + i * cols, cols);
+          } else if (rCol) {
+            Simd::binary<Op::SIMD, Simd::Form::VS>(l.row_ptr(i), r.row_ptr(i),
+                                                   out + i * cols, cols);
+          } else {
+            Simd::binary<Op::SIMD, F>(l.row_ptr(i), r.row_ptr(i),
+                                      out + i * cols, cols);
+          }
+        }
+      });
+}
+
+// Functions with an array kernel (F::array(x, out, n), see VMath) applied to
+// a whole operand
+template <typename F, typename = void> struct has_array_kernel : std::false_type {};
+template <typename F>
+struct has_array_kernel<F, std::enable_if_t<F::ARRAY_KERNEL>> : std::true_type {};
+
+template <typename E> struct is_kernel_unary : std::false_type {};
+template <typename F, typename E>
+struct is_kernel_unary<Unary<F, E>> : has_array_kernel<F> {};
+
+template <typename T, typename E> void assign(T *out, const E &e);
+
+// True when a memory leaf of e that is broadcast over the rows x cols result
+// (read with a stride-0 axis) overlaps m. Writing the result into m in place
+// would then change values that later elements still read.
+template <typename T, typename E>
+bool broadcast_alias(const E &e, const Matrix<T> &m, int rows, int cols);
+
+template <typename T, typename Op, typename L, typename R>
+bool broadcast_alias(const Binary<Op, L, R> &e, const Matrix<T> &m, int rows,
+                     int cols) {
+  return broadcast_alias(e.left(), m, rows, cols) ||
+         broadcast_alias(e.right(), m, rows, cols);
+}
+
+template <typename T, typename F, typename E>
+bool broadcast_alias(const Unary<F, E> &e, const Matrix<T> &m, int rows,
+                     int cols) {
+  return broadcast_alias(e.expr(), m, rows, cols);
+}
+
+template <typename T, typename E>
+bool broadcast_alias(const E &e, const Matrix<T> &m, int rows, int cols) {
+  if constexpr (!is_memory_leaf<E>::value || E::IS_SCALAR ||
+                !std::is_same_v<typename E::value_type, T>) {
+    return false;
+  } else {
+    if (e.rows() == rows && e.cols() == cols) {
+      return false;
+    }
+    if constexpr (is_view<E>::value) {
+      return overlaps(e, m);
+    } else {
+      return overlaps(
+          MatrixView<T>(e.row_ptr(0), e.rows(), e.cols(), (size_t)e.cols()), m);
+    }
+  }
+}
+
+template <typename T, typename F, typename E>
+void assign_kernel(T *out, const Unary<F, E> &e) {
+  const F &f = e.func();
+  const E &x = e.expr();
+  size_t rows = (size_t)e.rows();
+  size_t cols = (size_t)e.cols();
+  const T *in = out;
+
+  if constexpr (is_memory_leaf<E>::value && !E::IS_SCALAR) {
+    if (!x.flat()) {
+      Utils::parallel_for(0, rows, Utils::grain_for(cols),
+                          [&](size_t lo, size_t hi) {
+                            for (size_t i = lo; i < hi; i++) {
+                              f.array(x.row_ptr(i), out + i * cols, cols);
+                            }
+                          });
+      return;
+    }
+    in = x.row_ptr(0);
+  } else {
+    // Materialize the argument in the output, then run the kernel in place
+    assign(out, x);
+  }
+
+  Utils::parallel_for(0, rows * cols, Utils::MIN_PARALLEL_WORK,
+                      [&](size_t lo, size_t hi) {
+                        f.array(in + lo, out + lo, hi - lo);
+                      });
+}
+
+// Evaluate an expression into a row-major buffer of rows() x cols(). Every
+// element is independent, large outputs are split across the thread pool.
+// Single operators on materialized operands run on the Simd kernels and
+// functions with an array kernel on theirs; other trees are fused into one
+// loop.
+template <typename T, typename E> void assign(T *out, const E &e) {
+  if constexpr (is_simd_binary<E>::value) {
+    assign_simd(out, e);
+    return;
+  } else if constexpr (is_kernel_unary<E>::value) {
+    assign_kernel(out, e);
+    return;
+  }
+
+  size_t rows = (size_t)e.rows();
+  size_t cols = (size_t)e.cols();
+
+  if (e.flat()) {
+    Utils::parallel_for(0, rows * cols, Utils::MIN_PARALLEL_WORK,
+                        [&](size_t lo, size_t hi) {
+#pragma omp simd
+                          for (size_t i = lo; i < hi; i++) {
+                            out[i] = e.eval_flat(i);
+                          }
+                        });
+    return;
+  }
+
+  // Row broadcast only: every operand row is read with unit stride
+  if (!e.col_broadcast()) {
+    Utils::parallel_for(0, rows, Utils::grain_for(cols),
+                        [&](size_t lo, size_t hi) {
+                          for (size_t r = lo; r < hi; r++) {
+                            T *pOut = out + r * cols;
+#pragma omp simd
+                            for (size_t c = 0; c < cols; c++) {
+                              pOut[c] = e.eval_row(r, c);
+                            }
+                          }
+                        });
+    return;
+  }
+
+  Utils::parallel_for(0, rows, Utils::grain_for(cols),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t r = lo; r < hi; r++) {
+                          T *pOut = out + r * cols;
+#pragma omp simd
+                          for (size_t c = 0; c < cols; c++) {
+                            pOut[c] = e.eval(r, c);
+                          }
+                        }
+                      });
+}
+
+/*******************************************************
+ * Operators
+ *******************************************************/
+
+// --- Expression (op) Expression
+
+template <typename L, typename R, enable_if_expr<L> = 0, enable_if_expr<R> = 0>
+auto operator+(L &&l, R &&r) {
+  return make_binary<Add>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <typename L, typename R, enable_if_expr<L> = 0, enable_if_expr<R> = 0>
+auto operator-(L &&l, R &&r) {
+  return make_binary<Sub>(std::forward<L>(l), std::forward<R>(r));
+}
+
+// Element-wise (Hadamard) product
+template <typename L, typename R, enable_if_expr<L> = 0, enable_if_expr<R> = 0>
+auto operator*(L &&l, R &&r) {
+  return make_binary<Mul>(std::forward<L>(l), std::forward<R>(r));
+}
+
+// Element-wise division
+template <typename L, typename R, enable_if_expr<L> = 0, enable_if_expr<R> = 0>
+auto operator/(L &&l, R &&r) {
+  check_divisor(r);
+  return make_binary<Div>(std::forward<L>(l), std::forward<R>(r));
+}
+
+// --- Expression (op) Scalar
+
+template <typename E, enable_if_expr<E> = 0>
+auto operator+(E &&e, value_t<E> s) {
+  return make_binary<Add>(std::forward<E>(e), Scalar<value_t<E>>(s));
+}
+
+template <typename E, enable_if_expr<E> = 0>
+auto operator+(value_t<E> s, E &&e) {
+  return make_binary<Add>(Scalar<value_t<E>>(s), std::forward<E>(e));
+}
+
+template <typename E, enable_if_expr<E> = 0>
+auto operator-(E &&e, value_t<E> s) {
+  return make_binary<Sub>(std::forward<E>(e), Scalar<value_t<E>>(s));
+}
+
+template <typename E, enable_if_expr<E> = 0>
+auto operator-(value_t<E> s, E &&e) {
+  return make_binary<Sub>(Scalar<value_t<E>>(s), std::forward<E>(e));
+}
+
+template <typename E, enable_if_expr<E> = 0>
+auto operator*(E &&e, value_t<E> s) {
+  return make_binary<Mul>(std::forward<E>(e), Scalar<value_t<E>>(s));
+}
+
+template <typename E, enable_if_expr<E> = 0>
+auto operator*(value_t<E> s, E &&e) {
+  return make_binary<Mul>(Scalar<value_t<E>>(s), std::forward<E>(e));
+}
+
+// Division by a scalar is a multiplication by its reciprocal
+template <typename E, enable_if_expr<E> = 0>
+auto operator/(E &&e, value_t<E> s) {
+  using T = value_t<E>;
+  assert_ineq(s, (T)0, "Matrix::Zero division");
+  return make_binary<Mul>(std::forward<E>(e), Scalar<T>((T)1.0 / s));
+}
+
+template <typename E, enable_if_expr<E> = 0>
+auto operator/(value_t<E> s, E &&e) {
+  check_divisor(e);
+  return make_binary<Div>(Scalar<value_t<E>>(s), std::forward<E>(e));
+}
+
+} // namespace Expr
+} // namespace Math
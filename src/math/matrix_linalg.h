@@ -1,76 +1,213 @@
 #pragma once
 #include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "gemm.h"
 #include "matrix.h"
+#include "reduce.h"
+#include "transpose.h"
 #include <cassert>
 #include <cstddef>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace Math {
 
 namespace Linalg {
 
-template <typename T> Matrix<T> matmul(const Matrix<T> &a, const Matrix<T> &b) {
-  assert_eq(a.shape().size(), (size_t)2,
-            "Matrix::Linalg::Matmul::ValueError::Only support Matrix n x m");
-  assert_eq(b.shape().size(), (size_t)2,
-            "Matrix::Linalg::Matmul::ValueError::Only support Matrix n x m");
+// Destination-passing overloads write into `out`, resizing it only when its
+// size changes, so steady-state callers do not allocate. Inputs are read
+// through MatrixView (a Matrix converts implicitly), so row ranges and columns
+// of larger matrices are used in place. `out` must not overlap an input.
+template <typename T> using ViewArg = nondeduced_t<MatrixView<T>>;
+
+template <typename T>
+void assert_no_alias(const Matrix<T> &out, const MatrixView<T> &in,
+                     const std::string &context) {
+  if (overlaps(in, out)) {
+    throw std::invalid_argument(context + "::Output aliases an input");
+  }
+}
 
-  assert_eq(a.shape()[1], b.shape()[0],
+template <typename T>
+void matmul(const ViewArg<T> &a, const ViewArg<T> &b, Matrix<T> &out) {
+  assert_eq(a.cols(), b.rows(),
             "Matrix::Linalg::Matmul::ValueError::Dimesion mistmatch (cols A != "
             "rows B)");
+  assert_no_alias(out, a, "Matrix::Linalg::Matmul");
+  assert_no_alias(out, b, "Matrix::Linalg::Matmul");
 
-  int rowsA{a.shape()[0]};
-  int colsA{a.shape()[1]};
-  int rowsB{b.shape()[0]};
-  int colsB{b.shape()[1]};
+  int rowsA{a.rows()};
+  int colsA{a.cols()};
+  int colsB{b.cols()};
 
-  const T *pA = a.data_ptr();
-  const T *pB = b.data_ptr();
-  std::vector<T> result((size_t)(rowsA * colsB), 0);
-  T *pResult = result.data();
+  out.resize(rowsA, colsB);
 
-#pragma omp parallel for collapse(2)
-  for (int i = 0; i < rowsA; i++) {
-    for (int j = 0; j < colsB; j++) {
+  Gemm::gemm(rowsA, colsB, colsA, (T)1, a.data_ptr(), (int)a.ld(),
+             b.data_ptr(), (int)b.ld(), (T)0, out.data_ptr(), colsB);
+}
 
-      int idResult = i * colsB + j;
-      int idBaseA = i * colsA;
+template <typename T> Matrix<T> matmul(const Matrix<T> &a, const Matrix<T> &b) {
+  Matrix<T> out;
+  matmul<T>(a, b, out);
+  return out;
+}
 
-      T sum = 0;
+template <typename T>
+Matrix<T> matmul(const MatrixView<T> &a, const MatrixView<T> &b) {
+  Matrix<T> out;
+  matmul<T>(a, b, out);
+  return out;
+}
 
-      for (int k = 0; k < colsA; k++) {
-        sum += pA[idBaseA + k] * pB[k * colsB + j];
-      }
+// a^T * b without materializing a^T: a is (K x M), b is (K x N)
+template <typename T>
+void matmul_tn(const ViewArg<T> &a, const ViewArg<T> &b, Matrix<T> &out) {
+  assert_eq(a.rows(), b.rows(),
+            "Matrix::Linalg::MatmulTN::ValueError::Dimesion mistmatch (rows A "
+            "!= rows B)");
+  assert_no_alias(out, a, "Matrix::Linalg::MatmulTN");
+  assert_no_alias(out, b, "Matrix::Linalg::MatmulTN");
 
-      pResult[idResult] = sum;
-    }
-  }
+  int K{a.rows()};
+  int M{a.cols()};
+  int N{b.cols()};
+
+  out.resize(M, N);
 
-  return {result, {rowsA, colsB}};
+  Gemm::gemm(Gemm::Trans::Yes, Gemm::Trans::No, M, N, K, (T)1, a.data_ptr(),
+             (int)a.ld(), b.data_ptr(), (int)b.ld(), (T)0, out.data_ptr(), N);
 }
 
-template <typename T> Matrix<T> transpose(const Matrix<T> &matrix) {
+template <typename T>
+Matrix<T> matmul_tn(const Matrix<T> &a, const Matrix<T> &b) {
+  Matrix<T> out;
+  matmul_tn<T>(a, b, out);
+  return out;
+}
 
-  std::vector<T> out(matrix.size());
+template <typename T>
+Matrix<T> matmul_tn(const MatrixView<T> &a, const MatrixView<T> &b) {
+  Matrix<T> out;
+  matmul_tn<T>(a, b, out);
+  return out;
+}
 
-  T *pOut = out.data();
-  const T *pMatrix = matrix.data_ptr();
-  int idOut{0};
-  int rows = matrix.shape()[0];
-  int cols = matrix.shape()[1];
+// a * b^T without materializing b^T: a is (M x K), b is (N x K)
+template <typename T>
+void matmul_nt(const ViewArg<T> &a, const ViewArg<T> &b, Matrix<T> &out) {
+  assert_eq(a.cols(), b.cols(),
+            "Matrix::Linalg::MatmulNT::ValueError::Dimesion mistmatch (cols A "
+            "!= cols B)");
+  assert_no_alias(out, a, "Matrix::Linalg::MatmulNT");
+  assert_no_alias(out, b, "Matrix::Linalg::MatmulNT");
 
-#pragma omp parallel for collapse(2)
-  for (int i = 0; i < cols; i++) {
-    for (int j = 0; j < rows; j++) {
+  int M{a.rows()};
+  int K{a.cols()};
+  int N{b.rows()};
 
-      int idOut = i * rows + j;
-      int idIn = j * cols + i;
+  out.resize(M, N);
 
-      pOut[idOut] = pMatrix[idIn];
-    }
+  Gemm::gemm(Gemm::Trans::No, Gemm::Trans::Yes, M, N, K, (T)1, a.data_ptr(),
+             (int)a.ld(), b.data_ptr(), (int)b.ld(), (T)0, out.data_ptr(), N);
+}
+
+template <typename T>
+Matrix<T> matmul_nt(const Matrix<T> &a, const Matrix<T> &b) {
+  Matrix<T> out;
+  matmul_nt<T>(a, b, out);
+  return out;
+}
+
+template <typename T>
+Matrix<T> matmul_nt(const MatrixView<T> &a, const MatrixView<T> &b) {
+  Matrix<T> out;
+  matmul_nt<T>(a, b, out);
+  return out;
+}
+
+// Tiled, register-blocked and parallel (see transpose.h)
+template <typename T> void transpose(const ViewArg<T> &matrix, Matrix<T> &out) {
+  assert_no_alias(out, matrix, "Matrix::Linalg::Transpose");
+
+  int rows = matrix.rows();
+  int cols = matrix.cols();
+
+  out.resize(cols, rows);
+
+  Transpose::out_of_place(matrix.data_ptr(), (size_t)rows, (size_t)cols,
+                          matrix.ld(), out.data_ptr(), (size_t)rows);
+}
+
+template <typename T> Matrix<T> transpose(const Matrix<T> &matrix) {
+  Matrix<T> out;
+  transpose<T>(matrix, out);
+  return out;
+}
+
+template <typename T> Matrix<T> transpose(const MatrixView<T> &matrix) {
+  Matrix<T> out;
+  transpose<T>(matrix, out);
+  return out;
+}
+
+// Transpose m in place. Square matrices swap tiles across the diagonal with
+// no extra storage; other shapes go through one temporary buffer.
+template <typename T> void transpose_inplace(Matrix<T> &m) {
+  int rows = m.shape()[0];
+  int cols = m.shape()[1];
+  if (rows == cols) {
+    Transpose::in_place_square(m.data_ptr(), (size_t)rows, (size_t)cols);
+    return;
+  }
+  Matrix<T> out;
+  transpose<T>(m, out);
+  m = std::move(out);
+}
+
+// BLAS axpy: y = alpha * x + y
+template <typename T>
+void axpy(typename Matrix<T>::value_type alpha, const ViewArg<T> &x,
+          Matrix<T> &y) {
+  assert_shape(x.shape(), y.shape(), "Matrix::Linalg::Axpy");
+
+  size_t rows = (size_t)x.rows();
+  size_t cols = (size_t)x.cols();
+  const T a = alpha;
+  const T *pX = x.data_ptr();
+  T *pY = y.data_ptr();
+
+  if (x.contiguous()) {
+    Utils::parallel_for(0, rows * cols, Utils::MIN_PARALLEL_WORK,
+                        [&](size_t lo, size_t hi) {
+#pragma omp simd
+                          for (size_t i = lo; i < hi; i++) {
+                            pY[i] += a * pX[i];
+                          }
+                        });
+    return;
   }
 
-  return {out, {cols, rows}};
+  size_t ldx = x.ld();
+  Utils::parallel_for(0, rows, Utils::grain_for(cols),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t r = lo; r < hi; r++) {
+                          const T *xRow = pX + r * ldx;
+                          T *yRow = pY + r * cols;
+#pragma omp simd
+                          for (size_t c = 0; c < cols; c++) {
+                            yRow[c] += a * xRow[c];
+                          }
+                        }
+                      });
+}
+
+// BLAS scal: x = alpha * x
+template <typename T>
+void scal(typename Matrix<T>::value_type alpha, Matrix<T> &x) {
+  T *pX = x.data_ptr();
+  T a = alpha;
+  Simd::binary<Simd::BinOp::Mul, Simd::Form::VS>(pX, &a, pX, x.size());
 }
 
 template <typename T> Matrix<T> ones(std::vector<int> shape) {
@@ -81,9 +218,9 @@ template <typename T> Matrix<T> ones(std::vector<int> shape) {
     sizeInt *= (size_t)element;
   }
 
-  std::vector<T> out(sizeInt, 1);
+  AlignedVector<T> out(sizeInt, 1);
 
-  return {out, shape};
+  return {std::move(out), shape};
 }
 
 template <typename T> Matrix<T> zeros(std::vector<int> shape) {
@@ -94,66 +231,71 @@ template <typename T> Matrix<T> zeros(std::vector<int> shape) {
     sizeInt *= (size_t)element;
   }
 
-  std::vector<T> out(sizeInt, 0);
+  AlignedVector<T> out(sizeInt, 0);
 
-  return {out, shape};
+  return {std::move(out), shape};
 }
 
-template <typename T> Matrix<T> sum(const Matrix<T> &matrix, size_t axis) {
+template <typename T>
+void sum(const ViewArg<T> &matrix, size_t axis, Matrix<T> &out) {
   assert_gineq(axis, (size_t)1,
                "Matrix::LineAlg::Sum::ValueError:::Index out of bounds");
+  assert_no_alias(out, matrix, "Matrix::Linalg::Sum");
 
-  int nrows = matrix.shape()[0];
-  int ncols = matrix.shape()[1];
-
-  // Out size
-  size_t resultSize = (axis == 0) ? ncols : nrows;
-
-  std::vector<T> result(resultSize, 0);
-
-  T *pResult = result.data();
-  const T *pMatrix = matrix.data_ptr();
+  int nrows = matrix.rows();
+  int ncols = matrix.cols();
 
-  // --- CASO AXIS 0: Sum on Rows
+  // Shape Out
   if (axis == 0) {
-#pragma omp parallel for
-    for (int j = 0; j < ncols; j++) {
-      T acc = 0;
-      for (int i = 0; i < nrows; i++) {
-        acc += pMatrix[i * ncols + j];
-      }
-      pResult[j] = acc;
-    }
+    out.resize(1, ncols);
+  } else {
+    out.resize(nrows, 1);
   }
 
-  // --- CASO AXIS 1: Sum on Columns
-  else {
-#pragma omp parallel for
-    for (int i = 0; i < nrows; i++) {
-      T acc = 0;
-      int baseIdx = i * ncols;
-      for (int j = 0; j < ncols; j++) {
-        acc += pMatrix[baseIdx + j];
-      }
-      pResult[i] = acc;
-    }
+  // Blocked and pairwise, see reduce.h
+  if (axis == 0) {
+    // --- CASO AXIS 0: Sum on Rows (row-major walk)
+    Reduce::column_sums<T>(matrix, out.data_ptr());
+  } else {
+    // --- CASO AXIS 1: Sum on Columns
+    Reduce::row_sums<T>(matrix, out.data_ptr());
   }
+}
 
-  // Shape Out
-  std::vector<int> shapeResult =
-      (axis == 0) ? std::vector<int>{1, ncols} : std::vector<int>{nrows, 1};
+template <typename T> Matrix<T> sum(const Matrix<T> &matrix, size_t axis) {
+  Matrix<T> out;
+  sum<T>(matrix, axis, out);
+  return out;
+}
 
-  return {result, shapeResult};
+template <typename T> Matrix<T> sum(const MatrixView<T> &matrix, size_t axis) {
+  Matrix<T> out;
+  sum<T>(matrix, axis, out);
+  return out;
+}
+
+// Sum all the elements from a Matrix m into a 1x1 Matrix (pairwise,
+// parallel, same result for any thread count)
+template <typename T> void sum(const ViewArg<T> &m, Matrix<T> &out) {
+  assert_no_alias(out, m, "Matrix::Linalg::Sum");
+
+  T total = Reduce::sum<T>(m);
+
+  out.resize(1, 1);
+  out.data_ptr()[0] = total;
 }
 
 // Sum all the elements from a Matrix m and return a Matrix 1x1 with the sum
 template <typename T> Matrix<T> sum(const Matrix<T> &m) {
-  T sum{(T)0};
-  for (const auto &element : m.data()) {
-    sum += element;
-  }
+  Matrix<T> out;
+  sum<T>(m, out);
+  return out;
+}
 
-  return Matrix<T>(std::vector<T>({sum}), std::vector<int>({1, 1}));
+template <typename T> Matrix<T> sum(const MatrixView<T> &m) {
+  Matrix<T> out;
+  sum<T>(m, out);
+  return out;
 }
 
 } // namespace Linalg
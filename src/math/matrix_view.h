@@ -0,0 +1,109 @@
+#pragma once
+#include "../utils/asserts.h"
+#include "matrix_expr.h"
+#include "shape.h"
+#include <cstddef>
+
+/********************************************************************************
+ *
+ * MatrixView: non-owning, read-only window over row-major data.
+ *
+ * A view is a pointer, a shape and a leading dimension (the distance between
+ * the starts of two consecutive rows). Row ranges, single rows and columns of
+ * a Matrix are views over the same buffer, so slicing a dataset into
+ * mini-batches never copies:
+ *
+ *   auto batch = X.viewRows(i, i + 32);       // no copy
+ *   Linalg::matmul(batch, W, out);            // kernels read it in place
+ *   Matrix<T> owned = batch;                  // explicit copy when needed
+ *
+ * A view does not keep its Matrix alive and is invalidated when the Matrix is
+ * resized or destroyed.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+template <typename T> class Matrix;
+
+template <typename T> class MatrixView : public Expr::MatExpr<MatrixView<T>> {
+public:
+  using value_type = T;
+  static constexpr bool IS_SCALAR = false;
+
+  MatrixView(const T *data, int rows, int cols, size_t ld)
+      : p_(data), rows_(rows), cols_(cols), ld_(ld),
+        rs_(rows == 1 ? 0 : ld), cs_(cols == 1 ? 0 : 1) {}
+
+  // Whole-matrix view, Matrix arguments convert implicitly
+  MatrixView(const Matrix<T> &m)
+      : MatrixView(m.data_ptr(), m.shape()[0], m.shape()[1],
+                   (size_t)m.shape()[1]) {}
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  size_t ld() const { return ld_; }
+  Shape shape() const { return Shape(rows_, cols_); }
+  size_t size() const { return (size_t)rows_ * (size_t)cols_; }
+  const T *data_ptr() const { return p_; }
+
+  // True when the rows are packed back to back (one flat block)
+  bool contiguous() const { return rows_ <= 1 || ld_ == (size_t)cols_; }
+
+  T at(size_t row, size_t col) const { return p_[row * ld_ + col]; }
+
+  // Rows [begin, end)
+  MatrixView<T> viewRows(size_t begin, size_t end) const {
+    assert_lt(end, (size_t)rows_ + 1, "MatrixView::viewRows");
+    assert_gineq(begin, end, "MatrixView::viewRows");
+    return {p_ + begin * ld_, (int)(end - begin), cols_, ld_};
+  }
+
+  MatrixView<T> viewRow(size_t row) const {
+    assert_lt(row, (size_t)rows_, "MatrixView::viewRow");
+    return {p_ + row * ld_, 1, cols_, ld_};
+  }
+
+  MatrixView<T> viewCol(size_t col) const {
+    assert_lt(col, (size_t)cols_, "MatrixView::viewCol");
+    return {p_ + col, rows_, 1, ld_};
+  }
+
+  // Expression leaf interface (see matrix_expr.h). A single row or column
+  // gets a zero stride so it broadcasts like a 1 x N or M x 1 Matrix.
+  bool flat() const { return contiguous(); }
+  bool col_broadcast() const { return false; }
+  T eval(size_t r, size_t c) const { return p_[r * rs_ + c * cs_]; }
+  T eval_row(size_t r, size_t c) const { return p_[r * rs_ + c]; }
+  T eval_flat(size_t i) const { return p_[i]; }
+  const T *row_ptr(size_t r) const { return p_ + r * rs_; }
+
+private:
+  const T *p_;
+  int rows_, cols_;
+  size_t ld_;
+  size_t rs_, cs_;
+};
+
+// True when a view reads memory that `m` currently owns
+template <typename T>
+bool overlaps(const MatrixView<T> &view, const Matrix<T> &m) {
+  if (view.size() == 0 || m.size() == 0) {
+    return false;
+  }
+  const T *vBegin = view.data_ptr();
+  const T *vEnd = vBegin + (size_t)(view.rows() - 1) * view.ld() + view.cols();
+  const T *mBegin = m.data_ptr();
+  const T *mEnd = mBegin + m.size();
+
+  return vBegin < mEnd && mBegin < vEnd;
+}
+
+// Blocks template argument deduction on a parameter, so a Matrix argument can
+// convert to the MatrixView a kernel expects
+template <typename X> struct nondeduced {
+  using type = X;
+};
+template <typename X> using nondeduced_t = typename nondeduced<X>::type;
+
+} // namespace Math
@@ -0,0 +1,245 @@
+#pragma once
+#include "../utils/thread_pool.h"
+#include "aligned_allocator.h"
+#include "matrix_view.h"
+#include <algorithm>
+#include <cstddef>
+
+/********************************************************************************
+ *
+ * Reduction engine for sums over matrices
+ *
+ * - Pairwise summation: 8 independent accumulators over blocks of up to 128
+ *   values, then a balanced tree. Error grows like O(log n) instead of O(n),
+ *   which matters for float losses over large batches.
+ * - Kahan (compensated) summation on request, per lane.
+ * - Work is cut in chunks of a fixed size that does not depend on the thread
+ *   count, and partial results are combined in a fixed tree. The result is
+ *   bit-identical for any number of threads.
+ * - Partial results live in separate cache lines (no false sharing).
+ * - Column sums walk the matrix row by row (unit stride), accumulating a
+ *   block of rows into a row of partial sums.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+namespace Reduce {
+
+enum class Method { Pairwise, Kahan };
+
+// Elements per parallel task of a full reduction
+constexpr size_t CHUNK = 4096;
+// Rows and columns per task of a column reduction
+constexpr size_t ROW_BLOCK = 128;
+constexpr size_t COL_BLOCK = 1024;
+
+namespace detail {
+
+constexpr size_t LANES = 8;
+constexpr size_t LEAF = 128;
+
+template <typename T> T combine_lanes(const T *acc) {
+  return ((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+         ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+template <typename T> T pairwise(const T *x, size_t n) {
+  if (n <= LEAF) {
+    T acc[LANES] = {};
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+      for (size_t l = 0; l < LANES; l++) {
+        acc[l] += x[i + l];
+      }
+    }
+    T s = combine_lanes(acc);
+    for (; i < n; i++) {
+      s += x[i];
+    }
+    return s;
+  }
+  // Split on a multiple of the lane count
+  size_t half = (n / 2) & ~(LANES - 1);
+  return pairwise(x, half) + pairwise(x + half, n - half);
+}
+
+template <typename T> T kahan(const T *x, size_t n) {
+  T sum[LANES] = {};
+  T comp[LANES] = {};
+  size_t i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    for (size_t l = 0; l < LANES; l++) {
+      T y = x[i + l] - comp[l];
+      T t = sum[l] + y;
+      comp[l] = (t - sum[l]) - y;
+      sum[l] = t;
+    }
+  }
+  for (; i < n; i++) {
+    T y = x[i] - comp[0];
+    T t = sum[0] + y;
+    comp[0] = (t - sum[0]) - y;
+    sum[0] = t;
+  }
+  for (size_t l = 0; l < LANES; l++) {
+    sum[l] -= comp[l];
+  }
+  return combine_lanes(sum);
+}
+
+template <typename T> T sum_block(const T *x, size_t n, Method method) {
+  return method == Method::Kahan ? kahan(x, n) : pairwise(x, n);
+}
+
+// One partial result per cache line
+template <typename T> struct alignas(64) Padded {
+  T value;
+};
+
+// Reduce partials[0..n) in place with a fixed binary tree
+template <typename T> T tree(Padded<T> *partials, size_t n) {
+  for (size_t stride = 1; stride < n; stride *= 2) {
+    for (size_t i = 0; i + stride < n; i += 2 * stride) {
+      partials[i].value += partials[i + stride].value;
+    }
+  }
+  return n ? partials[0].value : (T)0;
+}
+
+// Rows [r0, r1) x columns [c0, c1) of m accumulated into acc[c0, c1)
+template <typename T>
+void column_block(const MatrixView<T> &m, size_t r0, size_t r1, size_t c0,
+                  size_t c1, T *acc) {
+  const T *p = m.data_ptr();
+  size_t ld = m.ld();
+  std::fill(acc + c0, acc + c1, (T)0);
+  for (size_t i = r0; i < r1; i++) {
+    const T *row = p + i * ld;
+#pragma omp simd
+    for (size_t j = c0; j < c1; j++) {
+      acc[j] += row[j];
+    }
+  }
+}
+
+} // namespace detail
+
+// Sum over the CHUNK-sized pieces [begin, begin + len) of [0, n) of the
+// partial results block(begin, len), combined in the fixed tree. The block
+// may also write per element (fused kernels that reduce while they store).
+template <typename T, typename F> T chunked_sum(size_t n, F &&block) {
+  size_t chunks = (n + CHUNK - 1) / CHUNK;
+  if (chunks <= 1) {
+    return block((size_t)0, n);
+  }
+
+  AlignedVector<detail::Padded<T>> partials(chunks);
+  Utils::parallel_for(0, chunks, Utils::grain_for(CHUNK),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t c = lo; c < hi; c++) {
+                          size_t begin = c * CHUNK;
+                          partials[c].value =
+                              block(begin, std::min(CHUNK, n - begin));
+                        }
+                      });
+  return detail::tree(partials.data(), chunks);
+}
+
+// Sum of x[0..n)
+template <typename T>
+T sum(const T *x, size_t n, Method method = Method::Pairwise) {
+  return chunked_sum<T>(n, [&](size_t begin, size_t len) {
+    return detail::sum_block(x + begin, len, method);
+  });
+}
+
+// Sum of every element of m
+template <typename T>
+T sum(const MatrixView<T> &m, Method method = Method::Pairwise) {
+  size_t rows = (size_t)m.rows();
+  size_t cols = (size_t)m.cols();
+  if (m.contiguous()) {
+    return sum(m.data_ptr(), rows * cols, method);
+  }
+
+  // Strided: one partial per row
+  AlignedVector<detail::Padded<T>> partials(rows);
+  Utils::parallel_for(0, rows, Utils::grain_for(cols),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t i = lo; i < hi; i++) {
+                          partials[i].value = detail::sum_block(
+                              m.data_ptr() + i * m.ld(), cols, method);
+                        }
+                      });
+  return detail::tree(partials.data(), rows);
+}
+
+// out[j] = sum over the rows of column j, out holds cols() values
+template <typename T> void column_sums(const MatrixView<T> &m, T *out) {
+  size_t rows = (size_t)m.rows();
+  size_t cols = (size_t)m.cols();
+  size_t rowBlocks = std::max((size_t)1, (rows + ROW_BLOCK - 1) / ROW_BLOCK);
+  size_t colBlocks = (cols + COL_BLOCK - 1) / COL_BLOCK;
+
+  if (rowBlocks == 1) {
+    Utils::parallel_for(0, colBlocks, Utils::grain_for(rows * COL_BLOCK),
+                        [&](size_t lo, size_t hi) {
+                          for (size_t c = lo; c < hi; c++) {
+                            detail::column_block(
+                                m, 0, rows, c * COL_BLOCK,
+                                std::min(cols, (c + 1) * COL_BLOCK), out);
+                          }
+                        });
+    return;
+  }
+
+  // One row of partial sums per block of rows, padded to whole cache lines
+  size_t ldp = (cols * sizeof(T) + 63) / 64 * 64 / sizeof(T);
+  AlignedVector<T> partials(rowBlocks * ldp);
+
+  size_t tasks = rowBlocks * colBlocks;
+  Utils::parallel_for(
+      0, tasks, Utils::grain_for(ROW_BLOCK * COL_BLOCK),
+      [&](size_t lo, size_t hi) {
+        for (size_t t = lo; t < hi; t++) {
+          size_t b = t / colBlocks;
+          size_t c = t % colBlocks;
+          detail::column_block(m, b * ROW_BLOCK,
+                               std::min(rows, (b + 1) * ROW_BLOCK),
+                               c * COL_BLOCK,
+                               std::min(cols, (c + 1) * COL_BLOCK),
+                               partials.data() + b * ldp);
+        }
+      });
+
+  // Fixed tree over the blocks, vectorized along the columns
+  for (size_t stride = 1; stride < rowBlocks; stride *= 2) {
+    for (size_t b = 0; b + stride < rowBlocks; b += 2 * stride) {
+      T *dst = partials.data() + b * ldp;
+      const T *src = partials.data() + (b + stride) * ldp;
+#pragma omp simd
+      for (size_t j = 0; j < cols; j++) {
+        dst[j] += src[j];
+      }
+    }
+  }
+  std::copy(partials.data(), partials.data() + cols, out);
+}
+
+// out[i] = sum of row i, out holds rows() values
+template <typename T>
+void row_sums(const MatrixView<T> &m, T *out,
+              Method method = Method::Pairwise) {
+  size_t cols = (size_t)m.cols();
+  Utils::parallel_for(0, (size_t)m.rows(), Utils::grain_for(cols),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t i = lo; i < hi; i++) {
+                          out[i] = detail::sum_block(m.data_ptr() + i * m.ld(),
+                                                     cols, method);
+                        }
+                      });
+}
+
+} // namespace Reduce
+} // namespace Math
@@ -0,0 +1,64 @@
+#pragma once
+#include "../utils/asserts.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/********************************************************************************
+ *
+ * Shape of a Matrix, stored inline (no heap allocation)
+ *
+ * Behaves like the std::vector<int> it replaces for reading: size(),
+ * operator[], iteration and comparison. It is built implicitly from {rows,
+ * cols} or from a std::vector<int> of two dimensions.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+class Shape {
+public:
+  static constexpr std::size_t RANK = 2;
+
+  constexpr Shape() : dims_{0, 0} {}
+  constexpr Shape(int rows, int cols) : dims_{rows, cols} {}
+  Shape(const std::vector<int> &dims) {
+    assert_eq(dims.size(), RANK, "Matrix::Const::Dimension mismatch");
+    dims_[0] = dims[0];
+    dims_[1] = dims[1];
+  }
+
+  constexpr std::size_t size() const { return RANK; }
+  constexpr int operator[](std::size_t i) const { return dims_[i]; }
+  int &operator[](std::size_t i) { return dims_[i]; }
+
+  const int *begin() const { return dims_; }
+  const int *end() const { return dims_ + RANK; }
+
+  std::vector<int> to_vector() const { return {dims_[0], dims_[1]}; }
+
+  bool operator==(const Shape &other) const {
+    return dims_[0] == other.dims_[0] && dims_[1] == other.dims_[1];
+  }
+  bool operator!=(const Shape &other) const { return !(*this == other); }
+
+private:
+  int dims_[RANK];
+};
+
+inline std::string shape_to_string(const Shape &shape) {
+  return "(" + std::to_string(shape[0]) + ", " + std::to_string(shape[1]) +
+         ")";
+}
+
+// Assert two shapes be equal, without building temporary vectors
+inline void assert_shape(const Shape &shape1, const Shape &shape2,
+                         const std::string &context = "") {
+  if (shape1 != shape2) {
+    throw std::invalid_argument("Shape Mismatch " + context + ": " +
+                                shape_to_string(shape1) +
+                                " != " + shape_to_string(shape2));
+  }
+}
+
+} // namespace Math
@@ -0,0 +1,226 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BRAINSIM_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define BRAINSIM_SIMD_X86 0
+#endif
+
+/********************************************************************************
+ *
+ * Hand-vectorized element-wise kernels with runtime CPU dispatch
+ *
+ * Every kernel is compiled once per instruction set (SSE4.2, AVX2, AVX-512)
+ * through target attributes, independently of the -march flags of the build.
+ * The widest set the CPU supports is detected on first use and every call is
+ * routed to it, with a portable scalar loop as the fallback:
+ *
+ *   Simd::binary<Simd::BinOp::Mul, Simd::Form::VV>(a, b, out, n);
+ *
+ * Forms: VV reads two arrays, VS broadcasts *b, SV broadcasts *a. `out` may
+ * be `a` or `b` (in-place update) but must not partially overlap them.
+ *
+ ********************************************************************************/
+
+namespace Math {
+namespace Simd {
+
+enum class Isa { Scalar = 0, SSE42 = 1, AVX2 = 2, AVX512 = 3 };
+enum class BinOp { Add, Sub, Mul, Div };
+enum class Form { VV, VS, SV };
+
+inline const char *isa_name(Isa isa) {
+  switch (isa) {
+  case Isa::AVX512:
+    return "AVX-512";
+  case Isa::AVX2:
+    return "AVX2";
+  case Isa::SSE42:
+    return "SSE4.2";
+  default:
+    return "Scalar";
+  }
+}
+
+// Widest instruction set supported by this CPU
+inline Isa detect_isa() {
+#if BRAINSIM_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Isa::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return Isa::AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return Isa::SSE42;
+  }
+#endif
+  return Isa::Scalar;
+}
+
+namespace detail {
+inline Isa &selected_isa() {
+  static Isa isa = detect_isa();
+  return isa;
+}
+} // namespace detail
+
+// Instruction set used by the kernels
+inline Isa active_isa() { return detail::selected_isa(); }
+
+// Force a narrower instruction set (benchmarks, tests). Requests above what
+// the CPU supports are clamped.
+inline Isa set_isa(Isa isa) {
+  Isa best = detect_isa();
+  detail::selected_isa() = (int)isa < (int)best ? isa : best;
+  return detail::selected_isa();
+}
+
+template <BinOp OP, typename T> inline T apply(T a, T b) {
+  if constexpr (OP == BinOp::Add) {
+    return a + b;
+  } else if constexpr (OP == BinOp::Sub) {
+    return a - b;
+  } else if constexpr (OP == BinOp::Mul) {
+    return a * b;
+  } else {
+    return a / b;
+  }
+}
+
+/*******************************************************
+ * Scalar fallback
+ *******************************************************/
+
+namespace scalar {
+template <BinOp OP, Form F, typename T>
+void binary(const T *a, const T *b, T *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    T x = (F == Form::SV) ? *a : a[i];
+    T y = (F == Form::VS) ? *b : b[i];
+    out[i] = apply<OP>(x, y);
+  }
+}
+} // namespace scalar
+
+/*******************************************************
+ * x86 kernels
+ *******************************************************/
+
+#if BRAINSIM_SIMD_X86
+
+// Register type and intrinsics of one instruction set for one scalar type.
+// Every member carries the target attribute so it inlines into the kernels.
+#define BRAINSIM_SIMD_PACKET(NAME, TARGET, T, REG, WIDTH_, PFX, SFX)          \
+  struct NAME {                                                               \
+    using reg = REG;                                                          \
+    static constexpr size_t WIDTH = WIDTH_;                                   \
+    __attribute__((target(TARGET))) static reg load(const T *p) {             \
+      return PFX##_loadu_##SFX(p);                                            \
+    }                                                                         \
+    __attribute__((target(TARGET))) static void store(T *p, reg v) {          \
+      PFX##_storeu_##SFX(p, v);                                               \
+    }                                                                         \
+    __attribute__((target(TARGET))) static reg set1(T v) {                    \
+      return PFX##_set1_##SFX(v);                                             \
+    }                                                                         \
+    template <BinOp OP>                                                       \
+    __attribute__((target(TARGET))) static reg op(reg a, reg b) {            \
+      if constexpr (OP == BinOp::Add) {                                       \
+        return PFX##_add_##SFX(a, b);                                         \
+      } else if constexpr (OP == BinOp::Sub) {                                \
+        return PFX##_sub_##SFX(a, b);                                         \
+      } else if constexpr (OP == BinOp::Mul) {                                \
+        return PFX##_mul_##SFX(a, b);                                         \
+      } else {                                                                \
+        return PFX##_div_##SFX(a, b);                                         \
+      }                                                                       \
+    }                                                                         \
+  };
+
+// Binary kernel of one instruction set: full registers (two per iteration to
+// hide latency), then a scalar tail
+#define BRAINSIM_SIMD_BINARY(NS, TARGET, PF, PD, PFX)                         \
+  namespace NS {                                                              \
+  BRAINSIM_SIMD_PACKET(F32, TARGET, float, PF, sizeof(PF) / 4, PFX, ps)      \
+  BRAINSIM_SIMD_PACKET(F64, TARGET, double, PD, sizeof(PD) / 8, PFX, pd)     \
+  template <typename T>                                                       \
+  using Packet = std::conditional_t<std::is_same_v<T, float>, F32, F64>;      \
+                                                                              \
+  template <BinOp OP, Form F, typename T>                                     \
+  __attribute__((target(TARGET))) void binary(const T *a, const T *b, T *out, \
+                                              size_t n) {                     \
+    using P = Packet<T>;                                                      \
+    constexpr size_t W = P::WIDTH;                                            \
+    typename P::reg sa{}, sb{};                                               \
+    if constexpr (F == Form::SV) {                                            \
+      sa = P::set1(*a);                                                       \
+    }                                                                         \
+    if constexpr (F == Form::VS) {                                            \
+      sb = P::set1(*b);                                                       \
+    }                                                                         \
+    size_t i = 0;                                                             \
+    for (; i + 2 * W <= n; i += 2 * W) {                                      \
+      typename P::reg a0 = (F == Form::SV) ? sa : P::load(a + i);             \
+      typename P::reg a1 = (F == Form::SV) ? sa : P::load(a + i + W);         \
+      typename P::reg b0 = (F == Form::VS) ? sb : P::load(b + i);             \
+      typename P::reg b1 = (F == Form::VS) ? sb : P::load(b + i + W);         \
+      P::store(out + i, P::template op<OP>(a0, b0));                          \
+      P::store(out + i + W, P::template op<OP>(a1, b1));                      \
+    }                                                                         \
+    for (; i + W <= n; i += W) {                                              \
+      typename P::reg a0 = (F == Form::SV) ? sa : P::load(a + i);             \
+      typename P::reg b0 = (F == Form::VS) ? sb : P::load(b + i);             \
+      P::store(out + i, P::template op<OP>(a0, b0));                          \
+    }                                                                         \
+    for (; i < n; i++) {                                                      \
+      T x = (F == Form::SV) ? *a : a[i];                                      \
+      T y = (F == Form::VS) ? *b : b[i];                                      \
+      out[i] = apply<OP>(x, y);                                               \
+    }                                                                         \
+  }                                                                           \
+  }
+
+BRAINSIM_SIMD_BINARY(sse42, "sse4.2", __m128, __m128d, _mm)
+BRAINSIM_SIMD_BINARY(avx2, "avx2", __m256, __m256d, _mm256)
+BRAINSIM_SIMD_BINARY(avx512, "avx512f", __m512, __m512d, _mm512)
+
+#undef BRAINSIM_SIMD_BINARY
+#undef BRAINSIM_SIMD_PACKET
+
+#endif // BRAINSIM_SIMD_X86
+
+/*******************************************************
+ * Dispatch
+ *******************************************************/
+
+template <typename T>
+constexpr bool has_kernels =
+    std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// out[i] = a[i] (op) b[i], with a or b broadcast according to the Form
+template <BinOp OP, Form F, typename T>
+void binary(const T *a, const T *b, T *out, size_t n) {
+#if BRAINSIM_SIMD_X86
+  if constexpr (has_kernels<T>) {
+    switch (active_isa()) {
+    case Isa::AVX512:
+      return avx512::binary<OP, F>(a, b, out, n);
+    case Isa::AVX2:
+      return avx2::binary<OP, F>(a, b, out, n);
+    case Isa::SSE42:
+      return sse42::binary<OP, F>(a, b, out, n);
+    default:
+      break;
+    }
+  }
+#endif
+  scalar::binary<OP, F>(a, b, out, n);
+}
+
+} // namespace Simd
+} // namespace Math
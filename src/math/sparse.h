@@ -0,0 +1,284 @@
+#pragma once
+#include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "aligned_allocator.h"
+#include "matrix.h"
+#include "matrix_linalg.h"
+#include "shape.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/********************************************************************************
+ *
+ * SparseMatrix: a 2D matrix in CSR (compressed sparse row) format
+ *
+ * Row i keeps its non-zeros in [rowPtr[i], rowPtr[i + 1]) of colIdx / values,
+ * with increasing column indices:
+ *
+ *   auto X = SparseMatrix<float>::from_dense(features);   // drop the zeros
+ *   Matrix<float> Y = Linalg::spmm(X, W);                 // O(nnz * N)
+ *
+ * Meant for inputs that are mostly zeros (pixels, bag-of-features): the first
+ * Dense layer accepts it directly, see Layer::Dense.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+template <typename T> class SparseMatrix {
+public:
+  using value_type = T;
+
+  SparseMatrix() : rowPtr_(1, 0) {}
+  SparseMatrix(int rows, int cols, std::vector<int> rowPtr,
+               std::vector<int> colIdx, AlignedVector<T> values);
+
+  // Keep the entries of `dense` with |x| > threshold
+  template <typename U>
+  static SparseMatrix<T> from_dense(const Matrix<U> &dense, T threshold = 0);
+
+  Matrix<T> to_dense() const;
+
+  // Copy of the given rows, in that order
+  SparseMatrix<T> gather_rows(const std::vector<size_t> &rows) const;
+  SparseMatrix<T> slice_rows(size_t begin, size_t end) const;
+
+  int rows() const { return shape_[0]; }
+  int cols() const { return shape_[1]; }
+  const Shape &shape() const { return shape_; }
+  size_t nnz() const { return values_.size(); }
+  // Fraction of the entries that are stored
+  double density() const {
+    size_t total = (size_t)rows() * cols();
+    return total ? (double)nnz() / (double)total : 0.0;
+  }
+
+  const std::vector<int> &row_ptr() const { return rowPtr_; }
+  const std::vector<int> &col_idx() const { return colIdx_; }
+  const AlignedVector<T> &values() const { return values_; }
+
+private:
+  Shape shape_;
+  std::vector<int> rowPtr_;
+  std::vector<int> colIdx_;
+  AlignedVector<T> values_;
+};
+
+template <typename T>
+SparseMatrix<T>::SparseMatrix(int rows, int cols, std::vector<int> rowPtr,
+                              std::vector<int> colIdx, AlignedVector<T> values)
+    : shape_(rows, cols), rowPtr_(std::move(rowPtr)),
+      colIdx_(std::move(colIdx)), values_(std::move(values)) {
+  assert_lineq(rows, 0, "SparseMatrix::Const::Negative rows");
+  assert_lineq(cols, 0, "SparseMatrix::Const::Negative cols");
+  assert_eq(rowPtr_.size(), (size_t)rows + 1,
+            "SparseMatrix::Const::rowPtr must have rows + 1 entries");
+  assert_eq(colIdx_.size(), values_.size(),
+            "SparseMatrix::Const::colIdx and values differ in size");
+  assert_eq((size_t)rowPtr_.back(), values_.size(),
+            "SparseMatrix::Const::rowPtr does not end at nnz");
+
+  for (int i = 0; i < rows; i++) {
+    if (rowPtr_[i] < 0 || rowPtr_[i] > rowPtr_[i + 1]) {
+      throw std::invalid_argument("SparseMatrix::Const::rowPtr must be "
+                                  "non-decreasing");
+    }
+    for (int p = rowPtr_[i]; p < rowPtr_[i + 1]; p++) {
+      bool sorted = p == rowPtr_[i] || colIdx_[p - 1] < colIdx_[p];
+      if (colIdx_[p] < 0 || colIdx_[p] >= cols || !sorted) {
+        throw std::invalid_argument("SparseMatrix::Const::Column index out of "
+                                    "range or unsorted in row " +
+                                    std::to_string(i));
+      }
+    }
+  }
+}
+
+template <typename T>
+template <typename U>
+SparseMatrix<T> SparseMatrix<T>::from_dense(const Matrix<U> &dense,
+                                            T threshold) {
+  int rows = dense.shape()[0];
+  int cols = dense.shape()[1];
+  const U *src = dense.data_ptr();
+
+  std::vector<int> rowPtr(rows + 1, 0);
+  std::vector<int> colIdx;
+  AlignedVector<T> values;
+
+  for (int i = 0; i < rows; i++) {
+    const U *row = src + (size_t)i * cols;
+    for (int j = 0; j < cols; j++) {
+      T v = (T)row[j];
+      if (v > threshold || v < -threshold) {
+        colIdx.push_back(j);
+        values.push_back(v);
+      }
+    }
+    rowPtr[i + 1] = (int)values.size();
+  }
+
+  SparseMatrix<T> out;
+  out.shape_ = Shape(rows, cols);
+  out.rowPtr_ = std::move(rowPtr);
+  out.colIdx_ = std::move(colIdx);
+  out.values_ = std::move(values);
+  return out;
+}
+
+template <typename T> Matrix<T> SparseMatrix<T>::to_dense() const {
+  AlignedVector<T> dense((size_t)rows() * cols(), (T)0);
+  for (int i = 0; i < rows(); i++) {
+    T *row = dense.data() + (size_t)i * cols();
+    for (int p = rowPtr_[i]; p < rowPtr_[i + 1]; p++) {
+      row[colIdx_[p]] = values_[p];
+    }
+  }
+  return Matrix<T>(std::move(dense), shape_);
+}
+
+template <typename T>
+SparseMatrix<T>
+SparseMatrix<T>::gather_rows(const std::vector<size_t> &rows) const {
+  std::vector<int> rowPtr(rows.size() + 1, 0);
+  for (size_t r = 0; r < rows.size(); r++) {
+    assert_lt(rows[r], (size_t)this->rows(), "SparseMatrix::gather_rows");
+    size_t i = rows[r];
+    rowPtr[r + 1] = rowPtr[r] + (rowPtr_[i + 1] - rowPtr_[i]);
+  }
+
+  std::vector<int> colIdx(rowPtr.back());
+  AlignedVector<T> values(rowPtr.back());
+  for (size_t r = 0; r < rows.size(); r++) {
+    size_t i = rows[r];
+    std::copy(colIdx_.begin() + rowPtr_[i], colIdx_.begin() + rowPtr_[i + 1],
+              colIdx.begin() + rowPtr[r]);
+    std::copy(values_.begin() + rowPtr_[i], values_.begin() + rowPtr_[i + 1],
+              values.begin() + rowPtr[r]);
+  }
+
+  SparseMatrix<T> out;
+  out.shape_ = Shape((int)rows.size(), cols());
+  out.rowPtr_ = std::move(rowPtr);
+  out.colIdx_ = std::move(colIdx);
+  out.values_ = std::move(values);
+  return out;
+}
+
+template <typename T>
+SparseMatrix<T> SparseMatrix<T>::slice_rows(size_t begin, size_t end) const {
+  if (begin > end || end > (size_t)rows()) {
+    throw std::out_of_range("SparseMatrix::slice_rows::Invalid row range");
+  }
+  std::vector<size_t> rows(end - begin);
+  for (size_t i = begin; i < end; i++) {
+    rows[i - begin] = i;
+  }
+  return gather_rows(rows);
+}
+
+namespace Linalg {
+
+// out = a * b, a sparse (M x K), b dense (K x N). Each row of out adds the
+// rows of b selected by the non-zeros of a, so the cost is O(nnz(a) * N).
+template <typename T>
+void spmm(const SparseMatrix<T> &a, const ViewArg<T> &b, Matrix<T> &out) {
+  assert_eq(a.cols(), b.rows(),
+            "Matrix::Linalg::Spmm::ValueError::Dimesion mistmatch (cols A != "
+            "rows B)");
+  assert_no_alias(out, b, "Matrix::Linalg::Spmm");
+
+  int M = a.rows();
+  int N = b.cols();
+  size_t ldb = b.ld();
+  out.resize(M, N);
+
+  const int *rowPtr = a.row_ptr().data();
+  const int *colIdx = a.col_idx().data();
+  const T *values = a.values().data();
+  const T *pB = b.data_ptr();
+  T *pOut = out.data_ptr();
+
+  size_t avgRow = M ? a.nnz() / (size_t)M + 1 : 1;
+  Utils::parallel_for(0, (size_t)M, Utils::grain_for(avgRow * N),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t i = lo; i < hi; i++) {
+                          T *c = pOut + i * N;
+                          std::fill(c, c + N, (T)0);
+                          for (int p = rowPtr[i]; p < rowPtr[i + 1]; p++) {
+                            const T v = values[p];
+                            const T *bRow = pB + (size_t)colIdx[p] * ldb;
+#pragma omp simd
+                            for (int j = 0; j < N; j++) {
+                              c[j] += v * bRow[j];
+                            }
+                          }
+                        }
+                      });
+}
+
+template <typename T>
+Matrix<T> spmm(const SparseMatrix<T> &a, const Matrix<T> &b) {
+  Matrix<T> out;
+  spmm<T>(a, b, out);
+  return out;
+}
+
+// out = a^T * b, a sparse (M x K), b dense (M x N), out (K x N). Only the rows
+// of out whose column of a has non-zeros are accumulated; the rest are zero.
+// Work is split over column blocks of out, so threads never share a row.
+template <typename T>
+void spmm_tn(const SparseMatrix<T> &a, const ViewArg<T> &b, Matrix<T> &out) {
+  assert_eq(a.rows(), b.rows(),
+            "Matrix::Linalg::SpmmTN::ValueError::Dimesion mistmatch (rows A "
+            "!= rows B)");
+  assert_no_alias(out, b, "Matrix::Linalg::SpmmTN");
+
+  int M = a.rows();
+  int K = a.cols();
+  int N = b.cols();
+  size_t ldb = b.ld();
+  out.resize(K, N);
+  std::fill(out.data_ptr(), out.data_ptr() + out.size(), (T)0);
+
+  const int *rowPtr = a.row_ptr().data();
+  const int *colIdx = a.col_idx().data();
+  const T *values = a.values().data();
+  const T *pB = b.data_ptr();
+  T *pOut = out.data_ptr();
+
+  // Blocks of 64 columns keep each block's row segments in whole cache lines
+  const size_t BLOCK = 64;
+  size_t blocks = ((size_t)N + BLOCK - 1) / BLOCK;
+  Utils::parallel_for(
+      0, blocks, Utils::grain_for(a.nnz() * BLOCK), [&](size_t lo, size_t hi) {
+        for (size_t blk = lo; blk < hi; blk++) {
+          int j0 = (int)(blk * BLOCK);
+          int j1 = std::min(N, j0 + (int)BLOCK);
+          for (int i = 0; i < M; i++) {
+            const T *bRow = pB + (size_t)i * ldb;
+            for (int p = rowPtr[i]; p < rowPtr[i + 1]; p++) {
+              const T v = values[p];
+              T *c = pOut + (size_t)colIdx[p] * N;
+#pragma omp simd
+              for (int j = j0; j < j1; j++) {
+                c[j] += v * bRow[j];
+              }
+            }
+          }
+        }
+      });
+}
+
+template <typename T>
+Matrix<T> spmm_tn(const SparseMatrix<T> &a, const Matrix<T> &b) {
+  Matrix<T> out;
+  spmm_tn<T>(a, b, out);
+  return out;
+}
+
+} // namespace Linalg
+} // namespace Math
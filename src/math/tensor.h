@@ -0,0 +1,443 @@
+#pragma once
+#include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "aligned_allocator.h"
+#include "gemm.h"
+#include "matrix.h"
+#include "matrix_view.h"
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/********************************************************************************
+ *
+ * Tensor: N-dimensional strided array
+ *
+ * A Tensor is a shared buffer plus dims, strides (in elements) and an offset.
+ * Slicing, selecting, permuting and (on contiguous data) reshaping return
+ * views over the same buffer, no copy:
+ *
+ *   Tensor<float> images({64, 3, 28, 28});            // N x C x H x W
+ *   auto red = images.select(1, 0);                   // N x H x W view
+ *   auto nhwc = images.permute({0, 2, 3, 1});         // N x H x W x C view
+ *   Tensor<float> packed = nhwc.contiguous();         // explicit copy
+ *
+ * A 2-D tensor with unit column stride is a MatrixView (matrix()), so every
+ * Linalg kernel reads it in place; Linalg::bmm runs batched GEMM on 3-D
+ * tensors. Matrix stays the owning 2-D type used by the network.
+ *
+ ********************************************************************************/
+
+namespace Math {
+
+template <typename T> class Tensor {
+public:
+  using value_type = T;
+
+  // Empty 1-D tensor, no buffer
+  Tensor() : dims_{0}, strides_{1}, offset_(0) {}
+  // Zero-filled, contiguous
+  explicit Tensor(const std::vector<int> &dims);
+  // Take ownership of a row-major buffer
+  Tensor(AlignedVector<T> data, const std::vector<int> &dims);
+  // Copy of a Matrix (or a view of one) as a 2-D tensor
+  explicit Tensor(const MatrixView<T> &m);
+
+  size_t rank() const { return dims_.size(); }
+  int dim(size_t axis) const { return dims_.at(axis); }
+  const std::vector<int> &dims() const { return dims_; }
+  const std::vector<ptrdiff_t> &strides() const { return strides_; }
+  size_t offset() const { return offset_; }
+  size_t size() const;
+  bool is_contiguous() const;
+  // True when both tensors read the same buffer
+  bool shares_storage(const Tensor<T> &other) const {
+    return storage_ && storage_ == other.storage_;
+  }
+
+  // nullptr for a default-constructed tensor, it has no buffer
+  const T *data_ptr() const {
+    return storage_ ? storage_->data() + offset_ : nullptr;
+  }
+  T *data_ptr() { return storage_ ? storage_->data() + offset_ : nullptr; }
+
+  T at(const std::vector<int> &index) const {
+    return storage_->data()[_position(index)];
+  }
+  T &at(const std::vector<int> &index) {
+    return storage_->data()[_position(index)];
+  }
+
+  // Views over the same buffer
+  Tensor<T> slice(size_t axis, int begin, int end) const;
+  Tensor<T> select(size_t axis, int index) const;
+  Tensor<T> permute(const std::vector<size_t> &order) const;
+  Tensor<T> transpose(size_t a, size_t b) const;
+  // A view when contiguous, else a packed copy. One dimension may be -1.
+  Tensor<T> reshape(std::vector<int> dims) const;
+
+  // Packed row-major copy (this tensor itself when already packed)
+  Tensor<T> contiguous() const;
+  Tensor<T> clone() const;
+  void fill(T value);
+
+  // 2-D tensors with unit column stride, read in place
+  MatrixView<T> matrix() const;
+  Matrix<T> to_matrix() const;
+
+  // Call f(offset of the first element, offset step) once per innermost row
+  template <typename F> void for_each_row(F &&f) const;
+
+private:
+  std::shared_ptr<AlignedVector<T>> storage_;
+  std::vector<int> dims_;
+  std::vector<ptrdiff_t> strides_;
+  size_t offset_;
+
+  static std::vector<ptrdiff_t> _packed_strides(const std::vector<int> &dims);
+  size_t _position(const std::vector<int> &index) const;
+  void _check_axis(size_t axis, const std::string &context) const {
+    assert_lt(axis, rank(), context);
+  }
+};
+
+template <typename T>
+std::vector<ptrdiff_t>
+Tensor<T>::_packed_strides(const std::vector<int> &dims) {
+  std::vector<ptrdiff_t> strides(dims.size());
+  ptrdiff_t step = 1;
+  for (size_t i = dims.size(); i-- > 0;) {
+    assert_lineq(dims[i], 0, "Tensor: dimensions cannot be negative.");
+    strides[i] = step;
+    step *= dims[i];
+  }
+  return strides;
+}
+
+template <typename T>
+Tensor<T>::Tensor(const std::vector<int> &dims)
+    : dims_(dims), strides_(_packed_strides(dims)), offset_(0) {
+  storage_ = std::make_shared<AlignedVector<T>>(size(), (T)0);
+}
+
+template <typename T>
+Tensor<T>::Tensor(AlignedVector<T> data, const std::vector<int> &dims)
+    : dims_(dims), strides_(_packed_strides(dims)), offset_(0) {
+  assert_eq(data.size(), size(), "Tensor::Const::ValueError.");
+  storage_ = std::make_shared<AlignedVector<T>>(std::move(data));
+}
+
+template <typename T>
+Tensor<T>::Tensor(const MatrixView<T> &m) : Tensor({m.rows(), m.cols()}) {
+  T *dst = storage_->data();
+  for (int i = 0; i < m.rows(); i++) {
+    const T *src = m.data_ptr() + (size_t)i * m.ld();
+    std::copy(src, src + m.cols(), dst + (size_t)i * m.cols());
+  }
+}
+
+template <typename T> size_t Tensor<T>::size() const {
+  size_t total = 1;
+  for (int d : dims_) {
+    total *= (size_t)d;
+  }
+  return total;
+}
+
+template <typename T> bool Tensor<T>::is_contiguous() const {
+  ptrdiff_t step = 1;
+  for (size_t i = rank(); i-- > 0;) {
+    if (dims_[i] != 1 && strides_[i] != step) {
+      return false;
+    }
+    step *= dims_[i];
+  }
+  return true;
+}
+
+template <typename T>
+size_t Tensor<T>::_position(const std::vector<int> &index) const {
+  assert_eq(index.size(), rank(), "Tensor::at::Wrong number of indices");
+  ptrdiff_t pos = (ptrdiff_t)offset_;
+  for (size_t i = 0; i < rank(); i++) {
+    if (index[i] < 0 || index[i] >= dims_[i]) {
+      throw std::out_of_range("Tensor::at::Index out of range on axis " +
+                              std::to_string(i));
+    }
+    pos += (ptrdiff_t)index[i] * strides_[i];
+  }
+  return (size_t)pos;
+}
+
+/*******************************************************
+ * Views
+ *******************************************************/
+
+template <typename T>
+Tensor<T> Tensor<T>::slice(size_t axis, int begin, int end) const {
+  _check_axis(axis, "Tensor::slice");
+  if (begin < 0 || begin > end || end > dims_[axis]) {
+    throw std::out_of_range("Tensor::slice::Invalid range");
+  }
+  Tensor<T> view = *this;
+  view.offset_ += (size_t)((ptrdiff_t)begin * strides_[axis]);
+  view.dims_[axis] = end - begin;
+  return view;
+}
+
+template <typename T>
+Tensor<T> Tensor<T>::select(size_t axis, int index) const {
+  _check_axis(axis, "Tensor::select");
+  if (index < 0 || index >= dims_[axis]) {
+    throw std::out_of_range("Tensor::select::Index out of range");
+  }
+  Tensor<T> view = *this;
+  view.offset_ += (size_t)((ptrdiff_t)index * strides_[axis]);
+  view.dims_.erase(view.dims_.begin() + axis);
+  view.strides_.erase(view.strides_.begin() + axis);
+  return view;
+}
+
+template <typename T>
+Tensor<T> Tensor<T>::permute(const std::vector<size_t> &order) const {
+  assert_eq(order.size(), rank(), "Tensor::permute::Wrong number of axes");
+  std::vector<bool> seen(rank(), false);
+  Tensor<T> view = *this;
+  for (size_t i = 0; i < rank(); i++) {
+    _check_axis(order[i], "Tensor::permute");
+    if (seen[order[i]]) {
+      throw std::invalid_argument("Tensor::permute::Repeated axis");
+    }
+    seen[order[i]] = true;
+    view.dims_[i] = dims_[order[i]];
+    view.strides_[i] = strides_[order[i]];
+  }
+  return view;
+}
+
+template <typename T>
+Tensor<T> Tensor<T>::transpose(size_t a, size_t b) const {
+  std::vector<size_t> order(rank());
+  std::iota(order.begin(), order.end(), 0);
+  _check_axis(a, "Tensor::transpose");
+  _check_axis(b, "Tensor::transpose");
+  std::swap(order[a], order[b]);
+  return permute(order);
+}
+
+template <typename T> Tensor<T> Tensor<T>::reshape(std::vector<int> dims) const {
+  size_t known = 1;
+  int inferred = -1;
+  for (size_t i = 0; i < dims.size(); i++) {
+    if (dims[i] == -1) {
+      if (inferred != -1) {
+        throw std::invalid_argument("Tensor::reshape::Only one -1 allowed");
+      }
+      inferred = (int)i;
+    } else {
+      assert_lineq(dims[i], 0, "Tensor::reshape::Negative dimension");
+      known *= (size_t)dims[i];
+    }
+  }
+  if (inferred != -1) {
+    if (known == 0 || size() % known != 0) {
+      throw std::invalid_argument("Tensor::reshape::Cannot infer dimension");
+    }
+    dims[inferred] = (int)(size() / known);
+    known *= (size_t)dims[inferred];
+  }
+  assert_eq(known, size(), "Tensor::reshape::Size mismatch");
+
+  Tensor<T> packed = contiguous();
+  packed.dims_ = dims;
+  packed.strides_ = _packed_strides(dims);
+  return packed;
+}
+
+/*******************************************************
+ * Copies
+ *******************************************************/
+
+template <typename T>
+template <typename F>
+void Tensor<T>::for_each_row(F &&f) const {
+  if (size() == 0) {
+    return;
+  }
+  // A scalar is a single row of one element
+  if (rank() == 0) {
+    f(offset_, 1);
+    return;
+  }
+  if (rank() == 1) {
+    f(offset_, strides_[0]);
+    return;
+  }
+  // Odometer over every axis but the last
+  std::vector<int> index(rank() - 1, 0);
+  ptrdiff_t pos = (ptrdiff_t)offset_;
+  while (true) {
+    f((size_t)pos, strides_.back());
+
+    size_t axis = rank() - 1;
+    while (axis-- > 0) {
+      if (++index[axis] < dims_[axis]) {
+        pos += strides_[axis];
+        break;
+      }
+      pos -= (ptrdiff_t)(dims_[axis] - 1) * strides_[axis];
+      index[axis] = 0;
+      if (axis == 0) {
+        return;
+      }
+    }
+  }
+}
+
+template <typename T> Tensor<T> Tensor<T>::clone() const {
+  Tensor<T> out(dims_);
+  T *dst = out.storage_->data();
+  const T *src = storage_ ? storage_->data() : nullptr;
+  size_t n = rank() ? (size_t)dims_.back() : 1;
+  for_each_row([&](size_t pos, ptrdiff_t step) {
+    if (step == 1) {
+      std::copy(src + pos, src + pos + n, dst);
+    } else {
+      for (size_t j = 0; j < n; j++) {
+        dst[j] = src[(ptrdiff_t)pos + (ptrdiff_t)j * step];
+      }
+    }
+    dst += n;
+  });
+  return out;
+}
+
+template <typename T> Tensor<T> Tensor<T>::contiguous() const {
+  return is_contiguous() ? *this : clone();
+}
+
+template <typename T> void Tensor<T>::fill(T value) {
+  if (size() == 0) {
+    return;
+  }
+  T *data = storage_->data();
+  size_t n = rank() ? (size_t)dims_.back() : 1;
+  for_each_row([&](size_t pos, ptrdiff_t step) {
+    for (size_t j = 0; j < n; j++) {
+      data[(ptrdiff_t)pos + (ptrdiff_t)j * step] = value;
+    }
+  });
+}
+
+template <typename T> MatrixView<T> Tensor<T>::matrix() const {
+  assert_eq(rank(), (size_t)2, "Tensor::matrix::Tensor must be 2-D");
+  if (dims_[1] > 1 && strides_[1] != 1) {
+    throw std::invalid_argument(
+        "Tensor::matrix::Columns must be contiguous, call contiguous() first");
+  }
+  size_t ld = dims_[0] > 1 ? (size_t)strides_[0] : (size_t)dims_[1];
+  return MatrixView<T>(data_ptr(), dims_[0], dims_[1], ld);
+}
+
+template <typename T> Matrix<T> Tensor<T>::to_matrix() const {
+  assert_eq(rank(), (size_t)2, "Tensor::to_matrix::Tensor must be 2-D");
+  Tensor<T> packed = contiguous();
+  return Matrix<T>(AlignedVector<T>(packed.data_ptr(),
+                                    packed.data_ptr() + packed.size()),
+                   {dims_[0], dims_[1]});
+}
+
+template <typename T>
+std::ostream &operator<<(std::ostream &os, const Tensor<T> &tensor) {
+  Tensor<T> packed = tensor.contiguous();
+  os << "Tensor(";
+  const T *data = packed.data_ptr();
+  for (size_t i = 0; i < packed.size(); i++) {
+    os << (i ? ", " : "") << data[i];
+  }
+  os << ", shape=(";
+  for (size_t i = 0; i < tensor.rank(); i++) {
+    os << (i ? ", " : "") << tensor.dim(i);
+  }
+  return os << "))";
+}
+
+/*******************************************************
+ * Batched GEMM
+ *******************************************************/
+
+namespace Linalg {
+
+namespace detail {
+// A 2-D slice as a GEMM operand: row-major (unit column stride) or
+// column-major (unit row stride, read transposed). Other layouts are packed.
+template <typename T> struct GemmOperand {
+  Tensor<T> packed;
+  Gemm::Trans trans;
+  const T *ptr;
+  int ld;
+
+  explicit GemmOperand(const Tensor<T> &m) {
+    int rows = m.dim(0), cols = m.dim(1);
+    const auto &st = m.strides();
+    if ((cols <= 1 || st[1] == 1) && (rows <= 1 || st[0] >= cols)) {
+      trans = Gemm::Trans::No;
+      ptr = m.data_ptr();
+      ld = rows > 1 ? (int)st[0] : std::max(1, cols);
+    } else if ((rows <= 1 || st[0] == 1) && (cols <= 1 || st[1] >= rows)) {
+      trans = Gemm::Trans::Yes;
+      ptr = m.data_ptr();
+      ld = cols > 1 ? (int)st[1] : std::max(1, rows);
+    } else {
+      packed = m.contiguous();
+      trans = Gemm::Trans::No;
+      ptr = packed.data_ptr();
+      ld = std::max(1, cols);
+    }
+  }
+};
+} // namespace detail
+
+// C[i] = A[i] * B[i] for 3-D A (batch x M x K) and B (batch x K x N), or a
+// 2-D B shared by every batch. Strided and permuted slices are read in place
+// when their rows or columns are contiguous. Returns a packed batch x M x N.
+template <typename T> Tensor<T> bmm(const Tensor<T> &a, const Tensor<T> &b) {
+  assert_eq(a.rank(), (size_t)3, "Linalg::bmm::A must be 3-D");
+  if (b.rank() != 2 && b.rank() != 3) {
+    throw std::invalid_argument("Linalg::bmm::B must be 2-D or 3-D");
+  }
+  bool shared = b.rank() == 2;
+  int batch = a.dim(0), M = a.dim(1), K = a.dim(2);
+  int N = b.dim(b.rank() - 1);
+  assert_eq(b.dim(b.rank() - 2), K, "Linalg::bmm::Inner dimensions differ");
+  if (!shared) {
+    assert_eq(b.dim(0), batch, "Linalg::bmm::Batch sizes differ");
+  }
+
+  Tensor<T> c({batch, M, N});
+  T *pC = c.data_ptr();
+
+  // Batches in parallel; each GEMM then runs on its own thread
+  size_t work = (size_t)M * N * std::max(1, K);
+  Utils::parallel_for(0, (size_t)batch, Utils::grain_for(work),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t i = lo; i < hi; i++) {
+                          detail::GemmOperand<T> A(a.select(0, (int)i));
+                          detail::GemmOperand<T> B(
+                              shared ? b : b.select(0, (int)i));
+                          Gemm::gemm(A.trans, B.trans, M, N, K, (T)1, A.ptr,
+                                     A.ld, B.ptr, B.ld, (T)0,
+                                     pC + i * (size_t)M * N, N);
+                        }
+                      });
+  return c;
+}
+
+} // namespace Linalg
+} // namespace Math
@@ -0,0 +1,241 @@
+#pragma once
+#include "../utils/thread_pool.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+/********************************************************************************
+ *
+ * Cache-blocked transpose kernels
+ *
+ * The matrix is cut in TILE x TILE tiles (a float tile and its transposed copy
+ * fit in L1 together). Inside a tile, square blocks are transposed in
+ * registers with the widest instruction set available (runtime dispatch, see
+ * simd.h):
+ *
+ *   AVX2 / AVX-512   float 8x8, double 4x4
+ *   SSE4.2           float 4x4, double 2x2
+ *
+ * Rows and columns left over by the blocks are copied one by one. Bands of
+ * tiles run in parallel; every task writes its own rows of the output.
+ *
+ ********************************************************************************/
+
+namespace Math {
+namespace Transpose {
+
+constexpr size_t TILE = 32;
+
+namespace detail {
+
+// dst[j][i] = src[i][j] for a rows x cols block
+template <typename T>
+void scalar_block(const T *src, size_t lds, T *dst, size_t ldd, size_t rows,
+                  size_t cols) {
+  for (size_t i = 0; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) {
+      dst[j * ldd + i] = src[i * lds + j];
+    }
+  }
+}
+
+// One tile with B x B register blocks, leftovers copied one by one
+#define BRAINSIM_TRANSPOSE_TILE(NAME, TARGET, T, B, MICRO)                    \
+  __attribute__((target(TARGET))) inline void NAME(                           \
+      const T *src, size_t lds, T *dst, size_t ldd, size_t rows,              \
+      size_t cols) {                                                          \
+    size_t i = 0;                                                             \
+    for (; i + B <= rows; i += B) {                                           \
+      size_t j = 0;                                                           \
+      for (; j + B <= cols; j += B) {                                         \
+        MICRO(src + i * lds + j, lds, dst + j * ldd + i, ldd);                \
+      }                                                                       \
+      scalar_block(src + i * lds + j, lds, dst + j * ldd + i, ldd, B,         \
+                   cols - j);                                                 \
+    }                                                                         \
+    scalar_block(src + i * lds, lds, dst + i, ldd, rows - i, cols);           \
+  }
+
+#if BRAINSIM_SIMD_X86
+
+__attribute__((target("avx2"))) inline void
+micro_avx_f32(const float *s, size_t lds, float *d, size_t ldd) {
+  __m256 r0 = _mm256_loadu_ps(s + 0 * lds);
+  __m256 r1 = _mm256_loadu_ps(s + 1 * lds);
+  __m256 r2 = _mm256_loadu_ps(s + 2 * lds);
+  __m256 r3 = _mm256_loadu_ps(s + 3 * lds);
+  __m256 r4 = _mm256_loadu_ps(s + 4 * lds);
+  __m256 r5 = _mm256_loadu_ps(s + 5 * lds);
+  __m256 r6 = _mm256_loadu_ps(s + 6 * lds);
+  __m256 r7 = _mm256_loadu_ps(s + 7 * lds);
+
+  // Pairs of rows interleaved, then 4-element groups, then 128-bit halves
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+  __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+  _mm256_storeu_ps(d + 0 * ldd, _mm256_permute2f128_ps(u0, u4, 0x20));
+  _mm256_storeu_ps(d + 1 * ldd, _mm256_permute2f128_ps(u1, u5, 0x20));
+  _mm256_storeu_ps(d + 2 * ldd, _mm256_permute2f128_ps(u2, u6, 0x20));
+  _mm256_storeu_ps(d + 3 * ldd, _mm256_permute2f128_ps(u3, u7, 0x20));
+  _mm256_storeu_ps(d + 4 * ldd, _mm256_permute2f128_ps(u0, u4, 0x31));
+  _mm256_storeu_ps(d + 5 * ldd, _mm256_permute2f128_ps(u1, u5, 0x31));
+  _mm256_storeu_ps(d + 6 * ldd, _mm256_permute2f128_ps(u2, u6, 0x31));
+  _mm256_storeu_ps(d + 7 * ldd, _mm256_permute2f128_ps(u3, u7, 0x31));
+}
+
+__attribute__((target("avx2"))) inline void
+micro_avx_f64(const double *s, size_t lds, double *d, size_t ldd) {
+  __m256d r0 = _mm256_loadu_pd(s + 0 * lds);
+  __m256d r1 = _mm256_loadu_pd(s + 1 * lds);
+  __m256d r2 = _mm256_loadu_pd(s + 2 * lds);
+  __m256d r3 = _mm256_loadu_pd(s + 3 * lds);
+
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+  _mm256_storeu_pd(d + 0 * ldd, _mm256_permute2f128_pd(t0, t2, 0x20));
+  _mm256_storeu_pd(d + 1 * ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+  _mm256_storeu_pd(d + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+  _mm256_storeu_pd(d + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+__attribute__((target("sse4.2"))) inline void
+micro_sse_f32(const float *s, size_t lds, float *d, size_t ldd) {
+  __m128 r0 = _mm_loadu_ps(s + 0 * lds);
+  __m128 r1 = _mm_loadu_ps(s + 1 * lds);
+  __m128 r2 = _mm_loadu_ps(s + 2 * lds);
+  __m128 r3 = _mm_loadu_ps(s + 3 * lds);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(d + 0 * ldd, r0);
+  _mm_storeu_ps(d + 1 * ldd, r1);
+  _mm_storeu_ps(d + 2 * ldd, r2);
+  _mm_storeu_ps(d + 3 * ldd, r3);
+}
+
+__attribute__((target("sse4.2"))) inline void
+micro_sse_f64(const double *s, size_t lds, double *d, size_t ldd) {
+  __m128d r0 = _mm_loadu_pd(s);
+  __m128d r1 = _mm_loadu_pd(s + lds);
+  _mm_storeu_pd(d, _mm_unpacklo_pd(r0, r1));
+  _mm_storeu_pd(d + ldd, _mm_unpackhi_pd(r0, r1));
+}
+
+BRAINSIM_TRANSPOSE_TILE(tile_avx_f32, "avx2", float, 8, micro_avx_f32)
+BRAINSIM_TRANSPOSE_TILE(tile_avx_f64, "avx2", double, 4, micro_avx_f64)
+BRAINSIM_TRANSPOSE_TILE(tile_sse_f32, "sse4.2", float, 4, micro_sse_f32)
+BRAINSIM_TRANSPOSE_TILE(tile_sse_f64, "sse4.2", double, 2, micro_sse_f64)
+
+#endif // BRAINSIM_SIMD_X86
+
+#undef BRAINSIM_TRANSPOSE_TILE
+
+// Transpose one tile (rows, cols <= TILE) with the active instruction set
+template <typename T>
+void tile(const T *src, size_t lds, T *dst, size_t ldd, size_t rows,
+          size_t cols) {
+#if BRAINSIM_SIMD_X86
+  Simd::Isa isa = Simd::active_isa();
+  bool avx = isa == Simd::Isa::AVX512 || isa == Simd::Isa::AVX2;
+  bool sse = isa == Simd::Isa::SSE42;
+  if constexpr (std::is_same_v<T, float>) {
+    if (avx) {
+      return tile_avx_f32(src, lds, dst, ldd, rows, cols);
+    }
+    if (sse) {
+      return tile_sse_f32(src, lds, dst, ldd, rows, cols);
+    }
+  } else if constexpr (std::is_same_v<T, double>) {
+    if (avx) {
+      return tile_avx_f64(src, lds, dst, ldd, rows, cols);
+    }
+    if (sse) {
+      return tile_sse_f64(src, lds, dst, ldd, rows, cols);
+    }
+  }
+#endif
+  scalar_block(src, lds, dst, ldd, rows, cols);
+}
+
+} // namespace detail
+
+// dst (cols x rows, leading dimension ldd) = transpose of src (rows x cols,
+// leading dimension lds). The two buffers must not overlap.
+template <typename T>
+void out_of_place(const T *src, size_t rows, size_t cols, size_t lds, T *dst,
+                  size_t ldd) {
+  // One task per band of TILE source columns: it owns TILE rows of dst
+  size_t bands = (cols + TILE - 1) / TILE;
+  Utils::parallel_for(0, bands, Utils::grain_for(rows * TILE),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t b = lo; b < hi; b++) {
+                          size_t j = b * TILE;
+                          size_t nc = std::min(TILE, cols - j);
+                          for (size_t i = 0; i < rows; i += TILE) {
+                            size_t nr = std::min(TILE, rows - i);
+                            detail::tile(src + i * lds + j, lds,
+                                         dst + j * ldd + i, ldd, nr, nc);
+                          }
+                        }
+                      });
+}
+
+// a (n x n, leading dimension ld) = its transpose, swapping pairs of tiles
+// across the diagonal through an L1-resident buffer
+template <typename T> void in_place_square(T *a, size_t n, size_t ld) {
+  size_t tiles = (n + TILE - 1) / TILE;
+
+  // Task t handles tile row t against the tiles right of the diagonal
+  Utils::parallel_for(
+      0, tiles, Utils::grain_for(n * TILE / 2), [&](size_t lo, size_t hi) {
+        alignas(64) T upper[TILE * TILE];
+        alignas(64) T lower[TILE * TILE];
+        for (size_t t = lo; t < hi; t++) {
+          size_t i = t * TILE;
+          size_t ni = std::min(TILE, n - i);
+
+          // Diagonal tile
+          detail::tile(a + i * ld + i, ld, upper, TILE, ni, ni);
+          for (size_t r = 0; r < ni; r++) {
+            std::copy(upper + r * TILE, upper + r * TILE + ni,
+                      a + (i + r) * ld + i);
+          }
+
+          for (size_t u = t + 1; u < tiles; u++) {
+            size_t j = u * TILE;
+            size_t nj = std::min(TILE, n - j);
+            T *ij = a + i * ld + j; // ni x nj
+            T *ji = a + j * ld + i; // nj x ni
+
+            detail::tile(ij, ld, upper, TILE, ni, nj); // nj x ni
+            detail::tile(ji, ld, lower, TILE, nj, ni); // ni x nj
+            for (size_t r = 0; r < nj; r++) {
+              std::copy(upper + r * TILE, upper + r * TILE + ni, ji + r * ld);
+            }
+            for (size_t r = 0; r < ni; r++) {
+              std::copy(lower + r * TILE, lower + r * TILE + nj, ij + r * ld);
+            }
+          }
+        }
+      });
+}
+
+} // namespace Transpose
+} // namespace Math
@@ -1,6 +1,9 @@
+#pragma once
 #include "../math/functions.h"
 #include "../math/matrix.h"
+#include "fused_dense.h"
 #include "ops.h"
+#include <typeinfo>
 #include <vector>
 
 namespace NN {
@@ -16,6 +19,10 @@ namespace ActFunc {
 
 template <typename T> class Sigmoid : public Ops::Operation<T> {
 public:
+  Ops::Fusable fusable() const override {
+    return typeid(*this) == typeid(Sigmoid) ? Ops::Fusable::Sigmoid
+                                            : Ops::Fusable::None;
+  }
   Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) override;
   Math::Matrix<T> _compute_output(void) override;
@@ -47,6 +54,10 @@ Sigmoid<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
 
 template <typename T> class Tanh : public Ops::Operation<T> {
 public:
+  Ops::Fusable fusable() const override {
+    return typeid(*this) == typeid(Tanh) ? Ops::Fusable::Tanh
+                                         : Ops::Fusable::None;
+  }
   Math::Matrix<T> _compute_output() override;
   Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) override;
@@ -80,6 +91,10 @@ Tanh<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
 
 template <typename T> class ReLU : public Ops::Operation<T> {
 public:
+  Ops::Fusable fusable() const override {
+    return typeid(*this) == typeid(ReLU) ? Ops::Fusable::ReLU
+                                         : Ops::Fusable::None;
+  }
   Math::Matrix<T> _compute_output() override;
   Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) override;
@@ -113,6 +128,10 @@ ReLU<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
 
 template <typename T> class Linear : public Ops::Operation<T> {
 public:
+  Ops::Fusable fusable() const override {
+    return typeid(*this) == typeid(Linear) ? Ops::Fusable::Linear
+                                           : Ops::Fusable::None;
+  }
   Math::Matrix<T> _compute_output() override;
   Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) override;
@@ -142,6 +161,10 @@ Linear<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
 
 template <typename T> class Softmax : public Ops::Operation<T> {
 public:
+  Ops::Fusable fusable() const override {
+    return typeid(*this) == typeid(Softmax) ? Ops::Fusable::Softmax
+                                            : Ops::Fusable::None;
+  }
   Math::Matrix<T> _compute_output() override;
   Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) override;
@@ -154,37 +177,13 @@ public:
  ********************************************************************/
 
 template <typename T> Math::Matrix<T> Softmax<T>::_compute_output() {
-  // Copia de entrada para no modificar la original
-  Math::Matrix<T> result = *this->input_;
-
-  int rows = result.shape()[0];
-  int cols = result.shape()[1];
-  const std::vector<T> &data = result.data();
-  std::vector<T> out(data.size());
-  T *pOut = out.data();
-
-  for (int i = 0; i < rows; ++i) {
-    int offset = i * cols;
-
-    T max_val = data[offset];
-    for (int j = 1; j < cols; ++j) {
-      if (data[offset + j] > max_val)
-        max_val = data[offset + j];
-    }
+  const Math::Matrix<T> &input = *this->input_;
 
-    // 2. Exponencial y Suma
-    T sum = (T)0;
-    for (int j = 0; j < cols; ++j) {
-      pOut[offset + j] = std::exp(data[offset + j] - max_val);
-      sum += pOut[offset + j];
-    }
+  Math::AlignedVector<T> out(input.size());
+  Fused::softmax_rows(input.data_ptr(), out.data(), (size_t)input.shape()[0],
+                      (size_t)input.shape()[1]);
 
-    // 3. Normalización
-    for (int j = 0; j < cols; ++j) {
-      pOut[offset + j] /= sum;
-    }
-  }
-  return {out, result.shape()};
+  return {std::move(out), input.shape()};
 }
 
 template <typename T>
@@ -192,10 +191,10 @@ Math::Matrix<T>
 Softmax<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
 
   const Math::Matrix<T> &y = *this->output_;
-  const std::vector<T> &y_data = y.data();
-  const std::vector<T> &grad_data = output_grad.data();
+  const Math::AlignedVector<T> &y_data = y.data();
+  const Math::AlignedVector<T> &grad_data = output_grad.data();
 
-  std::vector<T> input_grad_data(y_data.size());
+  Math::AlignedVector<T> input_grad_data(y_data.size());
 
   int rows = y.shape()[0];
   int cols = y.shape()[1];
@@ -215,7 +214,7 @@ Softmax<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
     }
   }
 
-  return Math::Matrix<T>(input_grad_data, {rows, cols});
+  return Math::Matrix<T>(std::move(input_grad_data), {rows, cols});
 }
 
 } // namespace ActFunc
@@ -2,8 +2,16 @@
 #include "../math/functions.h"
 #include "../math/matrix.h"
 #include "../math/matrix_linalg.h"
+#include "../math/reduce.h"
+#include "../math/simd.h"
+#include "../math/vmath.h"
 #include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "ops.h"
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace NN {
@@ -26,24 +34,72 @@ protected:
   std::shared_ptr<Math::Matrix<T>> prediction_;
   std::shared_ptr<Math::Matrix<T>> target_;
   std::shared_ptr<Math::Matrix<T>> diff_;
+  // Value of the last forward, for losses that compute it in _forward
+  T value_ = (T)0;
 
   virtual T _compute_loss_value() = 0;
   virtual Math::Matrix<T> _compute_input_grad() = 0;
+
+  // Caches prediction, target and their difference, then
+  // _compute_loss_value. Losses with a single-pass kernel override it.
+  virtual T _forward(const Math::Matrix<T> &prediction,
+                     const Math::Matrix<T> &target);
+
+  // diff_ sized like `like`, prediction and target caches dropped
+  T *_grad_buffer(const Math::Shape &like);
+
+  // kernel(p, y, g, n) writes dL/dp for n elements into g and returns the
+  // sum of their loss terms. One pass over prediction and target, no copies:
+  // diff_ ends up holding the gradient and value_ the total.
+  template <typename Kernel>
+  T _forward_fused(const Math::Matrix<T> &prediction,
+                   const Math::Matrix<T> &target, Kernel kernel);
 };
 
 template <typename T>
 T Loss<T>::forward(const Math::Matrix<T> &prediction,
                    const Math::Matrix<T> &target) {
   Math::assert_shape(prediction.shape(), target.shape(), "Loss Forward");
+  return this->_forward(prediction, target);
+}
 
-  this->prediction_ = std::make_shared<Math::Matrix<T>>(prediction);
-  this->target_ = std::make_shared<Math::Matrix<T>>(target);
-
-  this->diff_ = std::make_shared<Math::Matrix<T>>(prediction - target);
+template <typename T>
+T Loss<T>::_forward(const Math::Matrix<T> &prediction,
+                    const Math::Matrix<T> &target) {
+  Ops::cache_into(this->prediction_, prediction);
+  Ops::cache_into(this->target_, target);
+  Ops::cache_into(this->diff_, prediction - target);
 
   return this->_compute_loss_value();
 }
 
+template <typename T> T *Loss<T>::_grad_buffer(const Math::Shape &like) {
+  {
+    Math::Memory::PersistentScope persistent;
+    if (!this->diff_) {
+      this->diff_ = std::make_shared<Math::Matrix<T>>();
+    }
+    this->diff_->resize(like[0], like[1]);
+  }
+  this->prediction_.reset();
+  this->target_.reset();
+  return this->diff_->data_ptr();
+}
+
+template <typename T>
+template <typename Kernel>
+T Loss<T>::_forward_fused(const Math::Matrix<T> &prediction,
+                          const Math::Matrix<T> &target, Kernel kernel) {
+  T *pG = _grad_buffer(prediction.shape());
+  const T *pP = prediction.data_ptr();
+  const T *pY = target.data_ptr();
+  this->value_ = Math::Reduce::chunked_sum<T>(
+      prediction.size(), [&](size_t begin, size_t len) {
+        return kernel(pP + begin, pY + begin, pG + begin, len);
+      });
+  return this->value_;
+}
+
 template <typename T> Math::Matrix<T> Loss<T>::backward() {
   if (!this->diff_) {
     throw std::runtime_error("Loss::backward: Call forward first.");
@@ -54,29 +110,35 @@ template <typename T> Math::Matrix<T> Loss<T>::backward() {
 // =========================================================================
 // MSE (Mean Squared Error)
 // =========================================================================
+// L = mean (p - y)^2, dL/dp = 2 (p - y) / n, both in one pass
 template <typename T> class MeanSquareError : public Loss<T> {
 public:
-  T _compute_loss_value() override;
-  Math::Matrix<T> _compute_input_grad() override;
-};
-
-template <typename T> T MeanSquareError<T>::_compute_loss_value() {
-
-  auto squared_error = Math::Func::pow(*this->diff_, (T)2.0);
+  T _compute_loss_value() override { return this->value_; }
+  Math::Matrix<T> _compute_input_grad() override { return *this->diff_; }
 
-  auto sum_mat = Math::Linalg::sum(squared_error);
-
-  T sum_val = sum_mat.data()[0];
-
-  return sum_val / (T)this->prediction_->size();
-}
+protected:
+  T _forward(const Math::Matrix<T> &prediction,
+             const Math::Matrix<T> &target) override;
+};
 
 template <typename T>
-Math::Matrix<T> MeanSquareError<T>::_compute_input_grad() {
-
-  T n = (T)this->prediction_->size();
-
-  return (*this->diff_) * ((T)2.0 / n);
+T MeanSquareError<T>::_forward(const Math::Matrix<T> &prediction,
+                               const Math::Matrix<T> &target) {
+  T invN = (T)1 / (T)prediction.size();
+  T scale = (T)2 * invN;
+  this->_forward_fused(
+      prediction, target, [scale](const T *p, const T *y, T *g, size_t n) {
+        T sum = (T)0;
+#pragma omp simd reduction(+ : sum)
+        for (size_t i = 0; i < n; i++) {
+          T d = p[i] - y[i];
+          g[i] = d * scale;
+          sum += d * d;
+        }
+        return sum;
+      });
+  this->value_ *= invN;
+  return this->value_;
 }
 
 // =========================================================================
@@ -84,18 +146,130 @@ Math::Matrix<T> MeanSquareError<T>::_compute_input_grad() {
 // =========================================================================
 template <typename T> class CategoricalCrossEntropy : public Loss<T> {
 public:
+  // Loss straight from the logits Z of a softmax output layer (Model::compile
+  // sets this up for a Dense + Softmax head):
+  //   L = mean_i sum_j y_ij (lse(z_i) - z_ij),  dL/dZ = (softmax(Z) - Y) / N
+  // Both come out of one pass over each row; backward returns dL/dZ.
+  T forward_logits(const Math::Matrix<T> &logits,
+                   const Math::Matrix<T> &target);
+  // Same when softmax(Z) is already known: no exponentials, lse_i is read at
+  // the largest probability of the row (at least 1 / classes, so exact)
+  T forward_logits(const Math::Matrix<T> &logits,
+                   const Math::Matrix<T> &probabilities,
+                   const Math::Matrix<T> &target);
+
   T _compute_loss_value() override;
   Math::Matrix<T> _compute_input_grad() override;
+
+protected:
+  // The last forward left dL/dinput itself in diff_ (forward_logits or
+  // integer labels), backward returns it as is
+  bool gradReady_ = false;
+
+  // Target given either as a one-hot matrix or as one class index per row
+  T _forward_logits(const Math::Matrix<T> &logits, const T *probabilities,
+                    const T *target, const int *labels);
 };
 
+template <typename T>
+T CategoricalCrossEntropy<T>::forward_logits(const Math::Matrix<T> &logits,
+                                             const Math::Matrix<T> &target) {
+  Math::assert_shape(logits.shape(), target.shape(),
+                     "CategoricalCrossEntropy::forward_logits");
+  return _forward_logits(logits, nullptr, target.data_ptr(), nullptr);
+}
+
+template <typename T>
+T CategoricalCrossEntropy<T>::forward_logits(
+    const Math::Matrix<T> &logits, const Math::Matrix<T> &probabilities,
+    const Math::Matrix<T> &target) {
+  Math::assert_shape(probabilities.shape(), logits.shape(),
+                     "CategoricalCrossEntropy::forward_logits");
+  Math::assert_shape(logits.shape(), target.shape(),
+                     "CategoricalCrossEntropy::forward_logits");
+  return _forward_logits(logits, probabilities.data_ptr(), target.data_ptr(),
+                         nullptr);
+}
+
+template <typename T>
+T CategoricalCrossEntropy<T>::_forward_logits(const Math::Matrix<T> &logits,
+                                              const T *probabilities,
+                                              const T *target,
+                                              const int *labels) {
+  int rows = logits.shape()[0];
+  int cols = logits.shape()[1];
+  T *pG = this->_grad_buffer(logits.shape());
+  this->gradReady_ = true;
+  const T *pZ = logits.data_ptr();
+  Math::AlignedVector<T> rowLoss((size_t)rows);
+  T invN = (T)1 / (T)rows;
+
+  auto body = [&](size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) {
+      const T *z = pZ + i * cols;
+      T *g = pG + i * cols;
+
+      int k = 0;
+      for (int j = 1; j < cols; j++) {
+        k = z[j] > z[k] ? j : k;
+      }
+      T max_val = z[k];
+
+      // p_ij = p[j] * scale. log p_ij = z_ij - lse_i, no log of a rounded
+      // probability
+      const T *p = g;
+      T scale = (T)1;
+      T lse;
+      if (probabilities) {
+        p = probabilities + i * cols;
+        lse = max_val - std::log(p[k]);
+      } else {
+        Math::Simd::binary<Math::Simd::BinOp::Sub, Math::Simd::Form::VS>(
+            z, &max_val, g, cols);
+        Math::VMath::exp(g, g, cols);
+        T sum = (T)0;
+        for (int j = 0; j < cols; j++) {
+          sum += g[j];
+        }
+        lse = max_val + std::log(sum);
+        scale = (T)1 / sum;
+      }
+
+      T loss = (T)0;
+      if (labels) {
+        // One-hot row with its 1 at labels[i]
+        int c = labels[i];
+        T pscale = scale * invN;
+#pragma omp simd
+        for (int j = 0; j < cols; j++) {
+          g[j] = p[j] * pscale;
+        }
+        g[c] -= invN;
+        loss = lse - z[c];
+      } else {
+        const T *y = target + i * cols;
+#pragma omp simd reduction(+ : loss)
+        for (int j = 0; j < cols; j++) {
+          loss += y[j] * (lse - z[j]);
+          g[j] = (p[j] * scale - y[j]) * invN;
+        }
+      }
+      rowLoss[i] = loss;
+    }
+  };
+  Utils::parallel_for(0, (size_t)rows, Utils::grain_for(cols), body);
+
+  return Math::Reduce::sum(rowLoss.data(), (size_t)rows) * invN;
+}
+
 template <typename T> T CategoricalCrossEntropy<T>::_compute_loss_value() {
+  this->gradReady_ = false;
   const auto &y_pred = *this->prediction_;
   const auto &y_true = *this->target_;
 
   T eps = 1e-9;
-  Math::Matrix<T> safe_pred = y_pred + eps;
-
-  Math::Matrix<T> log_p = Math::Func::log(safe_pred);
+  // Vectorized log (VMath kernel), the eps shift is fused into its input
+  Math::Matrix<T> log_p = Math::Func::log(y_pred + eps);
 
   Math::Matrix<T> element_loss = y_true * log_p;
 
@@ -109,6 +283,9 @@ template <typename T> T CategoricalCrossEntropy<T>::_compute_loss_value() {
 
 template <typename T>
 Math::Matrix<T> CategoricalCrossEntropy<T>::_compute_input_grad() {
+  if (this->gradReady_) {
+    return *this->diff_;
+  }
 
   const auto &y_pred = *this->prediction_;
   const auto &y_true = *this->target_;
@@ -123,34 +300,118 @@ Math::Matrix<T> CategoricalCrossEntropy<T>::_compute_input_grad() {
 }
 
 // =========================================================================
-// MAE (Mean Absolute Error) - "Costo Lineal"
+// Sparse Cross Entropy
 // =========================================================================
-template <typename T> class MeanAbsoluteError : public Loss<T> {
+// Categorical cross-entropy on integer labels (N x 1 class indices, as
+// DataLoader::getLabels returns them) instead of an N x classes one-hot
+// matrix: the loss gathers one probability per row and the gradient only
+// touches the label column. One-hot targets still work as in the base class.
+template <typename T>
+class SparseCategoricalCrossEntropy : public CategoricalCrossEntropy<T> {
 public:
-  T _compute_loss_value() override {
-    Math::Matrix<T> abs_diff = Math::Func::abs(*this->diff_);
-    Math::Matrix<T> sum_mat = Math::Linalg::sum(abs_diff);
-    return sum_mat.data()[0] / (T)this->prediction_->size();
+  using CategoricalCrossEntropy<T>::forward;
+  using CategoricalCrossEntropy<T>::forward_logits;
+
+  //   L = -mean_i log p_i,label_i,  dL/dp_ij = -[j == label_i] / (N p_ij)
+  T forward(const Math::Matrix<T> &prediction, const Math::Matrix<int> &labels);
+  //   dL/dZ = (softmax(Z) - onehot(labels)) / N
+  T forward_logits(const Math::Matrix<T> &logits,
+                   const Math::Matrix<int> &labels);
+  T forward_logits(const Math::Matrix<T> &logits,
+                   const Math::Matrix<T> &probabilities,
+                   const Math::Matrix<int> &labels);
+
+private:
+  static void _check_labels(const Math::Matrix<int> &labels, int rows,
+                            int classes);
+};
+
+template <typename T>
+void SparseCategoricalCrossEntropy<T>::_check_labels(
+    const Math::Matrix<int> &labels, int rows, int classes) {
+  Math::assert_shape(labels.shape(), Math::Shape(rows, 1),
+                     "SparseCategoricalCrossEntropy");
+  const int *pL = labels.data_ptr();
+  for (int i = 0; i < rows; i++) {
+    if (pL[i] < 0 || pL[i] >= classes) {
+      throw std::out_of_range(
+          "SparseCategoricalCrossEntropy: Label out of range.");
+    }
   }
+}
+
+template <typename T>
+T SparseCategoricalCrossEntropy<T>::forward(const Math::Matrix<T> &prediction,
+                                            const Math::Matrix<int> &labels) {
+  int rows = prediction.shape()[0];
+  int cols = prediction.shape()[1];
+  _check_labels(labels, rows, cols);
+
+  T *pG = this->_grad_buffer(prediction.shape());
+  this->gradReady_ = true;
+  const T *pP = prediction.data_ptr();
+  const int *pL = labels.data_ptr();
+  Math::AlignedVector<T> rowLoss((size_t)rows);
+  T invN = (T)1 / (T)rows;
+  T eps = 1e-9;
 
-  Math::Matrix<T> _compute_input_grad() override {
-    T n = (T)this->prediction_->size();
-    T scale = (T)1.0 / n;
-
-    Math::Matrix<T> grad = *this->diff_;
-    const std::vector<T> &data = grad.data();
-    std::vector<T> result(data.size());
-    T *pResult = result.data();
-
-    for (size_t i = 0; i < data.size(); i++) {
-      if (data[i] > 0)
-        pResult[i] = scale;
-      else if (data[i] < 0)
-        pResult[i] = -scale;
-      else
-        pResult[i] = 0;
+  auto body = [&](size_t lo, size_t hi) {
+    std::fill(pG + lo * cols, pG + hi * cols, (T)0);
+    for (size_t i = lo; i < hi; i++) {
+      T p = pP[i * cols + pL[i]] + eps;
+      pG[i * cols + pL[i]] = -invN / p;
+      rowLoss[i] = -std::log(p);
     }
-    return {result, grad.shape()};
+  };
+  Utils::parallel_for(0, (size_t)rows, Utils::grain_for(cols), body);
+
+  return Math::Reduce::sum(rowLoss.data(), (size_t)rows) * invN;
+}
+
+template <typename T>
+T SparseCategoricalCrossEntropy<T>::forward_logits(
+    const Math::Matrix<T> &logits, const Math::Matrix<int> &labels) {
+  _check_labels(labels, logits.shape()[0], logits.shape()[1]);
+  return this->_forward_logits(logits, nullptr, nullptr, labels.data_ptr());
+}
+
+template <typename T>
+T SparseCategoricalCrossEntropy<T>::forward_logits(
+    const Math::Matrix<T> &logits, const Math::Matrix<T> &probabilities,
+    const Math::Matrix<int> &labels) {
+  Math::assert_shape(probabilities.shape(), logits.shape(),
+                     "SparseCategoricalCrossEntropy::forward_logits");
+  _check_labels(labels, logits.shape()[0], logits.shape()[1]);
+  return this->_forward_logits(logits, probabilities.data_ptr(), nullptr,
+                               labels.data_ptr());
+}
+
+// =========================================================================
+// MAE (Mean Absolute Error) - "Costo Lineal"
+// =========================================================================
+template <typename T> class MeanAbsoluteError : public Loss<T> {
+public:
+  T _compute_loss_value() override { return this->value_; }
+  Math::Matrix<T> _compute_input_grad() override { return *this->diff_; }
+
+protected:
+  // L = mean |p - y|, dL/dp = sign(p - y) / n, both in one pass
+  T _forward(const Math::Matrix<T> &prediction,
+             const Math::Matrix<T> &target) override {
+    T invN = (T)1 / (T)prediction.size();
+    this->_forward_fused(
+        prediction, target, [invN](const T *p, const T *y, T *g, size_t n) {
+          T sum = (T)0;
+#pragma omp simd reduction(+ : sum)
+          for (size_t i = 0; i < n; i++) {
+            T d = p[i] - y[i];
+            g[i] = invN * (T)((d > (T)0) - (d < (T)0));
+            sum += std::fabs(d);
+          }
+          return sum;
+        });
+    this->value_ *= invN;
+    return this->value_;
   }
 };
 
@@ -0,0 +1,269 @@
+#pragma once
+#include "../math/fixed_matrix.h"
+#include "../math/matrix.h"
+#include "../math/vmath.h"
+#include "../utils/asserts.h"
+#include "activation_func.h"
+#include "layers.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+/********************************************************************************
+ *
+ * Fixed-shape inference for small Dense networks
+ *
+ * When the topology is known at compile time, a trained network can be copied
+ * into FixedDense layers: weights live inside the object, the activation is a
+ * template policy (no virtual call) and the products run on the unrolled
+ * FixedMatrix kernels. Nothing allocates on the way through:
+ *
+ *   using Net = NN::FixedNetwork<float,
+ *       NN::Layer::FixedDense<float, 64, 20, NN::FixedAct::ReLU>,
+ *       NN::Layer::FixedDense<float, 20, 10, NN::FixedAct::ReLU>,
+ *       NN::Layer::FixedDense<float, 10, 10, NN::FixedAct::Softmax>>;
+ *   Net net(model.get_layers());                 // after training
+ *   auto probs = net.predict(Math::FixedMatrix<float, 1, 64>(sample));
+ *
+ * Shapes and activations are checked once against the trained layers when
+ * the network is built.
+ *
+ ********************************************************************************/
+
+namespace NN {
+
+// Activation policies, on the same VMath kernels as ActFunc. Op is the
+// ActFunc class a trained Dense must use.
+namespace FixedAct {
+
+// p[i] = K(p[i]) with the inline VMath kernel (no dispatch for a few values)
+template <typename K, int N, typename T> void map(T *p) {
+#pragma omp simd
+  for (int i = 0; i < N; i++) {
+    p[i] = K::template f<Math::VMath::Precision::Accurate>(p[i]);
+  }
+}
+
+struct Linear {
+  template <typename T> using Op = ActFunc::Linear<T>;
+  template <typename T, int R, int C>
+  static void apply(Math::FixedMatrix<T, R, C> &) {}
+};
+
+struct ReLU {
+  template <typename T> using Op = ActFunc::ReLU<T>;
+  template <typename T, int R, int C>
+  static void apply(Math::FixedMatrix<T, R, C> &x) {
+    T *p = x.data();
+    Math::Fixed::for_each<R * C>(
+        [&](int i) { p[i] = p[i] > (T)0 ? p[i] : (T)0; });
+  }
+};
+
+struct Sigmoid {
+  template <typename T> using Op = ActFunc::Sigmoid<T>;
+  template <typename T, int R, int C>
+  static void apply(Math::FixedMatrix<T, R, C> &x) {
+    map<Math::VMath::Kernel::Sigmoid, R * C>(x.data());
+  }
+};
+
+struct Tanh {
+  template <typename T> using Op = ActFunc::Tanh<T>;
+  template <typename T, int R, int C>
+  static void apply(Math::FixedMatrix<T, R, C> &x) {
+    map<Math::VMath::Kernel::Tanh, R * C>(x.data());
+  }
+};
+
+struct Softmax {
+  template <typename T> using Op = ActFunc::Softmax<T>;
+  template <typename T, int R, int C>
+  static void apply(Math::FixedMatrix<T, R, C> &x) {
+    for (int i = 0; i < R; i++) {
+      T *y = x.row(i);
+      T max_val = *std::max_element(y, y + C);
+      Math::Fixed::for_each<C>([&](int j) { y[j] -= max_val; });
+      map<Math::VMath::Kernel::Exp, C>(y);
+      T sum = (T)0;
+      Math::Fixed::for_each<C>([&](int j) { sum += y[j]; });
+      T inv_sum = (T)1 / sum;
+      Math::Fixed::for_each<C>([&](int j) { y[j] *= inv_sum; });
+    }
+  }
+};
+
+} // namespace FixedAct
+
+namespace Layer {
+
+/***************************************************************************
+ *
+ * Class Layer FixedDense: inference-only Dense with compile-time sizes
+ *
+ ***************************************************************************/
+
+template <typename T, int In, int Out, typename Act = FixedAct::Linear>
+class FixedDense {
+public:
+  static constexpr int INPUTS = In;
+  static constexpr int OUTPUTS = Out;
+
+  FixedDense(const Math::Matrix<T> &weights, const Math::Matrix<T> &bias)
+      : weights_(weights), bias_(bias) {}
+  // Copy of a trained Dense layer, which must be In -> Out with activation Act
+  explicit FixedDense(Layer<T> &layer);
+
+  // y = act(x * W + b) for a batch of B rows
+  template <int B>
+  Math::FixedMatrix<T, B, Out>
+  forward(const Math::FixedMatrix<T, B, In> &x) const {
+    Math::FixedMatrix<T, B, Out> y;
+    for (int i = 0; i < B; i++) {
+      // Two local accumulators (even and odd k): no aliasing with the
+      // weights, and two independent FMA chains
+      alignas(64) T acc[Out];
+      alignas(64) T odd[Out] = {};
+      const T *b = bias_.data();
+      Math::Fixed::for_each<Out>([&](int j) { acc[j] = b[j]; });
+      const T *xi = x.row(i);
+      int k = 0;
+      for (; k + 1 < In; k += 2) {
+        const T x0 = xi[k], x1 = xi[k + 1];
+        const T *w0 = weights_.row(k);
+        const T *w1 = weights_.row(k + 1);
+        Math::Fixed::for_each<Out>([&](int j) {
+          acc[j] += x0 * w0[j];
+          odd[j] += x1 * w1[j];
+        });
+      }
+      if (k < In) {
+        const T xk = xi[k];
+        const T *w = weights_.row(k);
+        Math::Fixed::for_each<Out>([&](int j) { acc[j] += xk * w[j]; });
+      }
+      T *out = y.row(i);
+      Math::Fixed::for_each<Out>([&](int j) { out[j] = acc[j] + odd[j]; });
+    }
+    Act::apply(y);
+    return y;
+  }
+
+  const Math::FixedMatrix<T, In, Out> &weights() const { return weights_; }
+  const Math::FixedMatrix<T, 1, Out> &bias() const { return bias_; }
+
+private:
+  Math::FixedMatrix<T, In, Out> weights_;
+  Math::FixedMatrix<T, 1, Out> bias_;
+};
+
+template <typename T, int In, int Out, typename Act>
+FixedDense<T, In, Out, Act>::FixedDense(Layer<T> &layer) {
+  auto *dense = dynamic_cast<Dense<T> *>(&layer);
+  if (!dense) {
+    throw std::invalid_argument("FixedDense: Expected a Dense layer, found " +
+                                layer.get_type());
+  }
+  auto params = dense->params();
+  if (params.size() != 2) {
+    throw std::runtime_error("FixedDense: Run the model once before copying.");
+  }
+  auto act = dense->activation();
+  bool linear = std::is_same_v<Act, FixedAct::Linear> && !act;
+  // Exact class: a subclass may compute something else than Act
+  if (!linear &&
+      (!act || typeid(*act) != typeid(typename Act::template Op<T>))) {
+    throw std::invalid_argument("FixedDense: Activation does not match the "
+                                "trained layer.");
+  }
+  weights_ = Math::FixedMatrix<T, In, Out>(*params[0]);
+  bias_ = Math::FixedMatrix<T, 1, Out>(*params[1]);
+}
+
+} // namespace Layer
+
+/***************************************************************************
+ *
+ * FixedNetwork: a chain of FixedDense layers
+ *
+ ***************************************************************************/
+
+template <typename T, typename... Layers> class FixedNetwork {
+  static_assert(sizeof...(Layers) > 0, "FixedNetwork: no layers");
+  using First = std::tuple_element_t<0, std::tuple<Layers...>>;
+  using Last = std::tuple_element_t<sizeof...(Layers) - 1, std::tuple<Layers...>>;
+
+public:
+  static constexpr int INPUTS = First::INPUTS;
+  static constexpr int OUTPUTS = Last::OUTPUTS;
+
+  explicit FixedNetwork(Layers... layers) : layers_(std::move(layers)...) {
+    _check_chain<0>();
+  }
+  // Copy of trained layers (Model::get_layers()), one per FixedDense
+  explicit FixedNetwork(const std::vector<Layer::Layer<T> *> &layers)
+      : layers_(_copy(layers, std::index_sequence_for<Layers...>{})) {
+    _check_chain<0>();
+  }
+
+  template <int B>
+  Math::FixedMatrix<T, B, OUTPUTS>
+  predict(const Math::FixedMatrix<T, B, INPUTS> &x) const {
+    return _forward<0>(x);
+  }
+
+  // Runtime batch of `rows` x INPUTS, one row at a time
+  Math::Matrix<T> predict(const Math::MatrixView<T> &x) const {
+    Math::assert_eq(x.cols(), INPUTS, "FixedNetwork::predict");
+    Math::AlignedVector<T> out((size_t)x.rows() * OUTPUTS);
+    Math::FixedMatrix<T, 1, INPUTS> row;
+    for (int i = 0; i < x.rows(); i++) {
+      const T *src = x.data_ptr() + (size_t)i * x.ld();
+      std::copy(src, src + INPUTS, row.data());
+      auto y = predict(row);
+      std::copy(y.data(), y.data() + OUTPUTS, out.data() + (size_t)i * OUTPUTS);
+    }
+    return Math::Matrix<T>(std::move(out), {x.rows(), OUTPUTS});
+  }
+
+  template <size_t I> const auto &layer() const { return std::get<I>(layers_); }
+
+private:
+  std::tuple<Layers...> layers_;
+
+  template <size_t... I>
+  static std::tuple<Layers...>
+  _copy(const std::vector<Layer::Layer<T> *> &layers,
+        std::index_sequence<I...>) {
+    Math::assert_eq(layers.size(), sizeof...(Layers),
+                    "FixedNetwork: Number of layers");
+    return std::tuple<Layers...>(Layers(*layers[I])...);
+  }
+
+  // Every layer must feed the next one
+  template <size_t I> static constexpr void _check_chain() {
+    if constexpr (I + 1 < sizeof...(Layers)) {
+      static_assert(std::tuple_element_t<I, std::tuple<Layers...>>::OUTPUTS ==
+                        std::tuple_element_t<I + 1,
+                                             std::tuple<Layers...>>::INPUTS,
+                    "FixedNetwork: consecutive layer sizes do not match");
+      _check_chain<I + 1>();
+    }
+  }
+
+  template <size_t I, typename X> auto _forward(const X &x) const {
+    if constexpr (I + 1 == sizeof...(Layers)) {
+      return std::get<I>(layers_).forward(x);
+    } else {
+      return _forward<I + 1>(std::get<I>(layers_).forward(x));
+    }
+  }
+};
+
+} // namespace NN
@@ -0,0 +1,284 @@
+#pragma once
+#include "../math/gemm.h"
+#include "../math/matrix.h"
+#include "../math/simd.h"
+#include "../math/vmath.h"
+#include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "ops.h"
+#include <algorithm>
+#include <cstddef>
+
+/********************************************************************************
+ *
+ * Fused Dense kernels
+ *
+ * The generic Dense runs WeightMultiply, AddBias and the activation as three
+ * operations, each one reading and writing a full batch x neurons matrix.
+ * Here the bias and the activation are applied in the GEMM epilogue, on each
+ * output tile before it is stored:
+ *
+ *   Y = act(X * W + b)           one write of Y, nothing else materialized
+ *
+ * Backward only needs X and Y: every fusable activation has a derivative that
+ * can be written in terms of its output (ReLU: y > 0, Sigmoid: y (1 - y),
+ * Tanh: 1 - y^2, Softmax: y (g - <y, g>)). It is computed block by block
+ * while reading dY, together with the bias gradient, and each block feeds
+ * the dX and dW products straight from cache (see dense_backward).
+ *
+ ********************************************************************************/
+
+namespace NN {
+namespace Fused {
+
+// Epilogue of the Dense GEMM: y[j] = act(y[j] + b[col + j]) on one tile row.
+// Softmax needs the whole row, its tiles only get the bias (see softmax_rows).
+template <Ops::Fusable A, Math::VMath::Precision P, typename T> struct BiasAct {
+  const T *bias;
+
+  void operator()(T *y, int col, int n) const {
+    const T *b = bias + col;
+#pragma omp simd
+    for (int j = 0; j < n; j++) {
+      T z = y[j] + b[j];
+      if constexpr (A == Ops::Fusable::ReLU) {
+        z = z > (T)0 ? z : (T)0;
+      } else if constexpr (A == Ops::Fusable::Sigmoid) {
+        z = Math::VMath::Kernel::Sigmoid::f<P>(z);
+      } else if constexpr (A == Ops::Fusable::Tanh) {
+        z = Math::VMath::Kernel::Tanh::f<P>(z);
+      }
+      y[j] = z;
+    }
+  }
+};
+
+// out = softmax(in) row by row, `out` may be `in`
+template <typename T>
+void softmax_rows(const T *in, T *out, size_t rows, size_t cols) {
+  auto body = [&](size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; ++i) {
+      const T *x = in + i * cols;
+      T *y = out + i * cols;
+
+      // 1. Máximo de la fila (estabilidad numérica)
+      T max_val = x[0];
+      for (size_t j = 1; j < cols; ++j) {
+        max_val = x[j] > max_val ? x[j] : max_val;
+      }
+
+      // 2. Exponencial vectorizada de (x - max) y suma
+      Math::Simd::binary<Math::Simd::BinOp::Sub, Math::Simd::Form::VS>(
+          x, &max_val, y, cols);
+      Math::VMath::exp(y, y, cols);
+
+      T sum = (T)0;
+      for (size_t j = 0; j < cols; ++j) {
+        sum += y[j];
+      }
+
+      // 3. Normalización
+      T inv_sum = (T)1 / sum;
+      Math::Simd::binary<Math::Simd::BinOp::Mul, Math::Simd::Form::VS>(
+          y, &inv_sum, y, cols);
+    }
+  };
+  Utils::parallel_for(0, rows, Utils::grain_for(cols), body);
+}
+
+namespace detail {
+
+template <Math::VMath::Precision P, typename T, typename F>
+void with_bias_act(Ops::Fusable act, const T *b, F &&f) {
+  switch (act) {
+  case Ops::Fusable::ReLU:
+    return f(BiasAct<Ops::Fusable::ReLU, P, T>{b});
+  case Ops::Fusable::Sigmoid:
+    return f(BiasAct<Ops::Fusable::Sigmoid, P, T>{b});
+  case Ops::Fusable::Tanh:
+    return f(BiasAct<Ops::Fusable::Tanh, P, T>{b});
+  default:
+    return f(BiasAct<Ops::Fusable::Linear, P, T>{b});
+  }
+}
+
+} // namespace detail
+
+// Calls f(epilogue) with the BiasAct of `act` at the current VMath
+// precision. Stateless: nothing is cached, callers may run concurrently.
+// Softmax rows still need softmax_rows afterwards.
+template <typename T, typename F>
+void with_bias_act(Ops::Fusable act, const T *b, F &&f) {
+  if (Math::VMath::precision() == Math::VMath::Precision::Fast) {
+    detail::with_bias_act<Math::VMath::Precision::Fast>(act, b, f);
+  } else {
+    detail::with_bias_act<Math::VMath::Precision::Accurate>(act, b, f);
+  }
+}
+
+// Y = act(X * W + b). W is n_in x n_out, b is 1 x n_out.
+template <typename T>
+void dense_forward(const Math::MatrixView<T> &X, const Math::Matrix<T> &W,
+                   const Math::Matrix<T> &b, Ops::Fusable act,
+                   Math::Matrix<T> &Y) {
+  Math::assert_eq(X.cols(), W.shape()[0], "Fused::dense_forward");
+  Math::assert_shape(b.shape(), Math::Shape(1, W.shape()[1]),
+                     "Fused::dense_forward");
+  if (act == Ops::Fusable::None) {
+    throw std::invalid_argument("Fused::dense_forward: Activation not fusable.");
+  }
+
+  int M = X.rows();
+  int N = W.shape()[1];
+  Y.resize(M, N);
+  with_bias_act(act, b.data_ptr(), [&](const auto &ep) {
+    Math::Gemm::gemm(Math::Gemm::Trans::No, Math::Gemm::Trans::No, M, N,
+                     X.cols(), (T)1, X.data_ptr(), (int)X.ld(), W.data_ptr(),
+                     N, (T)0, Y.data_ptr(), N, ep);
+  });
+
+  if (act == Ops::Fusable::Softmax) {
+    softmax_rows(Y.data_ptr(), Y.data_ptr(), (size_t)Y.shape()[0],
+                 (size_t)Y.shape()[1]);
+  }
+}
+
+namespace detail {
+
+// dZ = dY * act'(Z) for `rows` rows, with act' written in terms of the output
+// Y = act(Z), and db += column sums of dZ in the same pass. Tasks own column
+// ranges, so db needs no reduction between threads.
+template <typename T>
+void activation_grad(Ops::Fusable act, const T *y, const T *g, size_t rows,
+                     size_t cols, T *dz, T *db) {
+  // Softmax couples the columns of a row through <y, g>. The buffer belongs
+  // to the calling thread, workers reach it through pDots.
+  thread_local Math::AlignedVector<T> dots;
+  T *pDots = nullptr;
+  if (act == Ops::Fusable::Softmax) {
+    {
+      Math::Memory::PersistentScope persistent;
+      dots.resize(rows);
+    }
+    pDots = dots.data();
+    Utils::parallel_for(0, rows, Utils::grain_for(cols), [&](size_t lo,
+                                                             size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        T dot = (T)0;
+        for (size_t j = 0; j < cols; j++) {
+          dot += y[i * cols + j] * g[i * cols + j];
+        }
+        pDots[i] = dot;
+      }
+    });
+  }
+
+  Utils::parallel_for(0, cols, Utils::grain_for(rows), [&](size_t lo,
+                                                           size_t hi) {
+    for (size_t i = 0; i < rows; i++) {
+      const T *yi = y + i * cols;
+      const T *gi = g + i * cols;
+      T *di = dz + i * cols;
+      switch (act) {
+      case Ops::Fusable::ReLU:
+#pragma omp simd
+        for (size_t j = lo; j < hi; j++) {
+          di[j] = yi[j] > (T)0 ? gi[j] : (T)0;
+          db[j] += di[j];
+        }
+        break;
+      case Ops::Fusable::Sigmoid:
+#pragma omp simd
+        for (size_t j = lo; j < hi; j++) {
+          di[j] = gi[j] * yi[j] * ((T)1 - yi[j]);
+          db[j] += di[j];
+        }
+        break;
+      case Ops::Fusable::Tanh:
+#pragma omp simd
+        for (size_t j = lo; j < hi; j++) {
+          di[j] = gi[j] * ((T)1 - yi[j] * yi[j]);
+          db[j] += di[j];
+        }
+        break;
+      case Ops::Fusable::Softmax: {
+        T dot = pDots[i];
+#pragma omp simd
+        for (size_t j = lo; j < hi; j++) {
+          di[j] = yi[j] * (gi[j] - dot);
+          db[j] += di[j];
+        }
+        break;
+      }
+      default:
+#pragma omp simd
+        for (size_t j = lo; j < hi; j++) {
+          di[j] = gi[j];
+          db[j] += di[j];
+        }
+      }
+    }
+  });
+}
+
+} // namespace detail
+
+// Gradients of Y = act(X * W + b) from the cached X and Y:
+//   dZ = dY * act'(Z),  db = sum_rows(dZ),  dW = X^T * dZ,  dX = dZ * W^T
+// dY is read once. The batch is walked in blocks of KC rows (one K block of
+// the GEMM): each dZ block is built with its bias-gradient contribution and
+// feeds both products while it is still in cache, so the full dZ matrix never
+// exists and dW is updated exactly as often as in a single X^T * dZ.
+template <typename T>
+void dense_backward(Ops::Fusable act, const Math::MatrixView<T> &X,
+                    const Math::Matrix<T> &W, const Math::Matrix<T> &Y,
+                    const Math::Matrix<T> &dY, Math::Matrix<T> &dW,
+                    Math::Matrix<T> &db, Math::Matrix<T> &dX) {
+  using Math::Gemm::Trans;
+  constexpr int BLOCK = Math::Gemm::Blocking<T>::KC;
+
+  int M = X.rows();
+  int nIn = W.shape()[0];
+  int nOut = W.shape()[1];
+  Math::assert_eq(X.cols(), nIn, "Fused::dense_backward");
+  Math::assert_shape(Y.shape(), Math::Shape(M, nOut), "Fused::dense_backward");
+  Math::assert_shape(dY.shape(), Y.shape(), "Fused::dense_backward");
+
+  dW.resize(nIn, nOut);
+  db.resize(1, nOut);
+  dX.resize(M, nIn);
+  std::fill(db.data_ptr(), db.data_ptr() + nOut, (T)0);
+  if (M == 0) {
+    std::fill(dW.data_ptr(), dW.data_ptr() + dW.size(), (T)0);
+    return;
+  }
+
+  // One dZ block, reused across calls
+  thread_local Math::AlignedVector<T> dZ;
+  {
+    Math::Memory::PersistentScope persistent;
+    dZ.resize((size_t)std::min(BLOCK, M) * nOut);
+  }
+
+  for (int r0 = 0; r0 < M; r0 += BLOCK) {
+    int rows = std::min(BLOCK, M - r0);
+    size_t offset = (size_t)r0 * nOut;
+
+    detail::activation_grad(act, Y.data_ptr() + offset,
+                            dY.data_ptr() + offset, (size_t)rows,
+                            (size_t)nOut, dZ.data(), db.data_ptr());
+
+    // dX[r0 : r0 + rows] = dZ * W^T
+    Math::Gemm::gemm(Trans::No, Trans::Yes, rows, nIn, nOut, (T)1, dZ.data(),
+                     nOut, W.data_ptr(), nOut, (T)0,
+                     dX.data_ptr() + (size_t)r0 * nIn, nIn);
+    // dW += X[r0 : r0 + rows]^T * dZ
+    Math::Gemm::gemm(Trans::Yes, Trans::No, nIn, nOut, rows, (T)1,
+                     X.data_ptr() + (size_t)r0 * X.ld(), (int)X.ld(),
+                     dZ.data(), nOut, r0 == 0 ? (T)0 : (T)1, dW.data_ptr(),
+                     nOut);
+  }
+}
+
+} // namespace Fused
+} // namespace NN
@@ -1,12 +1,16 @@
 #pragma once
 #include "../math/matrix.h"
+#include "../math/sparse.h"
 #include "../utils/asserts.h"
+#include "fused_dense.h"
 #include "ops.h"
 #include <map>
 #include <memory>
 #include <random>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace NN {
@@ -22,6 +26,11 @@ template <typename T> class Layer {
 public:
   virtual ~Layer() = default;
   virtual Math::Matrix<T> forward(const Math::Matrix<T> &input);
+  // CSR input, accepted by the first layer of a network (see Dense)
+  virtual Math::Matrix<T> forward(const Math::SparseMatrix<T> &) {
+    throw std::invalid_argument(get_type() +
+                                ": Sparse input is only supported by Dense.");
+  }
   virtual Math::Matrix<T> backward(const Math::Matrix<T> &output_grad);
   virtual void _compute_param_grad(void);
   virtual void _get_params(void);
@@ -33,9 +42,19 @@ public:
 
   virtual std::string get_type() const { return "Generic Layer"; }
 
+  // Keep the cached activations of this layer and its operations in a 16-bit
+  // format between forward and backward (see Ops::Operation)
+  virtual void set_cache_format(Math::StorageFormat format) {
+    cacheFormat_ = format;
+    for (auto &op : operations_) {
+      op->set_cache_format(format);
+    }
+  }
+  Math::StorageFormat cache_format() const { return cacheFormat_; }
+
   virtual std::string get_output_shape_str() const {
-    if (output_) {
-      auto shape = output_->shape();
+    if (output_ || !outputPacked_.empty()) {
+      auto shape = _output_shape();
       std::stringstream ss;
       ss << "(" << shape[0] << ", " << shape[1] << ")"; // (Batch, Neurons)
       return ss.str();
@@ -75,12 +94,22 @@ protected:
   std::shared_ptr<Math::Matrix<T>> inputGrad_;
   std::shared_ptr<Math::Matrix<T>> output_;
 
+  Math::StorageFormat cacheFormat_ = Math::StorageFormat::FP32;
+  Math::HalfMatrix<T> inputPacked_;
+  Math::HalfMatrix<T> outputPacked_;
+
+  const Math::Shape &_output_shape() const {
+    return output_ ? output_->shape() : outputPacked_.shape();
+  }
+
   std::vector<std::shared_ptr<NN::Ops::Operation<T>>> operations_;
 
   std::vector<std::shared_ptr<Math::Matrix<T>>> params_;
   std::vector<std::shared_ptr<Math::Matrix<T>>> params_grad_;
 
   virtual void _setup_layer(const Math::Matrix<T> &input) = 0;
+  // First forward: create the weights for inputs shaped like `input`
+  void _build(const Math::Matrix<T> &input);
 };
 
 /*******************************************************
@@ -88,16 +117,24 @@ protected:
  *******************************************************/
 
 // FORWARD
+template <typename T> void Layer<T>::_build(const Math::Matrix<T> &input) {
+  // Weights and their operations live as long as the layer
+  Math::Memory::PersistentScope persistent;
+  this->_setup_layer(input);
+  this->isFirst_ = false;
+  this->_get_params();
+  this->set_cache_format(this->cacheFormat_);
+}
+
 template <typename T>
 Math::Matrix<T> Layer<T>::forward(const Math::Matrix<T> &input_data) {
 
   if (this->isFirst_) {
-    this->_setup_layer(input_data);
-    this->isFirst_ = false;
-    this->_get_params();
+    this->_build(input_data);
   }
 
-  this->input_ = std::make_shared<Math::Matrix<T>>(input_data);
+  Ops::cache_into(this->input_, this->inputPacked_, this->cacheFormat_,
+                  input_data);
 
   auto current_data = input_data;
 
@@ -105,7 +142,8 @@ Math::Matrix<T> Layer<T>::forward(const Math::Matrix<T> &input_data) {
     current_data = op->forward(current_data);
   }
 
-  this->output_ = std::make_shared<Math::Matrix<T>>(current_data);
+  Ops::cache_into(this->output_, this->outputPacked_, this->cacheFormat_,
+                  current_data);
 
   return current_data;
 }
@@ -114,7 +152,7 @@ Math::Matrix<T> Layer<T>::forward(const Math::Matrix<T> &input_data) {
 template <typename T>
 Math::Matrix<T> Layer<T>::backward(const Math::Matrix<T> &output_grad) {
 
-  Math::assert_shape(this->output_->shape(), output_grad.shape());
+  Math::assert_shape(this->_output_shape(), output_grad.shape());
 
   Math::Matrix<T> current_output_grad = output_grad;
 
@@ -123,7 +161,7 @@ Math::Matrix<T> Layer<T>::backward(const Math::Matrix<T> &output_grad) {
     current_output_grad = (*i)->backward(current_output_grad);
   }
 
-  this->inputGrad_ = std::make_shared<Math::Matrix<T>>(current_output_grad);
+  Ops::cache_into(this->inputGrad_, current_output_grad);
 
   this->_compute_param_grad();
 
@@ -169,8 +207,39 @@ public:
   Dense(int neurons, std::shared_ptr<NN::Ops::Operation<T>> activation)
       : Layer<T>(neurons), act_func_(activation) {}
 
+  // With a built-in activation the whole layer runs as one fused kernel (see
+  // fused_dense.h); other activations, subclasses of the built-in ones
+  // included, go through the operation chain
+  Math::Matrix<T> forward(const Math::Matrix<T> &input) override;
+  Math::Matrix<T> forward(const Math::SparseMatrix<T> &input) override;
+  Math::Matrix<T> backward(const Math::Matrix<T> &output_grad) override;
+
   std::string get_type() const override { return "Dense"; }
 
+  std::shared_ptr<NN::Ops::Operation<T>> activation() const {
+    return act_func_;
+  }
+
+  // Softmax head trained with cross-entropy (see Model::compile): forward
+  // still returns probabilities but caches the logits for the loss, and
+  // backward receives dL/dZ, so the softmax Jacobian is skipped. Only the
+  // exact ActFunc::Softmax qualifies, not its subclasses.
+  void fuse_softmax_loss(bool on) {
+    if (on && act_func_->fusable() != Ops::Fusable::Softmax) {
+      throw std::invalid_argument(
+          "Dense::fuse_softmax_loss: The activation is not Softmax.");
+    }
+    softmaxLoss_ = on;
+  }
+  bool softmax_loss_fused() const { return softmaxLoss_; }
+  // Pre-activation values of the last forward (fuse_softmax_loss only)
+  const Math::Matrix<T> &logits() const {
+    if (!softmaxLoss_ || !this->output_) {
+      throw std::runtime_error("Dense::logits: No logits cached.");
+    }
+    return *this->output_;
+  }
+
   std::map<std::string, std::shared_ptr<Math::Matrix<T>>>
   get_named_params() const override {
     std::map<std::string, std::shared_ptr<Math::Matrix<T>>> m;
@@ -197,6 +266,13 @@ private:
   std::shared_ptr<Math::Matrix<T>> bias_ref_;
   std::shared_ptr<NN::Ops::WeightMultiply<T>> op_weights_;
   std::shared_ptr<NN::Ops::AddBias<T>> op_bias_;
+  // The last forward ran the fused kernel: its caches are input_ and output_
+  bool fused_ = false;
+  // output_ holds the logits and backward starts at dL/dZ
+  bool softmaxLoss_ = false;
+
+  // Cache the logits in full precision, turn `logits` into probabilities
+  Math::Matrix<T> _softmax_from_logits(Math::Matrix<T> logits);
 
   void _setup_layer(const Math::Matrix<T> &input) override;
 };
@@ -220,8 +296,8 @@ void Dense<T>::_setup_layer(const Math::Matrix<T> &input) {
 
   std::normal_distribution<T> d{(T)0.0, std_dev};
 
-  std::vector<T> dataWeights(n_in * n_out);
-  std::vector<T> dataBias(n_out);
+  Math::AlignedVector<T> dataWeights(n_in * n_out);
+  Math::AlignedVector<T> dataBias(n_out);
 
   for (auto &val : dataWeights)
     val = d(gen);
@@ -253,6 +329,111 @@ void Dense<T>::_setup_layer(const Math::Matrix<T> &input) {
   this->_get_params();
 }
 
+template <typename T>
+Math::Matrix<T> Dense<T>::forward(const Math::Matrix<T> &input) {
+  Ops::Fusable act = this->act_func_->fusable();
+  this->fused_ = act != Ops::Fusable::None;
+  if (!this->fused_) {
+    return Layer<T>::forward(input);
+  }
+
+  if (this->isFirst_) {
+    this->_build(input);
+  }
+
+  Math::Matrix<T> output;
+  Fused::dense_forward<T>(input, *this->params_[0], *this->params_[1],
+                          this->softmaxLoss_ ? Ops::Fusable::Linear : act,
+                          output);
+
+  // X for dW and dX, Y for the activation derivative
+  Ops::cache_into(this->input_, this->inputPacked_, this->cacheFormat_, input);
+  if (this->softmaxLoss_) {
+    return this->_softmax_from_logits(std::move(output));
+  }
+  Ops::cache_into(this->output_, this->outputPacked_, this->cacheFormat_,
+                  output);
+  return output;
+}
+
+template <typename T>
+Math::Matrix<T> Dense<T>::_softmax_from_logits(Math::Matrix<T> logits) {
+  // The loss reads them, 16-bit logits would blur the log-sum-exp
+  this->outputPacked_.clear();
+  Ops::cache_into(this->output_, logits);
+
+  Fused::softmax_rows(logits.data_ptr(), logits.data_ptr(),
+                      (size_t)logits.shape()[0], (size_t)logits.shape()[1]);
+  return logits;
+}
+
+template <typename T>
+Math::Matrix<T> Dense<T>::backward(const Math::Matrix<T> &output_grad) {
+  if (!this->fused_ && !this->softmaxLoss_) {
+    return Layer<T>::backward(output_grad);
+  }
+  Math::assert_shape(this->_output_shape(), output_grad.shape(),
+                     "Dense::backward");
+
+  if (!this->fused_) {
+    // Sparse batch with a fused loss: dL/dZ enters below the activation
+    Math::Matrix<T> grad = this->operations_[1]->backward(output_grad);
+    grad = this->operations_[0]->backward(grad);
+    Ops::cache_into(this->inputGrad_, grad);
+    this->_compute_param_grad();
+    return grad;
+  }
+
+  // Widen 16-bit caches for this call only
+  Math::Matrix<T> unpackedX, unpackedY;
+  const Math::Matrix<T> &X =
+      this->input_ ? *this->input_ : (unpackedX = this->inputPacked_.load());
+  const Math::Matrix<T> &Y =
+      this->output_ ? *this->output_ : (unpackedY = this->outputPacked_.load());
+
+  {
+    // Parameter gradients are shared with the optimizer, dX is cached
+    Math::Memory::PersistentScope persistent;
+    if (!this->inputGrad_) {
+      this->inputGrad_ = std::make_shared<Math::Matrix<T>>();
+    }
+    Ops::Fusable act = this->softmaxLoss_ ? Ops::Fusable::Linear
+                                          : this->act_func_->fusable();
+    Fused::dense_backward<T>(act, X, *this->params_[0], Y, output_grad,
+                             *this->params_grad_[0], *this->params_grad_[1],
+                             *this->inputGrad_);
+  }
+  return *this->inputGrad_;
+}
+
+// Sparse input: the weight product runs on the non-zeros only (see
+// Ops::WeightMultiply), bias and activation run on the dense result
+template <typename T>
+Math::Matrix<T> Dense<T>::forward(const Math::SparseMatrix<T> &input) {
+  this->fused_ = false;
+  if (this->isFirst_) {
+    // _setup_layer only reads the number of columns
+    this->_build(Math::Matrix<T>(Math::AlignedVector<T>(), {0, input.cols()}));
+  }
+
+  // Nothing reads the layer input back for a sparse batch
+  this->input_.reset();
+  this->inputPacked_.clear();
+
+  auto weights =
+      std::dynamic_pointer_cast<Ops::WeightMultiply<T>>(this->operations_[0]);
+  Math::Matrix<T> current = weights->forward(input);
+  current = this->operations_[1]->forward(current);
+  if (this->softmaxLoss_) {
+    return this->_softmax_from_logits(std::move(current));
+  }
+  current = this->operations_[2]->forward(current);
+
+  Ops::cache_into(this->output_, this->outputPacked_, this->cacheFormat_,
+                  current);
+  return current;
+}
+
 /******************************************************************
  *
  * Implement a Sequential Class to generate a custom FeedForward Neural Network
@@ -266,12 +447,21 @@ public:
 
   void add(std::shared_ptr<Layer<T>> layer);
   Math::Matrix<T> forward(const Math::Matrix<T> &input) override;
+  // The first layer takes the sparse batch, the rest see dense activations
+  Math::Matrix<T> forward(const Math::SparseMatrix<T> &input) override;
   Math::Matrix<T> backward(const Math::Matrix<T> &output_grad) override;
   void _compute_param_grad(void) override;
   void _get_params() override;
 
   std::string get_type() const override { return "Sequential"; }
 
+  void set_cache_format(Math::StorageFormat format) override {
+    this->cacheFormat_ = format;
+    for (auto &layer : layers_) {
+      layer->set_cache_format(format);
+    }
+  }
+
   // Sequential delega la recolección a sus hijos
   void get_flat_layers(std::vector<Layer<T> *> &list) override {
     for (auto &layer : layers_) {
@@ -285,12 +475,15 @@ protected:
 };
 
 template <typename T> void Sequential<T>::add(std::shared_ptr<Layer<T>> layer) {
+  if (this->cacheFormat_ != Math::StorageFormat::FP32) {
+    layer->set_cache_format(this->cacheFormat_);
+  }
   layers_.push_back(layer);
 }
 
 template <typename T>
 Math::Matrix<T> Sequential<T>::forward(const Math::Matrix<T> &input) {
-  this->input_ = std::make_shared<Math::Matrix<T>>(input);
+  Ops::cache_into(this->input_, this->inputPacked_, this->cacheFormat_, input);
 
   Math::Matrix<T> current = input;
 
@@ -303,13 +496,37 @@ Math::Matrix<T> Sequential<T>::forward(const Math::Matrix<T> &input) {
     this->isFirst_ = false;
   }
 
-  this->output_ = std::make_shared<Math::Matrix<T>>(current);
+  Ops::cache_into(this->output_, this->outputPacked_, this->cacheFormat_,
+                  current);
+  return current;
+}
+
+template <typename T>
+Math::Matrix<T> Sequential<T>::forward(const Math::SparseMatrix<T> &input) {
+  if (layers_.empty()) {
+    throw std::invalid_argument("Sequential: No layers to run.");
+  }
+  this->input_.reset();
+  this->inputPacked_.clear();
+
+  Math::Matrix<T> current = layers_.front()->forward(input);
+  for (size_t i = 1; i < layers_.size(); i++) {
+    current = layers_[i]->forward(current);
+  }
+
+  if (this->isFirst_) {
+    this->_get_params();
+    this->isFirst_ = false;
+  }
+
+  Ops::cache_into(this->output_, this->outputPacked_, this->cacheFormat_,
+                  current);
   return current;
 }
 
 template <typename T>
 Math::Matrix<T> Sequential<T>::backward(const Math::Matrix<T> &output_grad) {
-  Math::assert_shape(this->output_->shape(), output_grad.shape(),
+  Math::assert_shape(this->_output_shape(), output_grad.shape(),
                      "Sequential Output mismatch");
 
   Math::Matrix<T> current_grad = output_grad;
@@ -318,7 +535,7 @@ Math::Matrix<T> Sequential<T>::backward(const Math::Matrix<T> &output_grad) {
     current_grad = (*it)->backward(current_grad);
   }
 
-  this->inputGrad_ = std::make_shared<Math::Matrix<T>>(current_grad);
+  Ops::cache_into(this->inputGrad_, current_grad);
 
   this->_compute_param_grad();
 
@@ -1,8 +1,11 @@
 #pragma once
+#include "../math/sparse.h"
 #include "callbacks.h"
 #include "cost_func.h"
 #include "layers.h"
 #include "optimizer.h"
+#include "quantize.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -14,8 +17,19 @@ template <typename T> class Model {
 public:
   Model() = default;
 
+  // Size of the blocks of the per-step arena and whether blocks of 2 MiB or
+  // more are backed by huge pages (see math/arena.h)
+  Model(size_t arenaBlockBytes, bool hugePages)
+      : arena_(arenaBlockBytes, hugePages) {}
+
   void set_layers(std::shared_ptr<Layer::Layer<T>> network) {
+    // The fused head belongs to the previous network, release it while that
+    // network is still alive and pair the loss with the new one
+    _unfuse_softmax_loss();
     network_ = network;
+    if (loss_) {
+      _fuse_softmax_loss();
+    }
   }
 
   void compile(std::shared_ptr<CostFunc::Loss<T>> loss,
@@ -25,6 +39,20 @@ public:
 
     network_->_get_params();
     optimizer_->setup(network_->params(), network_->param_grads());
+    sparseLoss_ =
+        std::dynamic_pointer_cast<CostFunc::SparseCategoricalCrossEntropy<T>>(
+            loss_);
+    _fuse_softmax_loss();
+  }
+
+  // Keep the activations cached for backward in bf16/fp16 (see
+  // Layer::set_cache_format). Pair it with Optimizer::MixedPrecision to keep
+  // the weights in the same format.
+  void set_cache_format(Math::StorageFormat format) {
+    if (!network_) {
+      throw std::runtime_error("Model: Set the layers first.");
+    }
+    network_->set_cache_format(format);
   }
 
   std::vector<std::shared_ptr<Math::Matrix<T>>> get_parameters() const {
@@ -96,21 +124,42 @@ public:
 
   // Do a step in training
   T train_step(const Math::Matrix<T> &x_batch, const Math::Matrix<T> &y_batch) {
-    if (!network_ || !loss_ || !optimizer_) {
-      throw std::runtime_error("Model: Compile before training.");
-    }
+    return _train_step(x_batch, y_batch);
+  }
 
-    auto predictions = network_->forward(x_batch);
+  // Same with a CSR batch: the first layer works on its non-zeros only
+  T train_step(const Math::SparseMatrix<T> &x_batch,
+               const Math::Matrix<T> &y_batch) {
+    return _train_step(x_batch, y_batch);
+  }
 
-    T current_loss = loss_->forward(predictions, y_batch);
+  // Loss on a dataset without touching the parameters
+  T evaluate(const Math::Matrix<T> &x, const Math::Matrix<T> &y) {
+    return _evaluate(x, y);
+  }
 
-    auto loss_grad = loss_->backward();
-    network_->backward(loss_grad);
+  T evaluate(const Math::SparseMatrix<T> &x, const Math::Matrix<T> &y) {
+    return _evaluate(x, y);
+  }
 
-    optimizer_->setup(network_->params(), network_->param_grads());
-    optimizer_->step();
+  // Integer labels (N x 1 class indices) instead of one-hot targets, for a
+  // model compiled with SparseCategoricalCrossEntropy
+  T train_step(const Math::Matrix<T> &x_batch,
+               const Math::Matrix<int> &labels) {
+    return _train_step(x_batch, labels);
+  }
 
-    return current_loss;
+  T train_step(const Math::SparseMatrix<T> &x_batch,
+               const Math::Matrix<int> &labels) {
+    return _train_step(x_batch, labels);
+  }
+
+  T evaluate(const Math::Matrix<T> &x, const Math::Matrix<int> &labels) {
+    return _evaluate(x, labels);
+  }
+
+  T evaluate(const Math::SparseMatrix<T> &x, const Math::Matrix<int> &labels) {
+    return _evaluate(x, labels);
   }
   // ===========================================================
   // FIT neither of Validation nor Callbacks
@@ -139,12 +188,209 @@ public:
            Math::Matrix<T> &x_val, Math::Matrix<T> &y_val, int epochs,
            std::vector<std::shared_ptr<Callbacks::Callback<T>>> callbacks = {},
            int verbose = 10) {
+    bool has_validation = (x_val.size() > 0 && y_val.size() > 0);
+    _fit(x_train, y_train, x_val, y_val, has_validation, epochs, callbacks,
+         verbose);
+  }
+
+  // ===========================================================
+  // FIT on CSR inputs (an empty x_val means no validation)
+  // ===========================================================
+  void fit(const Math::SparseMatrix<T> &x_train, Math::Matrix<T> &y_train,
+           const Math::SparseMatrix<T> &x_val, Math::Matrix<T> &y_val,
+           int epochs,
+           std::vector<std::shared_ptr<Callbacks::Callback<T>>> callbacks = {},
+           int verbose = 10) {
+    bool has_validation = (x_val.rows() > 0 && y_val.size() > 0);
+    _fit(x_train, y_train, x_val, y_val, has_validation, epochs, callbacks,
+         verbose);
+  }
+
+  void fit(const Math::SparseMatrix<T> &x_train, Math::Matrix<T> &y_train,
+           int epochs,
+           std::vector<std::shared_ptr<Callbacks::Callback<T>>> callbacks = {},
+           int verbose = 10) {
+    Math::Matrix<T> empty_val;
+    fit(x_train, y_train, Math::SparseMatrix<T>(), empty_val, epochs,
+        callbacks, verbose);
+  }
+
+  // ===========================================================
+  // FIT on integer labels (an empty x_val means no validation)
+  // ===========================================================
+  void fit(Math::Matrix<T> &x_train, const Math::Matrix<int> &y_train,
+           Math::Matrix<T> &x_val, const Math::Matrix<int> &y_val, int epochs,
+           std::vector<std::shared_ptr<Callbacks::Callback<T>>> callbacks = {},
+           int verbose = 10) {
+    bool has_validation = (x_val.size() > 0 && y_val.size() > 0);
+    _fit(x_train, y_train, x_val, y_val, has_validation, epochs, callbacks,
+         verbose);
+  }
+
+  void fit(Math::Matrix<T> &x_train, const Math::Matrix<int> &y_train,
+           int epochs,
+           std::vector<std::shared_ptr<Callbacks::Callback<T>>> callbacks = {},
+           int verbose = 10) {
+    Math::Matrix<T> empty_x;
+    Math::Matrix<int> empty_y;
+    fit(x_train, y_train, empty_x, empty_y, epochs, callbacks, verbose);
+  }
+
+  // Build the int8 inference graph from the current weights, calibrating on
+  // the first `calibrationRows` rows of `sample` (e.g. X_val). Call it again
+  // after further training, the graph keeps a copy of the weights.
+  void quantize(const Math::Matrix<T> &sample, size_t calibrationRows = 1024) {
+    if (!network_) {
+      throw std::runtime_error("Model: Set the layers before quantizing.");
+    }
+    Math::Memory::ArenaScope call(arena_);
+
+    size_t rows = std::min((size_t)sample.shape()[0], calibrationRows);
+    Math::Matrix<T> calibration = sample.viewRows(0, rows);
+    quantized_ = std::make_shared<Quant::QuantizedNetwork<T>>(get_layers(),
+                                                              calibration);
+  }
+
+  const Quant::QuantizedNetwork<T> *quantized() const {
+    return quantized_.get();
+  }
+
+  Math::Matrix<T> predict(const Math::Matrix<T> &x,
+                          Inference mode = Inference::Float) {
+    Math::Memory::ArenaScope call(arena_);
+
+    if (mode == Inference::Int8 && !quantized_) {
+      throw std::runtime_error("Model: Call quantize before Int8 inference.");
+    }
+    auto predictions = mode == Inference::Int8 ? quantized_->predict(x)
+                                               : network_->forward(x);
+
+    // The result leaves the call, copy it out of the arena
+    Math::Memory::PersistentScope persistent;
+    return Math::Matrix<T>(predictions);
+  }
+
+  Math::Matrix<T> predict(const Math::SparseMatrix<T> &x) {
+    Math::Memory::ArenaScope call(arena_);
+
+    auto predictions = network_->forward(x);
+
+    Math::Memory::PersistentScope persistent;
+    return Math::Matrix<T>(predictions);
+  }
+
+  const Math::Memory::Arena &arena() const { return arena_; }
+
+private:
+  Math::Memory::Arena arena_;
+  std::shared_ptr<Layer::Layer<T>> network_;
+  std::shared_ptr<CostFunc::Loss<T>> loss_;
+  std::shared_ptr<Optimizer::Optimizer<T>> optimizer_;
+  std::shared_ptr<Quant::QuantizedNetwork<T>> quantized_;
+
+  // Softmax output layer trained with categorical cross-entropy: the loss
+  // reads its logits and hands dL/dZ = (softmax - y) / N straight back.
+  // Points into network_, set_layers clears it before replacing the network.
+  Layer::Dense<T> *softmaxHead_ = nullptr;
+  std::shared_ptr<CostFunc::CategoricalCrossEntropy<T>> softmaxLoss_;
+  // The loss again when it takes integer labels
+  std::shared_ptr<CostFunc::SparseCategoricalCrossEntropy<T>> sparseLoss_;
+
+  void _unfuse_softmax_loss() {
+    if (softmaxHead_) {
+      softmaxHead_->fuse_softmax_loss(false);
+    }
+    softmaxHead_ = nullptr;
+  }
+
+  void _fuse_softmax_loss() {
+    _unfuse_softmax_loss();
+    softmaxLoss_ =
+        std::dynamic_pointer_cast<CostFunc::CategoricalCrossEntropy<T>>(loss_);
+
+    auto layers = get_layers();
+    auto *head = layers.empty()
+                     ? nullptr
+                     : dynamic_cast<Layer::Dense<T> *>(layers.back());
+    // fusable() is Softmax only for ActFunc::Softmax itself, a subclass keeps
+    // its own forward and gradient
+    if (softmaxLoss_ && head &&
+        head->activation()->fusable() == Ops::Fusable::Softmax) {
+      head->fuse_softmax_loss(true);
+      softmaxHead_ = head;
+    }
+  }
+
+  T _loss_forward(const Math::Matrix<T> &predictions,
+                  const Math::Matrix<T> &y) {
+    if (softmaxHead_) {
+      return softmaxLoss_->forward_logits(softmaxHead_->logits(), predictions,
+                                          y);
+    }
+    return loss_->forward(predictions, y);
+  }
+
+  T _loss_forward(const Math::Matrix<T> &predictions,
+                  const Math::Matrix<int> &labels) {
+    if (!sparseLoss_) {
+      throw std::invalid_argument(
+          "Model: Integer labels need SparseCategoricalCrossEntropy.");
+    }
+    if (softmaxHead_) {
+      return sparseLoss_->forward_logits(softmaxHead_->logits(), predictions,
+                                         labels);
+    }
+    return sparseLoss_->forward(predictions, labels);
+  }
+
+  // X is a Matrix<T> or a SparseMatrix<T>, Y a Matrix<T> target or a
+  // Matrix<int> of labels
+  template <typename X, typename Y>
+  T _train_step(const X &x_batch, const Y &y_batch) {
+    if (!network_ || !loss_ || !optimizer_) {
+      throw std::runtime_error("Model: Compile before training.");
+    }
+
+    // Every temporary of the step comes from the arena, released at once
+    Math::Memory::ArenaScope step(arena_);
+
+    auto predictions = network_->forward(x_batch);
+
+    T current_loss = _loss_forward(predictions, y_batch);
+
+    auto loss_grad = loss_->backward();
+    T scale = optimizer_->loss_scale();
+    if (scale != (T)1) {
+      Math::Linalg::scal(scale, loss_grad);
+    }
+    network_->backward(loss_grad);
+
+    optimizer_->setup(network_->params(), network_->param_grads());
+    optimizer_->step();
+
+    return current_loss;
+  }
+
+  template <typename X, typename Y> T _evaluate(const X &x, const Y &y) {
+    if (!network_ || !loss_) {
+      throw std::runtime_error("Model: Compile before evaluating.");
+    }
+    Math::Memory::ArenaScope step(arena_);
+
+    auto predictions = network_->forward(x);
+    return _loss_forward(predictions, y);
+  }
+
+  template <typename X, typename Y>
+  void _fit(const X &x_train, const Y &y_train, const X &x_val,
+            const Y &y_val, bool has_validation, int epochs,
+            std::vector<std::shared_ptr<Callbacks::Callback<T>>> &callbacks,
+            int verbose) {
 
     if (!network_ || !loss_ || !optimizer_) {
       throw std::runtime_error("Model: Compile before fitting.");
     }
 
-    bool has_validation = (x_val.size() > 0 && y_val.size() > 0);
     bool stop_training = false;
 
     for (auto &cb : callbacks)
@@ -157,20 +403,12 @@ public:
       if (stop_training)
         break;
 
-      auto predictions = network_->forward(x_train);
-      T train_loss =
-          loss_->forward(predictions, y_train); // Loss de entrenamiento
-
-      auto loss_grad = loss_->backward();
-      network_->backward(loss_grad);
-      optimizer_->setup(network_->params(), network_->param_grads());
-      optimizer_->step();
+      T train_loss = train_step(x_train, y_train); // Loss de entrenamiento
 
       // --- VALIDATION STEP ---
       T val_loss = (T)0.0;
       if (has_validation) {
-        auto val_preds = network_->forward(x_val);
-        val_loss = loss_->forward(val_preds, y_val);
+        val_loss = evaluate(x_val, y_val);
       } else {
         val_loss = train_loss;
       }
@@ -199,15 +437,6 @@ public:
       std::cout << "Training finished (completed all epochs)." << std::endl;
     }
   }
-
-  Math::Matrix<T> predict(const Math::Matrix<T> &x) {
-    return network_->forward(x);
-  }
-
-private:
-  std::shared_ptr<Layer::Layer<T>> network_;
-  std::shared_ptr<CostFunc::Loss<T>> loss_;
-  std::shared_ptr<Optimizer::Optimizer<T>> optimizer_;
 };
 
 } // namespace NN
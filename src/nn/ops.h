@@ -1,9 +1,13 @@
 #pragma once
+#include "../math/arena.h"
+#include "../math/half.h"
 #include "../math/matrix.h"
 #include "../math/matrix_linalg.h"
+#include "../math/sparse.h"
 #include "../utils/asserts.h"
 #include <memory>
 #include <stdexcept>
+#include <utility>
 
 /*********************************************************
  *
@@ -15,6 +19,51 @@ namespace NN {
 
 namespace Ops {
 
+// Store value in a cache slot: the first pass allocates it, later passes
+// reuse the same Matrix so its buffer is kept between batches. Caches outlive
+// the training step, so they are copied into heap storage even when `value`
+// lives in the step arena.
+template <typename T>
+void cache_into(std::shared_ptr<Math::Matrix<T>> &slot,
+                const Math::Matrix<T> &value) {
+  Math::Memory::PersistentScope persistent;
+  if (!slot) {
+    slot = std::make_shared<Math::Matrix<T>>(value);
+  } else {
+    *slot = value;
+  }
+}
+
+// Same for a lazy expression, evaluated straight into the cache
+template <typename T, typename E>
+void cache_into(std::shared_ptr<Math::Matrix<T>> &slot,
+                const Math::Expr::MatExpr<E> &expr) {
+  Math::Memory::PersistentScope persistent;
+  if (!slot) {
+    slot = std::make_shared<Math::Matrix<T>>(expr);
+  } else {
+    *slot = expr;
+  }
+}
+
+// Same, keeping the value in `packed` when the format is 16-bit. The full
+// precision slot is then released.
+template <typename T>
+void cache_into(std::shared_ptr<Math::Matrix<T>> &slot,
+                Math::HalfMatrix<T> &packed, Math::StorageFormat format,
+                const Math::Matrix<T> &value) {
+  if (format == Math::StorageFormat::FP32) {
+    cache_into(slot, value);
+    return;
+  }
+  slot.reset();
+  packed.store(value, format);
+}
+
+// Activations the fused Dense kernels know how to apply (see fused_dense.h).
+// Any other operation is None and runs through the generic operation chain.
+enum class Fusable { None, Linear, ReLU, Sigmoid, Tanh, Softmax };
+
 template <typename T> class Operation {
 public:
   virtual ~Operation<T>() = default;
@@ -22,15 +71,43 @@ public:
   virtual Math::Matrix<T> forward(const Math::Matrix<T> &input);
   virtual Math::Matrix<T> backward(const Math::Matrix<T> &output_grad);
 
+  // Precision of input_ and output_ between forward and backward. With a
+  // 16-bit format they are kept packed and widened back only while backward
+  // runs, the computation itself always happens in T.
+  void set_cache_format(Math::StorageFormat format) { cacheFormat_ = format; }
+  Math::StorageFormat cache_format() const { return cacheFormat_; }
+
+  // Which fused kernel can replace this operation as a Dense activation. The
+  // built-in activations answer only for their exact class: a subclass may
+  // override forward or _compute_*, so it gets None and runs its own code.
+  virtual Fusable fusable() const { return Fusable::None; }
+
 protected:
   Operation<T>() = default;
   std::shared_ptr<Math::Matrix<T>> input_;
   std::shared_ptr<Math::Matrix<T>> output_;
   std::shared_ptr<Math::Matrix<T>> inputGrad_;
 
+  Math::StorageFormat cacheFormat_ = Math::StorageFormat::FP32;
+  Math::HalfMatrix<T> inputPacked_;
+  Math::HalfMatrix<T> outputPacked_;
+
   virtual Math::Matrix<T> _compute_output(void) = 0;
   virtual Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) = 0;
+
+  bool _is_packed() const {
+    return cacheFormat_ != Math::StorageFormat::FP32;
+  }
+  void _unpack_cache();
+  void _release_cache();
+
+  // Unpacks the caches for the duration of a backward call
+  struct CacheLease {
+    Operation<T> &op;
+    explicit CacheLease(Operation<T> &o) : op(o) { op._unpack_cache(); }
+    ~CacheLease() { op._release_cache(); }
+  };
 };
 
 /***************************
@@ -44,16 +121,52 @@ protected:
 template <typename T>
 Math::Matrix<T> Operation<T>::forward(const Math::Matrix<T> &input) {
 
-  this->input_ = std::make_shared<Math::Matrix<T>>(input);
-  this->output_ = std::make_shared<Math::Matrix<T>>(this->_compute_output());
+  if (!this->_is_packed()) {
+    cache_into(this->input_, input);
+    cache_into(this->output_, this->_compute_output());
+
+    return *this->output_;
+  }
+
+  // Compute straight from the caller's matrix (non-owning alias), then keep
+  // only the packed copies
+  this->input_ =
+      std::shared_ptr<Math::Matrix<T>>(std::shared_ptr<Math::Matrix<T>>(),
+                                       const_cast<Math::Matrix<T> *>(&input));
+  Math::Matrix<T> output = this->_compute_output();
+  this->input_.reset();
+  this->output_.reset();
+
+  this->inputPacked_.store(input, this->cacheFormat_);
+  this->outputPacked_.store(output, this->cacheFormat_);
 
-  return *this->output_;
+  return output;
+}
+
+// Widen the packed caches into input_ and output_ (from the active allocator)
+template <typename T> void Operation<T>::_unpack_cache() {
+  if (!this->_is_packed() || this->input_ || this->inputPacked_.empty()) {
+    return;
+  }
+  this->input_ = std::make_shared<Math::Matrix<T>>(this->inputPacked_.load());
+  this->output_ =
+      std::make_shared<Math::Matrix<T>>(this->outputPacked_.load());
+}
+
+// Drop the widened copies before the arena they may live in is rewound
+template <typename T> void Operation<T>::_release_cache() {
+  if (this->_is_packed()) {
+    this->input_.reset();
+    this->output_.reset();
+  }
 }
 
 // BACKWARD
 
 template <typename T>
 Math::Matrix<T> Operation<T>::backward(const Math::Matrix<T> &output_grad) {
+  CacheLease lease(*this);
+
   if (!this->input_) {
     throw std::runtime_error(
         "Operation::backward::Call backward before forward");
@@ -61,8 +174,7 @@ Math::Matrix<T> Operation<T>::backward(const Math::Matrix<T> &output_grad) {
   Math::assert_shape(this->output_->shape(), output_grad.shape(),
                      "Operation::backward");
 
-  this->inputGrad_ =
-      std::make_shared<Math::Matrix<T>>(this->_compute_input_grad(output_grad));
+  cache_into(this->inputGrad_, this->_compute_input_grad(output_grad));
 
   Math::assert_shape(this->inputGrad_->shape(), this->input_->shape(),
                      "Operation::backward");
@@ -82,7 +194,7 @@ public:
   ParamOperation<T>(std::shared_ptr<Math::Matrix<T>> param)
       : parameters(param) {
     this->parameters_grad_ = std::make_shared<Math::Matrix<T>>(
-        std::vector<T>(param->size(), (T)0.0), param->shape());
+        Math::AlignedVector<T>(param->size(), (T)0.0), param->shape());
   };
 
   Math::Matrix<T> backward(const Math::Matrix<T> &output_grad) override;
@@ -92,8 +204,10 @@ public:
 protected:
   std::shared_ptr<Math::Matrix<T>> parameters;
   std::shared_ptr<Math::Matrix<T>> parameters_grad_;
-  virtual Math::Matrix<T>
-  _compute_parameters_grad(const Math::Matrix<T> &output_grad) = 0;
+  // Writes the gradient straight into param_grad, which is shared with the
+  // optimizer and keeps its buffer between steps
+  virtual void _compute_parameters_grad(const Math::Matrix<T> &output_grad,
+                                        Math::Matrix<T> &param_grad) = 0;
 };
 
 /******************************
@@ -107,7 +221,17 @@ template <typename T>
 Math::Matrix<T>
 ParamOperation<T>::backward(const Math::Matrix<T> &output_grad) {
 
-  *this->parameters_grad_ = this->_compute_parameters_grad(output_grad);
+  // dW reads the cached input
+  typename Operation<T>::CacheLease lease(*this);
+  if (!this->input_) {
+    throw std::runtime_error(
+        "Operation::backward::Call backward before forward");
+  }
+
+  {
+    Math::Memory::PersistentScope persistent;
+    this->_compute_parameters_grad(output_grad, *this->parameters_grad_);
+  }
 
   Math::assert_shape(this->parameters_grad_->shape(),
                      this->parameters->shape());
@@ -127,11 +251,21 @@ public:
   WeightMultiply(std::shared_ptr<Math::Matrix<T>> weights)
       : ParamOperation<T>(weights) {};
 
+  Math::Matrix<T> forward(const Math::Matrix<T> &input) override;
+  // X * W with a CSR input: forward and dW cost O(nnz(X) * N). There is no
+  // gradient for a sparse input, backward returns an empty matrix, so it
+  // must feed the first layer.
+  Math::Matrix<T> forward(const Math::SparseMatrix<T> &input);
+  Math::Matrix<T> backward(const Math::Matrix<T> &output_grad) override;
+
   Math::Matrix<T> _compute_output(void) override;
   Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) override;
-  Math::Matrix<T>
-  _compute_parameters_grad(const Math::Matrix<T> &output_grad) override;
+  void _compute_parameters_grad(const Math::Matrix<T> &output_grad,
+                                Math::Matrix<T> &param_grad) override;
+
+private:
+  std::shared_ptr<Math::SparseMatrix<T>> sparseInput_;
 };
 
 /************************************************************************
@@ -140,6 +274,52 @@ public:
  *
  *************************************************************************/
 
+template <typename T>
+Math::Matrix<T> WeightMultiply<T>::forward(const Math::Matrix<T> &input) {
+  sparseInput_.reset();
+  return ParamOperation<T>::forward(input);
+}
+
+template <typename T>
+Math::Matrix<T>
+WeightMultiply<T>::forward(const Math::SparseMatrix<T> &input) {
+  {
+    Math::Memory::PersistentScope persistent;
+    if (!sparseInput_) {
+      sparseInput_ = std::make_shared<Math::SparseMatrix<T>>(input);
+    } else {
+      *sparseInput_ = input;
+    }
+  }
+  // The dense caches would belong to an older batch
+  this->input_.reset();
+  this->output_.reset();
+  this->inputPacked_.clear();
+  this->outputPacked_.clear();
+
+  return Math::Linalg::spmm(*sparseInput_, *this->parameters);
+}
+
+template <typename T>
+Math::Matrix<T>
+WeightMultiply<T>::backward(const Math::Matrix<T> &output_grad) {
+  if (!sparseInput_) {
+    return ParamOperation<T>::backward(output_grad);
+  }
+  Math::assert_shape(
+      output_grad.shape(),
+      Math::Shape(sparseInput_->rows(), this->parameters->shape()[1]),
+      "WeightMultiply::backward");
+
+  {
+    // dW = X^T * dY, only the rows of the active features are accumulated
+    Math::Memory::PersistentScope persistent;
+    Math::Linalg::spmm_tn(*sparseInput_, output_grad,
+                          *this->parameters_grad_);
+  }
+  return Math::Matrix<T>();
+}
+
 template <typename T> Math::Matrix<T> WeightMultiply<T>::_compute_output() {
 
   return Math::Linalg::matmul(*this->input_, *this->parameters);
@@ -149,16 +329,16 @@ template <typename T>
 Math::Matrix<T>
 WeightMultiply<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
 
-  return Math::Linalg::matmul(output_grad,
-                              Math::Linalg::transpose(*this->parameters));
+  // dX = dY * W^T, W is read in place
+  return Math::Linalg::matmul_nt(output_grad, *this->parameters);
 }
 
 template <typename T>
-Math::Matrix<T> WeightMultiply<T>::_compute_parameters_grad(
-    const Math::Matrix<T> &output_grad) {
+void WeightMultiply<T>::_compute_parameters_grad(
+    const Math::Matrix<T> &output_grad, Math::Matrix<T> &param_grad) {
 
-  return Math::Linalg::matmul(Math::Linalg::transpose(*this->input_),
-                              output_grad);
+  // dW = X^T * dY, the cached input is read in place
+  Math::Linalg::matmul_tn(*this->input_, output_grad, param_grad);
 }
 
 /***************************************************************************
@@ -177,8 +357,8 @@ public:
   Math::Matrix<T> _compute_output(void) override;
   Math::Matrix<T>
   _compute_input_grad(const Math::Matrix<T> &output_grad) override;
-  Math::Matrix<T>
-  _compute_parameters_grad(const Math::Matrix<T> &output_grad) override;
+  void _compute_parameters_grad(const Math::Matrix<T> &output_grad,
+                                Math::Matrix<T> &param_grad) override;
 };
 
 /************************************************************************
@@ -200,10 +380,11 @@ AddBias<T>::_compute_input_grad(const Math::Matrix<T> &output_grad) {
 }
 
 template <typename T>
-Math::Matrix<T>
-AddBias<T>::_compute_parameters_grad(const Math::Matrix<T> &output_grad) {
+void AddBias<T>::_compute_parameters_grad(const Math::Matrix<T> &output_grad,
+                                          Math::Matrix<T> &param_grad) {
 
-  return Math::Linalg::sum(output_grad, 0).reshape({1, output_grad.shape()[1]});
+  // db = column sums of dY, already shaped 1 x n
+  Math::Linalg::sum(output_grad, 0, param_grad);
 }
 
 } // namespace Ops
@@ -1,7 +1,12 @@
 #pragma once
 #include "../math/functions.h"
+#include "../math/half.h"
 #include "../math/matrix.h"
+#include "../math/matrix_linalg.h"
 #include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <vector>
 
@@ -16,12 +21,26 @@ public:
              std::vector<std::shared_ptr<Math::Matrix<T>>> grads);
   virtual void step(void) = 0;
 
+  T learning_rate() const { return lr_; }
+  // Factor the model applies to the loss gradient before backward
+  virtual T loss_scale() const { return (T)1; }
+
 protected:
   Optimizer(T lr) : lr_(lr) { Math::assert_between(lr, (T)0, (T)1); }
 
   T lr_;
   std::vector<std::shared_ptr<Math::Matrix<T>>> params_;
   std::vector<std::shared_ptr<Math::Matrix<T>>> grads_;
+
+  // True when setup() received other parameters than the state was built for
+  // (e.g. the optimizer was compiled into a new network). The caller then
+  // rebuilds its state.
+  bool _rebind_state();
+  // One zeroed buffer per parameter
+  void _init_state(std::vector<std::shared_ptr<Math::Matrix<T>>> &state) const;
+
+private:
+  std::vector<Math::Matrix<T> *> stateFor_;
 };
 
 // setup Method for base class Optimizer
@@ -34,6 +53,64 @@ void Optimizer<T>::setup(std::vector<std::shared_ptr<Math::Matrix<T>>> params,
   this->grads_ = grads;
 }
 
+template <typename T> bool Optimizer<T>::_rebind_state(void) {
+  bool same = stateFor_.size() == params_.size();
+  for (size_t i = 0; same && i < stateFor_.size(); i++) {
+    same = stateFor_[i] == params_[i].get();
+  }
+  if (same) {
+    return false;
+  }
+
+  stateFor_.clear();
+  for (const auto &param : params_) {
+    stateFor_.push_back(param.get());
+  }
+  return true;
+}
+
+template <typename T>
+void Optimizer<T>::_init_state(
+    std::vector<std::shared_ptr<Math::Matrix<T>>> &state) const {
+  Math::Memory::PersistentScope persistent;
+  state.clear();
+  for (const auto &param : params_) {
+    state.push_back(std::make_shared<Math::Matrix<T>>(
+        Math::AlignedVector<T>(param->size(), 0), param->shape()));
+  }
+}
+
+/********************************************************************************
+ *
+ * Update kernels
+ *
+ * Every optimizer updates a parameter in one in-place pass over (W, dW,
+ * state), split in element ranges across the thread pool. Step-dependent
+ * factors (learning rate, bias corrections) are computed once per step
+ * before the loop, so the loop body is a few multiply-adds and at most one
+ * sqrt and one division: Adam touches 4 streams (W, dW, m, v) and nothing
+ * else.
+ *
+ ********************************************************************************/
+
+namespace detail {
+
+// body(w, g, lo, hi) on elements [lo, hi) of every parameter i, with the
+// state pointers of that parameter bound by `bind(i)`
+template <typename T, typename Bind>
+void update(const std::vector<std::shared_ptr<Math::Matrix<T>>> &params,
+            const std::vector<std::shared_ptr<Math::Matrix<T>>> &grads,
+            Bind &&bind) {
+  for (size_t i = 0; i < params.size(); i++) {
+    Math::assert_shape(grads[i]->shape(), params[i]->shape(),
+                       "Optimizer::step");
+    auto body = bind(i, params[i]->data_ptr(), grads[i]->data_ptr());
+    Utils::parallel_for(0, params[i]->size(), Utils::grain_for(1), body);
+  }
+}
+
+} // namespace detail
+
 // SGD Optimizer
 template <typename T> class SGD : public Optimizer<T> {
 public:
@@ -44,12 +121,112 @@ public:
 
 // Step Method for SGD Optimizer
 template <typename T> void SGD<T>::step(void) {
-  for (size_t i = 0; i < this->params_.size(); i++) {
-    Math::Matrix<T> &W = *this->params_[i];
-    const Math::Matrix<T> &dW = *this->grads_[i];
+  T lr = this->lr_;
+  detail::update(this->params_, this->grads_,
+                 [lr](size_t, T *w, const T *g) {
+                   return [=](size_t lo, size_t hi) {
+#pragma omp simd
+                     for (size_t j = lo; j < hi; j++) {
+                       w[j] -= lr * g[j];
+                     }
+                   };
+                 });
+}
+
+// SGD with momentum: v = mu * v + dW, W -= lr * v. With Nesterov the step
+// looks ahead along the new velocity: W -= lr * (dW + mu * v).
+template <typename T> class Momentum : public Optimizer<T> {
+public:
+  Momentum(T learning_rate, T momentum = (T)0.9, bool nesterov = false)
+      : Optimizer<T>(learning_rate), momentum_(momentum), nesterov_(nesterov) {
+    Math::assert_between(momentum_, (T)0, (T)1);
+  }
+
+  void step() override;
+
+private:
+  T momentum_;
+  bool nesterov_;
+
+  std::vector<std::shared_ptr<Math::Matrix<T>>> velocity_;
+};
+
+template <typename T> void Momentum<T>::step(void) {
+  if (this->_rebind_state()) {
+    this->_init_state(velocity_);
+  }
+  T lr = this->lr_;
+  T mu = momentum_;
+  bool nesterov = nesterov_;
+
+  detail::update(this->params_, this->grads_,
+                 [&](size_t i, T *w, const T *g) {
+                   T *v = velocity_[i]->data_ptr();
+                   return [=](size_t lo, size_t hi) {
+                     if (nesterov) {
+#pragma omp simd
+                       for (size_t j = lo; j < hi; j++) {
+                         T vj = mu * v[j] + g[j];
+                         v[j] = vj;
+                         w[j] -= lr * (g[j] + mu * vj);
+                       }
+                     } else {
+#pragma omp simd
+                       for (size_t j = lo; j < hi; j++) {
+                         T vj = mu * v[j] + g[j];
+                         v[j] = vj;
+                         w[j] -= lr * vj;
+                       }
+                     }
+                   };
+                 });
+}
+
+// Nesterov accelerated gradient, Momentum with the look-ahead step
+template <typename T> class Nesterov : public Momentum<T> {
+public:
+  Nesterov(T learning_rate, T momentum = (T)0.9)
+      : Momentum<T>(learning_rate, momentum, true) {}
+};
+
+// RMSprop: s = rho * s + (1 - rho) dW^2, W -= lr * dW / (sqrt(s) + eps)
+template <typename T> class RMSprop : public Optimizer<T> {
+public:
+  RMSprop(T learning_rate, T rho = (T)0.9, T epsilon = (T)1e-8)
+      : Optimizer<T>(learning_rate), rho_(rho), epsilon_(epsilon) {
+    Math::assert_between(rho_, (T)0, (T)1);
+    Math::assert_gt(epsilon, (T)0);
+  }
 
-    W = W - (dW * this->lr_);
+  void step() override;
+
+private:
+  T rho_, epsilon_;
+
+  std::vector<std::shared_ptr<Math::Matrix<T>>> s_;
+};
+
+template <typename T> void RMSprop<T>::step(void) {
+  if (this->_rebind_state()) {
+    this->_init_state(s_);
   }
+  T lr = this->lr_;
+  T rho = rho_;
+  T oneMinusRho = (T)1 - rho_;
+  T eps = epsilon_;
+
+  detail::update(this->params_, this->grads_,
+                 [&](size_t i, T *w, const T *g) {
+                   T *s = s_[i]->data_ptr();
+                   return [=](size_t lo, size_t hi) {
+#pragma omp simd
+                     for (size_t j = lo; j < hi; j++) {
+                       T sj = rho * s[j] + oneMinusRho * g[j] * g[j];
+                       s[j] = sj;
+                       w[j] -= lr * g[j] / (std::sqrt(sj) + eps);
+                     }
+                   };
+                 });
 }
 
 // ADAM Optimizer
@@ -66,9 +243,15 @@ public:
 
   void step() override;
 
+protected:
+  // Decoupled weight decay (AdamW), zero for Adam
+  T weightDecay_ = (T)0;
+
 private:
   T beta1_, beta2_, epsilon_; // Adam hyperparameters
   int t_;                     // time Step
+  // beta^t, advanced once per step instead of a pow per parameter
+  T beta1Power_ = (T)1, beta2Power_ = (T)1;
 
   // Momentum history
   std::vector<std::shared_ptr<Math::Matrix<T>>> m_;
@@ -76,47 +259,176 @@ private:
 };
 
 // Adam Step Method
+//   m = b1 m + (1 - b1) dW,  v = b2 v + (1 - b2) dW^2
+//   W -= lr (m / (1 - b1^t)) / (sqrt(v / (1 - b2^t)) + eps) + lr wd W
 template <typename T> void Adam<T>::step(void) {
-
-  if (m_.empty()) {
-    for (const auto &param : this->params_) {
-      m_.push_back(std::make_shared<Math::Matrix<T>>(
-          std::vector<T>(param->size(), 0), param->shape()));
-      v_.push_back(std::make_shared<Math::Matrix<T>>(
-          std::vector<T>(param->size(), 0), param->shape()));
-    }
+  // New parameters start a new run: zero moments and restart the bias
+  // correction
+  if (this->_rebind_state()) {
+    this->_init_state(m_);
+    this->_init_state(v_);
+    t_ = 0;
+    beta1Power_ = (T)1;
+    beta2Power_ = (T)1;
   }
 
   t_++;
+  beta1Power_ *= beta1_;
+  beta2Power_ *= beta2_;
 
-  for (size_t i = 0; i < this->params_.size(); i++) {
+  // Bias corrections folded into the step size and the v scale
+  T b1 = beta1_, b2 = beta2_;
+  T oneMinusB1 = (T)1 - beta1_;
+  T oneMinusB2 = (T)1 - beta2_;
+  T stepSize = this->lr_ / ((T)1 - beta1Power_);
+  T vScale = (T)1 / ((T)1 - beta2Power_);
+  T eps = epsilon_;
+  T decay = this->lr_ * weightDecay_;
 
-    auto &W = *this->params_[i];
-    const auto &dW = *this->grads_[i];
-    auto &m = *this->m_[i];
-    auto &v = *this->v_[i];
+  detail::update(this->params_, this->grads_,
+                 [&](size_t i, T *w, const T *g) {
+                   T *m = m_[i]->data_ptr();
+                   T *v = v_[i]->data_ptr();
+                   return [=](size_t lo, size_t hi) {
+#pragma omp simd
+                     for (size_t j = lo; j < hi; j++) {
+                       T mj = b1 * m[j] + oneMinusB1 * g[j];
+                       T vj = b2 * v[j] + oneMinusB2 * g[j] * g[j];
+                       m[j] = mj;
+                       v[j] = vj;
+                       w[j] -= stepSize * mj / (std::sqrt(vj * vScale) + eps) +
+                               decay * w[j];
+                     }
+                   };
+                 });
+}
+
+// AdamW: Adam with the weight decay applied to the weights directly,
+// W -= lr * wd * W, instead of being added to the gradient
+template <typename T> class AdamW : public Adam<T> {
+public:
+  AdamW(T learning_rate, T weight_decay = (T)0.01, T beta1 = (T)0.9,
+        T beta2 = (T)0.999, T epsilon = (T)1e-8)
+      : Adam<T>(learning_rate, beta1, beta2, epsilon) {
+    Math::assert_lineq(weight_decay, (T)0, "AdamW weight decay");
+    this->weightDecay_ = weight_decay;
+  }
+};
 
-    // Update Momentum
-    m = (m * beta1_) + (dW * ((T)1.0 - beta1_));
+/********************************************************************************
+ *
+ * Mixed precision wrapper
+ *
+ * Model weights are kept rounded to bf16/fp16 while `inner` updates a full
+ * precision master copy, so small updates are not lost to rounding. Every
+ * step checks the gradients for overflow: a step with inf/NaN gradients is
+ * skipped and counted in skipped_steps().
+ *
+ * Gradients are computed and stored in T (only the cached activations and
+ * the weights are 16 bit), so there is no fp16 underflow to protect and the
+ * loss is not scaled by default. An explicit initialScale > 1 turns on
+ * dynamic loss scaling: the loss is scaled before backward, the gradients
+ * unscaled here, the scale halved on overflow and doubled again after
+ * `growthInterval` clean steps.
+ *
+ *   auto opt = std::make_shared<Optimizer::MixedPrecision<float>>(
+ *       std::make_shared<Optimizer::Adam<float>>(1e-3f),
+ *       Math::StorageFormat::FP16);
+ *
+ ********************************************************************************/
 
-    // update v
-    auto dW_sq = Math::Func::pow(dW, (T)2.0);
-    v = (v * beta2_) + (dW_sq * ((T)1.0 - beta2_));
+template <typename T> class MixedPrecision : public Optimizer<T> {
+public:
+  MixedPrecision(std::shared_ptr<Optimizer<T>> inner,
+                 Math::StorageFormat format, T initialScale = (T)1,
+                 int growthInterval = 2000)
+      : Optimizer<T>(inner->learning_rate()), inner_(inner), format_(format),
+        scale_(initialScale), dynamic_(initialScale > (T)1),
+        growthInterval_(growthInterval) {
+    Math::assert_lineq(initialScale, (T)1, "MixedPrecision loss scale");
+    Math::assert_gt(growthInterval, 0);
+  }
 
-    // Bias correction
-    T beta1_t = std::pow(beta1_, (T)t_);
-    T beta2_t = std::pow(beta2_, (T)t_);
+  void step() override;
+  T loss_scale() const override { return scale_; }
 
-    // Momentum update
-    auto m_hat = m / ((T)1.0 - beta1_t);
-    auto v_hat = v / ((T)1.0 - beta2_t);
+  Math::StorageFormat format() const { return format_; }
+  int skipped_steps() const { return skipped_; }
+  const std::vector<std::shared_ptr<Math::Matrix<T>>> &master_params() const {
+    return masters_;
+  }
 
-    // Params update
-    auto v_hat_sqrt = Math::Func::sqrt(v_hat);
-    auto denominator = v_hat_sqrt + epsilon_;
+private:
+  std::shared_ptr<Optimizer<T>> inner_;
+  Math::StorageFormat format_;
+  T scale_;
+  bool dynamic_;
+  int growthInterval_;
+  int goodSteps_ = 0;
+  int skipped_ = 0;
+
+  std::vector<std::shared_ptr<Math::Matrix<T>>> masters_;
+  std::vector<Math::Matrix<T> *> bound_;
+
+  void _bind_masters();
+};
+
+// Master copies are made once per set of parameters, and the model weights
+// rounded from the start
+template <typename T> void MixedPrecision<T>::_bind_masters(void) {
+  bool same = bound_.size() == this->params_.size();
+  for (size_t i = 0; same && i < bound_.size(); i++) {
+    same = bound_[i] == this->params_[i].get();
+  }
+  if (same) {
+    return;
+  }
+
+  Math::Memory::PersistentScope persistent;
+  masters_.clear();
+  bound_.clear();
+  for (const auto &param : this->params_) {
+    masters_.push_back(std::make_shared<Math::Matrix<T>>(*param));
+    bound_.push_back(param.get());
+    Math::Half::round_into(format_, *param, *param);
+  }
+  inner_->setup(masters_, this->grads_);
+}
+
+template <typename T> void MixedPrecision<T>::step(void) {
+  _bind_masters();
+
+  // Unscale (when scaling) and look for overflow
+  bool finite = true;
+  for (const auto &grad : this->grads_) {
+    if (scale_ != (T)1) {
+      Math::Linalg::scal((T)1 / scale_, *grad);
+    }
+    const T *g = grad->data_ptr();
+    for (size_t j = 0; j < grad->size(); j++) {
+      finite = finite && std::isfinite(g[j]);
+    }
+  }
+
+  if (!finite) {
+    if (dynamic_) {
+      scale_ = std::max(scale_ / (T)2, (T)1);
+      goodSteps_ = 0;
+    }
+    skipped_++;
+    return;
+  }
+
+  inner_->setup(masters_, this->grads_);
+  inner_->step();
+
+  for (size_t i = 0; i < masters_.size(); i++) {
+    Math::Half::round_into(format_, *masters_[i], *this->params_[i]);
+  }
 
-    auto update = m_hat / denominator;
-    W = W - (update * this->lr_);
+  if (dynamic_ && ++goodSteps_ >= growthInterval_) {
+    scale_ *= (T)2;
+    goodSteps_ = 0;
   }
 }
 
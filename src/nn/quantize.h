@@ -0,0 +1,291 @@
+#pragma once
+#include "../math/gemm.h"
+#include "../math/matrix.h"
+#include "../math/matrix_linalg.h"
+#include "../utils/asserts.h"
+#include "../utils/thread_pool.h"
+#include "fused_dense.h"
+#include "layers.h"
+#include "ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+/********************************************************************************
+ *
+ * Post-training int8 quantization for inference
+ *
+ * Symmetric quantization, no zero points:
+ *
+ *   weights  one scale per output channel   s_w[j] = max_k |W[k][j]| / 127
+ *   inputs   one scale per layer            s_x    = max |x| / 127
+ *            (calibrated on a sample of the data, e.g. X_val)
+ *
+ *   y[i][j] = act(s_x * s_w[j] * sum_k q_x[i][k] * q_w[k][j] + b[j])
+ *
+ * The sum runs in Gemm::gemm_s8 with int32 accumulation; dequantization, the
+ * bias and the activation stay in T. Weights take 1 byte per value instead
+ * of sizeof(T). The activation runs as a stateless kernel (Fused::BiasAct),
+ * never through the Operation shared with the training model, so predict
+ * is const and safe to call from several threads.
+ *
+ ********************************************************************************/
+
+namespace NN {
+
+enum class Inference { Float, Int8 };
+
+namespace Quant {
+
+constexpr int QMAX = 127;
+
+// Scale mapping [-maxAbs, maxAbs] onto [-127, 127]
+template <typename T> T scale_for(T maxAbs) {
+  return maxAbs > (T)0 ? maxAbs / (T)QMAX : (T)1;
+}
+
+template <typename T> T max_abs(const T *x, size_t n) {
+  T m = (T)0;
+#pragma omp simd reduction(max : m)
+  for (size_t i = 0; i < n; i++) {
+    m = std::max(m, std::fabs(x[i]));
+  }
+  return m;
+}
+
+template <typename T> int16_t quantize_value(T x, T invScale) {
+  T q = std::nearbyint(x * invScale);
+  return (int16_t)std::min((T)QMAX, std::max((T)-QMAX, q));
+}
+
+// q = round(x / scale) clamped to [-127, 127], as the int16 rows gemm_s8
+// reads. Columns [cols, ldq) are zero padding.
+template <typename T>
+void quantize_rows(const Math::Matrix<T> &x, T scale, int16_t *q, int ldq) {
+  int rows = x.shape()[0];
+  int cols = x.shape()[1];
+  T inv = (T)1 / scale;
+  const T *src = x.data_ptr();
+
+  Utils::parallel_for(0, (size_t)rows, Utils::grain_for(cols),
+                      [&](size_t lo, size_t hi) {
+                        for (size_t i = lo; i < hi; i++) {
+                          const T *s = src + i * cols;
+                          int16_t *d = q + i * ldq;
+                          for (int k = 0; k < cols; k++) {
+                            d[k] = quantize_value(s[k], inv);
+                          }
+                          std::fill(d + cols, d + ldq, (int16_t)0);
+                        }
+                      });
+}
+
+/*******************************************************
+ * Quantized Dense layer
+ *******************************************************/
+
+template <typename T> class QuantizedDense {
+public:
+  QuantizedDense(const Math::Matrix<T> &weights, const Math::Matrix<T> &bias,
+                 std::shared_ptr<Ops::Operation<T>> activation, T inputScale);
+
+  Math::Matrix<T> forward(const Math::Matrix<T> &x) const;
+
+  int inputs() const { return weights_.K; }
+  Ops::Fusable activation() const { return act_; }
+  int outputs() const { return weights_.N; }
+  T input_scale() const { return inputScale_; }
+  const Math::AlignedVector<T> &weight_scales() const {
+    return weightScales_;
+  }
+  // Packed int8 weights alone, 1 byte per weight (K rounded up to even)
+  size_t int8_bytes() const { return weights_.bytes(); }
+  // Packed int8 weights plus the per-channel scales and the bias
+  size_t bytes() const {
+    return weights_.bytes() + (weightScales_.size() + bias_.size()) * sizeof(T);
+  }
+
+private:
+  Math::Gemm::PackedS8 weights_;
+  Math::AlignedVector<T> weightScales_;
+  Math::AlignedVector<T> outScales_; // s_x * s_w[j]
+  Math::AlignedVector<T> bias_;
+  T inputScale_;
+  Ops::Fusable act_;
+};
+
+template <typename T>
+QuantizedDense<T>::QuantizedDense(const Math::Matrix<T> &weights,
+                                  const Math::Matrix<T> &bias,
+                                  std::shared_ptr<Ops::Operation<T>> activation,
+                                  T inputScale)
+    : inputScale_(inputScale),
+      act_(activation ? activation->fusable() : Ops::Fusable::Linear) {
+  // Subclasses of the built-in activations are None too: the int8 path would
+  // silently swap their own forward for the base kernel
+  if (act_ == Ops::Fusable::None) {
+    throw std::invalid_argument(
+        "QuantizedDense: Activation has no stateless kernel.");
+  }
+  int K = weights.shape()[0];
+  int N = weights.shape()[1];
+  Math::assert_shape(bias.shape(), Math::Shape(1, N), "QuantizedDense");
+  Math::assert_gt(inputScale, (T)0, "QuantizedDense");
+
+  Math::Memory::PersistentScope persistent;
+  const T *W = weights.data_ptr();
+
+  // Per output channel (column) scales
+  weightScales_.assign(N, (T)0);
+  for (int k = 0; k < K; k++) {
+    for (int j = 0; j < N; j++) {
+      weightScales_[j] = std::max(weightScales_[j], std::fabs(W[k * N + j]));
+    }
+  }
+  for (auto &s : weightScales_) {
+    s = scale_for(s);
+  }
+
+  std::vector<int8_t> q((size_t)K * N);
+  for (int k = 0; k < K; k++) {
+    for (int j = 0; j < N; j++) {
+      q[(size_t)k * N + j] =
+          (int8_t)quantize_value(W[k * N + j], (T)1 / weightScales_[j]);
+    }
+  }
+  weights_ = Math::Gemm::pack_s8(K, N, q.data(), N);
+
+  outScales_.resize(N);
+  for (int j = 0; j < N; j++) {
+    outScales_[j] = inputScale_ * weightScales_[j];
+  }
+  bias_.assign(bias.data_ptr(), bias.data_ptr() + N);
+}
+
+template <typename T>
+Math::Matrix<T> QuantizedDense<T>::forward(const Math::Matrix<T> &x) const {
+  Math::assert_eq(x.shape()[1], inputs(), "QuantizedDense::forward");
+  int M = x.shape()[0];
+  int N = outputs();
+  int Kp = weights_.Kp;
+
+  Math::AlignedVector<int16_t> q((size_t)M * Kp);
+  quantize_rows(x, inputScale_, q.data(), Kp);
+
+  Math::AlignedVector<int32_t> acc((size_t)M * N);
+  Math::Gemm::gemm_s8(M, q.data(), Kp, weights_, acc.data(), N);
+
+  // Dequantize, then bias and activation on the row while it is in cache
+  Math::AlignedVector<T> y((size_t)M * N);
+  Fused::with_bias_act(act_, bias_.data(), [&](const auto &ep) {
+    Utils::parallel_for(0, (size_t)M, Utils::grain_for(N),
+                        [&](size_t lo, size_t hi) {
+                          for (size_t i = lo; i < hi; i++) {
+                            const int32_t *a = acc.data() + i * N;
+                            T *out = y.data() + i * N;
+#pragma omp simd
+                            for (int j = 0; j < N; j++) {
+                              out[j] = (T)a[j] * outScales_[j];
+                            }
+                            ep(out, 0, N);
+                          }
+                        });
+  });
+  if (act_ == Ops::Fusable::Softmax) {
+    Fused::softmax_rows(y.data(), y.data(), (size_t)M, (size_t)N);
+  }
+
+  return Math::Matrix<T>(std::move(y), {M, N});
+}
+
+/*******************************************************
+ * Quantized network
+ *******************************************************/
+
+template <typename T> class QuantizedNetwork {
+public:
+  // Quantize every Dense layer of `layers` (already built by a forward
+  // pass), calibrating the input scales on `sample`
+  QuantizedNetwork(const std::vector<Layer::Layer<T> *> &layers,
+                   const Math::Matrix<T> &sample);
+
+  Math::Matrix<T> predict(const Math::Matrix<T> &x) const;
+  // Index of the largest output of every row
+  std::vector<int> predict_classes(const Math::Matrix<T> &x) const;
+
+  const std::vector<QuantizedDense<T>> &layers() const { return layers_; }
+  size_t weight_bytes() const {
+    size_t total = 0;
+    for (const auto &layer : layers_) {
+      total += layer.bytes();
+    }
+    return total;
+  }
+
+private:
+  std::vector<QuantizedDense<T>> layers_;
+};
+
+template <typename T>
+QuantizedNetwork<T>::QuantizedNetwork(
+    const std::vector<Layer::Layer<T> *> &layers,
+    const Math::Matrix<T> &sample) {
+  if (layers.empty()) {
+    throw std::invalid_argument("Quant: The network has no layers.");
+  }
+
+  // Float forward pass over the sample, recording the range of every input
+  Math::Matrix<T> current = sample;
+  for (Layer::Layer<T> *layer : layers) {
+    auto *dense = dynamic_cast<Layer::Dense<T> *>(layer);
+    if (!dense) {
+      throw std::invalid_argument("Quant: Only Dense layers can be quantized, "
+                                  "found " +
+                                  layer->get_type());
+    }
+    auto params = dense->params();
+    if (params.size() != 2) {
+      throw std::runtime_error("Quant: Run the model once before quantizing.");
+    }
+    const Math::Matrix<T> &W = *params[0];
+    const Math::Matrix<T> &b = *params[1];
+
+    T scale = scale_for(max_abs(current.data_ptr(), current.size()));
+    layers_.emplace_back(W, b, dense->activation(), scale);
+
+    // Same stateless kernel as inference, the layer's Operation keeps its
+    // cache
+    Math::Matrix<T> next;
+    Fused::dense_forward<T>(current, W, b, layers_.back().activation(), next);
+    current = std::move(next);
+  }
+}
+
+template <typename T>
+Math::Matrix<T> QuantizedNetwork<T>::predict(const Math::Matrix<T> &x) const {
+  Math::Matrix<T> current = layers_.front().forward(x);
+  for (size_t l = 1; l < layers_.size(); l++) {
+    current = layers_[l].forward(current);
+  }
+  return current;
+}
+
+template <typename T>
+std::vector<int>
+QuantizedNetwork<T>::predict_classes(const Math::Matrix<T> &x) const {
+  Math::Matrix<T> out = predict(x);
+  int rows = out.shape()[0];
+  int cols = out.shape()[1];
+  std::vector<int> classes(rows);
+  for (int i = 0; i < rows; i++) {
+    const T *row = out.data_ptr() + (size_t)i * cols;
+    classes[i] = (int)(std::max_element(row, row + cols) - row);
+  }
+  return classes;
+}
+
+} // namespace Quant
+} // namespace NN
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../math/matrix.h"
+#include "../math/sparse.h"
 #include <charconv>
 #include <fstream>
 #include <memory>
@@ -23,6 +24,11 @@ public:
   const Math::Matrix<int> &getFeatures(void) const;
   const Math::Matrix<int> &getLabels(void) const;
 
+  // Features en formato CSR (solo los valores distintos de cero)
+  template <typename T> Math::SparseMatrix<T> getSparseFeatures(void) const {
+    return Math::SparseMatrix<T>::from_dense(getFeatures());
+  }
+
 private:
   // Usamos unique_ptr porque Matrix no tiene constructor por defecto
   // y queremos inicializarlas solo cuando tengamos los datos listos.
@@ -44,8 +50,8 @@ inline void DataLoader::loadData(void) {
   std::string line;
 
   // Vectores temporales planos para acumular datos
-  std::vector<int> flat_features;
-  std::vector<int> flat_labels;
+  Math::AlignedVector<int> flat_features;
+  Math::AlignedVector<int> flat_labels;
 
   // Optimizacion: Reservar memoria si conocemos el tamaño aproximado (opcional)
   // flat_features.reserve(50000 * 784);
@@ -24,10 +24,10 @@ public:
     }
 
     int rows = labels.shape()[0];
-    const std::vector<int> &rawLabels =
+    const Math::AlignedVector<int> &rawLabels =
         labels.data(); // Accedemos al vector interno
 
-    std::vector<T> oneHotData(rows * numClasses, (T)0.0);
+    Math::AlignedVector<T> oneHotData(rows * numClasses, (T)0.0);
 
     for (int i = 0; i < rows; ++i) {
       int label = rawLabels[i];
@@ -47,10 +47,10 @@ public:
    * Inverso: Convierte probabilidades One-Hot de vuelta a etiquetas (ArgMax)
    * Útil para calcular Accuracy o mostrar predicciones en la GUI.
    */
-  template <typename T>
-  static int argMax(const std::vector<T> &probabilityVector) {
+  template <typename Container>
+  static int argMax(const Container &probabilityVector) {
     int maxIndex = 0;
-    T maxVal = probabilityVector[0];
+    auto maxVal = probabilityVector[0];
     for (size_t i = 1; i < probabilityVector.size(); ++i) {
       if (probabilityVector[i] > maxVal) {
         maxVal = probabilityVector[i];
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../math/matrix.h"
+#include "../math/sparse.h"
 #include <algorithm> // para std::shuffle
 #include <memory>
 #include <numeric> // para std::iota
@@ -10,12 +11,21 @@
 
 namespace Utils {
 
-// Estructura contenedora para devolver los 4 conjuntos de datos
-template <typename T> struct TrainTestSplit {
+// Estructura contenedora para devolver los 4 conjuntos de datos. Las
+// etiquetas pueden ser One-Hot (L = T) o índices de clase (L = int)
+template <typename T, typename L = T> struct TrainTestSplit {
   Math::Matrix<T> X_train;
-  Math::Matrix<T> Y_train;
+  Math::Matrix<L> Y_train;
   Math::Matrix<T> X_val;
-  Math::Matrix<T> Y_val;
+  Math::Matrix<L> Y_val;
+};
+
+// Igual, con las features en formato CSR
+template <typename T, typename L = T> struct SparseTrainTestSplit {
+  Math::SparseMatrix<T> X_train;
+  Math::Matrix<L> Y_train;
+  Math::SparseMatrix<T> X_val;
+  Math::Matrix<L> Y_val;
 };
 
 class SplitShuffle {
@@ -23,13 +33,14 @@ public:
   /**
    * Divide y mezcla aleatoriamente los datos.
    * @param features Matriz de características [N x Features]
-   * @param labels Matriz de etiquetas One-Hot [N x Outputs]
+   * @param labels Matriz de etiquetas One-Hot [N x Outputs] o de índices de
+   * clase [N x 1] (Matrix<int>, sin expandir)
    * @param trainRatio Proporción para entrenamiento (ej. 0.8)
    */
-  template <typename T>
-  static TrainTestSplit<T> split(const Math::Matrix<T> &features,
-                                 const Math::Matrix<T> &labels,
-                                 float trainRatio = 0.8f, int seed = -1) {
+  template <typename T, typename L>
+  static TrainTestSplit<T, L> split(const Math::Matrix<T> &features,
+                                    const Math::Matrix<L> &labels,
+                                    float trainRatio = 0.8f, int seed = -1) {
 
     if (features.shape()[0] != labels.shape()[0]) {
       throw std::runtime_error(
@@ -41,26 +52,22 @@ public:
     size_t labelCols = labels.shape()[1];
 
     // 1. Generar índices y mezclarlos (Shuffle)
-    std::vector<size_t> indices(totalRows);
-    std::iota(indices.begin(), indices.end(), 0);
-
-    std::random_device rd;
-    std::mt19937 g(seed == -1 ? rd() : seed);
-    std::shuffle(indices.begin(), indices.end(), g);
+    std::vector<size_t> indices = shuffled_indices(totalRows, seed);
 
     // 2. Calcular puntos de corte
     size_t trainCount = static_cast<size_t>(totalRows * trainRatio);
     size_t valCount = totalRows - trainCount;
 
     // 3. Preparar vectores
-    std::vector<T> x_train, y_train, x_val, y_val;
+    Math::AlignedVector<T> x_train, x_val;
+    Math::AlignedVector<L> y_train, y_val;
     x_train.reserve(trainCount * featureCols);
     y_train.reserve(trainCount * labelCols);
     x_val.reserve(valCount * featureCols);
     y_val.reserve(valCount * labelCols);
 
-    const std::vector<T> &src_x = features.data();
-    const std::vector<T> &src_y = labels.data();
+    const Math::AlignedVector<T> &src_x = features.data();
+    const Math::AlignedVector<L> &src_y = labels.data();
 
     // 4. Distribuir datos
     for (size_t i = 0; i < totalRows; ++i) {
@@ -84,9 +91,59 @@ public:
     return {
         Math::Matrix<T>(std::move(x_train),
                         {(int)trainCount, (int)featureCols}),
-        Math::Matrix<T>(std::move(y_train), {(int)trainCount, (int)labelCols}),
+        Math::Matrix<L>(std::move(y_train), {(int)trainCount, (int)labelCols}),
         Math::Matrix<T>(std::move(x_val), {(int)valCount, (int)featureCols}),
-        Math::Matrix<T>(std::move(y_val), {(int)valCount, (int)labelCols})};
+        Math::Matrix<L>(std::move(y_val), {(int)valCount, (int)labelCols})};
+  }
+
+  /**
+   * Igual que split, con features dispersas. Con la misma semilla reparte
+   * las filas igual que la versión densa.
+   */
+  template <typename T, typename L>
+  static SparseTrainTestSplit<T, L> split(const Math::SparseMatrix<T> &features,
+                                          const Math::Matrix<L> &labels,
+                                          float trainRatio = 0.8f,
+                                          int seed = -1) {
+
+    if ((size_t)features.rows() != (size_t)labels.shape()[0]) {
+      throw std::runtime_error(
+          "SplitShuffle: Las filas de features y labels no coinciden.");
+    }
+
+    size_t totalRows = features.rows();
+    std::vector<size_t> indices = shuffled_indices(totalRows, seed);
+
+    size_t trainCount = static_cast<size_t>(totalRows * trainRatio);
+    std::vector<size_t> trainRows(indices.begin(), indices.begin() + trainCount);
+    std::vector<size_t> valRows(indices.begin() + trainCount, indices.end());
+
+    return {features.gather_rows(trainRows), gather_rows(labels, trainRows),
+            features.gather_rows(valRows), gather_rows(labels, valRows)};
+  }
+
+private:
+  static std::vector<size_t> shuffled_indices(size_t totalRows, int seed) {
+    std::vector<size_t> indices(totalRows);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::random_device rd;
+    std::mt19937 g(seed == -1 ? rd() : seed);
+    std::shuffle(indices.begin(), indices.end(), g);
+    return indices;
+  }
+
+  template <typename T>
+  static Math::Matrix<T> gather_rows(const Math::Matrix<T> &src,
+                                     const std::vector<size_t> &rows) {
+    size_t cols = src.shape()[1];
+    Math::AlignedVector<T> out;
+    out.reserve(rows.size() * cols);
+    for (size_t row : rows) {
+      out.insert(out.end(), src.data().begin() + row * cols,
+                 src.data().begin() + (row + 1) * cols);
+    }
+    return Math::Matrix<T>(std::move(out), {(int)rows.size(), (int)cols});
   }
 };
 
@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/********************************************************************************
+ *
+ * Thread pool runtime for the Math kernels
+ *
+ * A process-wide pool of persistent workers executes parallel_for ranges. The
+ * calling thread always takes part in the work, so a pool of N threads runs
+ * N - 1 workers.
+ *
+ *   Utils::parallel_for(0, rows, Utils::grain_for(cols),
+ *                       [&](size_t lo, size_t hi) { ... rows [lo, hi) ... });
+ *
+ * - Ranges smaller than two grains run inline on the caller, so tiny
+ *   matrices (bias rows, single samples) never pay for synchronization.
+ * - Calls made from inside a parallel region, or while another thread owns
+ *   the pool, also run inline: there is never more than one level of
+ *   parallelism and never more threads than configured.
+ * - The thread count comes from set_num_threads(), else the
+ *   BRAINSIM_NUM_THREADS environment variable, else the hardware concurrency.
+ *
+ ********************************************************************************/
+
+namespace Utils {
+
+// Minimum amount of scalar work (elements touched) worth one parallel task
+constexpr size_t MIN_PARALLEL_WORK = (size_t)1 << 15;
+
+// Grain, in items, for items that each touch `workPerItem` elements
+inline size_t grain_for(size_t workPerItem) {
+  return std::max((size_t)1,
+                  MIN_PARALLEL_WORK / std::max((size_t)1, workPerItem));
+}
+
+class ThreadPool {
+public:
+  static ThreadPool &instance() {
+    static ThreadPool pool(_default_threads());
+    return pool;
+  }
+
+  ~ThreadPool() { _stop_workers(); }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Threads taking part in a parallel_for, the caller included. Safe to call
+  // while another thread resizes the pool.
+  size_t num_threads() const {
+    return numWorkers_.load(std::memory_order_acquire) + 1;
+  }
+
+  // Resize the pool. Must not be called from inside a parallel region.
+  void set_num_threads(size_t n) {
+    std::lock_guard<std::mutex> submit(submit_);
+    _stop_workers();
+    _start_workers(std::max((size_t)1, n));
+  }
+
+  // Run body(lo, hi) over [begin, end) split in chunks of at least `grain`
+  template <typename F>
+  void parallel_for(size_t begin, size_t end, size_t grain, F &&body) {
+    if (begin >= end) {
+      return;
+    }
+    size_t n = end - begin;
+    grain = std::max((size_t)1, grain);
+
+    if (numWorkers_.load(std::memory_order_acquire) == 0 || n < 2 * grain ||
+        _in_parallel()) {
+      body(begin, end);
+      return;
+    }
+
+    std::unique_lock<std::mutex> submit(submit_, std::try_to_lock);
+    if (!submit.owns_lock()) {
+      body(begin, end);
+      return;
+    }
+
+    // Stable while submit_ is held: set_num_threads takes it too
+    size_t workers = numWorkers_.load(std::memory_order_relaxed);
+    if (workers == 0) {
+      body(begin, end);
+      return;
+    }
+
+    // A few chunks per thread balance uneven rows without tiny tasks
+    size_t threads = workers + 1;
+    size_t chunk = std::max(grain, (n + 4 * threads - 1) / (4 * threads));
+
+    Job job;
+    job.begin = begin;
+    job.end = end;
+    job.chunk = chunk;
+    job.ctx = &body;
+    job.invoke = [](void *ctx, size_t lo, size_t hi) {
+      (*static_cast<std::remove_reference_t<F> *>(ctx))(lo, hi);
+    };
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = job;
+      next_.store(begin, std::memory_order_relaxed);
+      error_ = nullptr;
+      pending_ = workers;
+      generation_++;
+    }
+    wake_.notify_all();
+
+    _in_parallel() = true;
+    _run(job);
+    _in_parallel() = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  struct Job {
+    size_t begin{0}, end{0}, chunk{1};
+    void *ctx{nullptr};
+    void (*invoke)(void *, size_t, size_t){nullptr};
+  };
+
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> numWorkers_{0}; // workers_.size(), readable lock-free
+  std::mutex submit_; // one parallel_for at a time
+  std::mutex mutex_;  // guards the fields below
+  std::condition_variable wake_, done_;
+  Job job_;
+  std::atomic<size_t> next_{0};
+  std::exception_ptr error_;
+  size_t pending_{0};
+  unsigned long generation_{0};
+  bool stop_{false};
+
+  explicit ThreadPool(size_t n) { _start_workers(std::max((size_t)1, n)); }
+
+  static bool &_in_parallel() {
+    thread_local bool inside = false;
+    return inside;
+  }
+
+  static size_t _default_threads() {
+    if (const char *env = std::getenv("BRAINSIM_NUM_THREADS")) {
+      int n = std::atoi(env);
+      if (n > 0) {
+        return (size_t)n;
+      }
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+  }
+
+  // Claim chunks until the range is exhausted
+  void _run(const Job &job) {
+    while (true) {
+      size_t lo = next_.fetch_add(job.chunk, std::memory_order_relaxed);
+      if (lo >= job.end) {
+        return;
+      }
+      size_t hi = std::min(job.end, lo + job.chunk);
+      try {
+        job.invoke(job.ctx, lo, hi);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+    }
+  }
+
+  // `seen` is the generation current when the worker started, so a worker
+  // added by set_num_threads never replays an old job
+  void _worker(unsigned long seen) {
+    _in_parallel() = true;
+
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+        job = job_;
+      }
+
+      _run(job);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  void _start_workers(size_t n) {
+    stop_ = false;
+    for (size_t i = 1; i < n; i++) {
+      workers_.emplace_back([this, g = generation_] { _worker(g); });
+    }
+    numWorkers_.store(workers_.size(), std::memory_order_release);
+  }
+
+  void _stop_workers() {
+    numWorkers_.store(0, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+  }
+};
+
+/*******************************************************
+ * Free Functions
+ *******************************************************/
+
+template <typename F>
+void parallel_for(size_t begin, size_t end, size_t grain, F &&body) {
+  ThreadPool::instance().parallel_for(begin, end, grain,
+                                      std::forward<F>(body));
+}
+
+inline void set_num_threads(size_t n) {
+  ThreadPool::instance().set_num_threads(n);
+}
+
+inline size_t get_num_threads() { return ThreadPool::instance().num_threads(); }
+
+} // namespace Utils
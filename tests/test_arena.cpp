@@ -0,0 +1,146 @@
+#include "../src/math/arena.h"
+#include "../src/math/matrix.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/cost_func.h"
+#include "../src/nn/layers.h"
+#include "../src/nn/model.h"
+#include "../src/nn/optimizer.h"
+#include "test_utils.h"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+using namespace Math;
+
+// Red 3 -> 4 (Tanh) -> 2 (Sigmoid)
+static std::shared_ptr<NN::Layer::Sequential<double>> make_net() {
+  auto net = std::make_shared<NN::Layer::Sequential<double>>();
+  net->add(std::make_shared<NN::Layer::Dense<double>>(
+      4, std::make_shared<NN::ActFunc::Tanh<double>>()));
+  net->add(std::make_shared<NN::Layer::Dense<double>>(
+      2, std::make_shared<NN::ActFunc::Sigmoid<double>>()));
+  return net;
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: ARENA ALLOCATOR ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Bump allocation y reset en O(1)
+  // ---------------------------------------------------------
+  TEST_CASE("Arena: Scoped matrices come from the arena and are rewound");
+  {
+    Memory::Arena arena(4096);
+    const double *first = nullptr;
+
+    {
+      Memory::ArenaScope scope(arena);
+      Matrix<double> a({1.0, 2.0, 3.0}, {1, 3});
+      Matrix<double> b = a * 2.0;
+      first = a.data_ptr();
+
+      ASSERT_EQ(arena.used() > 0, true);
+      ASSERT_EQ((uintptr_t)b.data_ptr() % 64, (uintptr_t)0);
+      ASSERT_ALMOST_EQ(b.data_ptr()[2], 6.0);
+    }
+    ASSERT_EQ(arena.used(), (size_t)0);
+
+    // El siguiente paso reutiliza la misma memoria
+    {
+      Memory::ArenaScope scope(arena);
+      Matrix<double> c({4.0, 5.0, 6.0}, {1, 3});
+      ASSERT_EQ(c.data_ptr() == first, true);
+    }
+
+    // Peticiones mayores que un bloque reciben su propio bloque
+    {
+      Memory::ArenaScope scope(arena);
+      Matrix<double> big = Linalg::ones<double>({64, 64});
+      ASSERT_ALMOST_EQ(big.data_ptr()[64 * 64 - 1], 1.0);
+    }
+    ASSERT_EQ(arena.capacity() >= 64 * 64 * sizeof(double), true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: PersistentScope escapa del arena
+  // ---------------------------------------------------------
+  TEST_CASE("Arena: PersistentScope allocates on the heap");
+  {
+    Memory::Arena arena(4096);
+    Matrix<double> kept;
+
+    {
+      Memory::ArenaScope scope(arena);
+      Matrix<double> tmp({1.0, 2.0}, {1, 2});
+      size_t used = arena.used();
+
+      Memory::PersistentScope persistent;
+      kept = Matrix<double>(tmp);
+      ASSERT_EQ(arena.used(), used);
+    }
+
+    // Sobrescribir el arena no afecta a la matriz persistente
+    {
+      Memory::ArenaScope scope(arena);
+      Matrix<double> noise({9.0, 9.0, 9.0, 9.0}, {2, 2});
+      ASSERT_ALMOST_EQ(kept.data_ptr()[1], 2.0);
+    }
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: train_step con arena == pasos manuales sin arena
+  // ---------------------------------------------------------
+  TEST_CASE("Arena: Model::train_step matches steps without arena");
+  {
+    Matrix<double> X({0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.1,
+                      1.2},
+                     {4, 3});
+    Matrix<double> Y({0, 1, 1, 0, 0, 1, 1, 0}, {4, 2});
+
+    auto netA = make_net();
+    auto netB = make_net();
+    netA->forward(X);
+    netB->forward(X);
+
+    // Mismos pesos iniciales en ambas redes
+    auto pA = netA->params();
+    auto pB = netB->params();
+    for (size_t i = 0; i < pA.size(); i++) {
+      *pB[i] = *pA[i];
+    }
+
+    NN::Model<double> model;
+    model.set_layers(netA);
+    model.compile(std::make_shared<NN::CostFunc::MeanSquareError<double>>(),
+                  std::make_shared<NN::Optimizer::Adam<double>>(0.05));
+
+    auto lossB = std::make_shared<NN::CostFunc::MeanSquareError<double>>();
+    NN::Optimizer::Adam<double> optB(0.05);
+
+    double lastA = 0.0, lastB = 0.0;
+    size_t capacity = 0;
+    for (int step = 0; step < 20; step++) {
+      lastA = model.train_step(X, Y);
+
+      auto pred = netB->forward(X);
+      lastB = lossB->forward(pred, Y);
+      netB->backward(lossB->backward());
+      optB.setup(netB->params(), netB->param_grads());
+      optB.step();
+
+      if (step == 1) {
+        capacity = model.arena().capacity();
+      }
+    }
+
+    ASSERT_ALMOST_EQ(lastA, lastB);
+    ASSERT_EQ(model.arena().used(), (size_t)0);
+    // Tras el calentamiento el arena no vuelve a crecer
+    ASSERT_EQ(model.arena().capacity(), capacity);
+
+    Matrix<double> out = model.predict(X);
+    ASSERT_EQ(out.shape()[1], 2);
+  }
+
+  return run_test_summary();
+}
@@ -0,0 +1,200 @@
+#include "../src/math/matrix.h"
+#include "../src/math/simd.h"
+#include "../src/utils/thread_pool.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace Math;
+
+// Valor de a en (i, j) repitiendo sus ejes de tamaño 1
+static double at(const Matrix<double> &a, int i, int j) {
+  int r = a.shape()[0] == 1 ? 0 : i;
+  int c = a.shape()[1] == 1 ? 0 : j;
+  return a.data_ptr()[(size_t)r * a.shape()[1] + c];
+}
+
+// Comprueba out == op(a, b) con la regla de broadcasting de NumPy
+template <typename F>
+static bool check(const Matrix<double> &a, const Matrix<double> &b,
+                  const Matrix<double> &out, F op) {
+  int rows = std::max(a.shape()[0], b.shape()[0]);
+  int cols = std::max(a.shape()[1], b.shape()[1]);
+  if (out.shape()[0] != rows || out.shape()[1] != cols) {
+    return false;
+  }
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      double ref = op(at(a, i, j), at(b, i, j));
+      if (std::abs(out.data_ptr()[(size_t)i * cols + j] - ref) > 1e-12) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Las cuatro operaciones sobre todas las combinaciones de formas
+static bool check_all_ops(int M, int N) {
+  std::vector<Matrix<double>> shapes = {iota(M, N, 1.0), iota(1, N, 2.0),
+                                        iota(M, 1, 3.0), iota(1, 1, 4.0)};
+  bool ok = true;
+  for (const auto &a : shapes) {
+    for (const auto &b : shapes) {
+      ok = ok && check(a, b, a + b, [](double x, double y) { return x + y; });
+      ok = ok && check(a, b, a - b, [](double x, double y) { return x - y; });
+      ok = ok && check(a, b, a * b, [](double x, double y) { return x * y; });
+      ok = ok && check(a, b, a / b, [](double x, double y) { return x / y; });
+    }
+  }
+  return ok;
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: BROADCASTING ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Todas las formas compatibles, operaciones e ISA
+  // ---------------------------------------------------------
+  TEST_CASE("Broadcast: +, -, *, / on every compatible shape pair and ISA");
+  {
+    bool ok = true;
+    for (int isa = 0; isa <= (int)Simd::detect_isa(); isa++) {
+      Simd::set_isa((Simd::Isa)isa);
+      ok = ok && check_all_ops(5, 7) && check_all_ops(33, 1) &&
+           check_all_ops(1, 19);
+    }
+    Simd::set_isa(Simd::detect_isa());
+    ASSERT_EQ(ok, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Producto exterior (M x 1) (op) (1 x N)
+  // ---------------------------------------------------------
+  TEST_CASE("Broadcast: Column and row expand to M x N");
+  {
+    Matrix<double> col({1.0, 2.0, 3.0}, {3, 1});
+    Matrix<double> row({10.0, 20.0}, {1, 2});
+
+    Matrix<double> diff = col - row;
+    ASSERT_EQ(diff.shape()[0], 3);
+    ASSERT_EQ(diff.shape()[1], 2);
+    ASSERT_ALMOST_EQ(diff.data_ptr()[0], -9.0);
+    ASSERT_ALMOST_EQ(diff.data_ptr()[5], -17.0);
+
+    Matrix<double> outer = row * col;
+    ASSERT_ALMOST_EQ(outer.data_ptr()[3], 40.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Normalización en una sola expresión
+  // ---------------------------------------------------------
+  TEST_CASE("Broadcast: (X - mean) / std * gamma + beta in one pass");
+  {
+    Matrix<double> X = iota(4, 3, 1.0);
+    Matrix<double> mean({5.5, 6.5, 7.5}, {1, 3});
+    Matrix<double> std({2.0, 4.0, 8.0}, {1, 3});
+    Matrix<double> gamma({1.0, 2.0, 3.0}, {1, 3});
+    Matrix<double> beta({0.5, 0.5, 0.5}, {1, 3});
+
+    Matrix<double> Y = (X - mean) / std * gamma + beta;
+    ASSERT_ALMOST_EQ(Y.data_ptr()[0], (1.0 - 5.5) / 2.0 + 0.5);
+    ASSERT_ALMOST_EQ(Y.data_ptr()[11], (12.0 - 7.5) / 8.0 * 3.0 + 0.5);
+
+    // Normalización por filas con una columna de sumas
+    Matrix<double> sums({6.0, 15.0, 24.0, 33.0}, {4, 1});
+    Matrix<double> P = (X * 1.0) / sums; // cadena fusionada, no Simd
+    ASSERT_ALMOST_EQ(P.data_ptr()[3] + P.data_ptr()[4] + P.data_ptr()[5], 1.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Vistas, operadores compuestos y errores
+  // ---------------------------------------------------------
+  TEST_CASE("Broadcast: Views, compound assignment and incompatible shapes");
+  {
+    Matrix<double> X = iota(4, 3, 1.0);
+    Matrix<double> centered = X - X.viewRow(0);
+    ASSERT_ALMOST_EQ(centered.data_ptr()[10], 9.0);
+
+    Matrix<double> byCol = X * X.viewCol(2);
+    ASSERT_ALMOST_EQ(byCol.data_ptr()[4], 5.0 * 6.0);
+
+    Matrix<double> m = iota(2, 3, 1.0);
+    Matrix<double> col({2.0, 4.0}, {2, 1});
+    m /= col;
+    ASSERT_ALMOST_EQ(m.data_ptr()[5], 6.0 / 4.0);
+    m *= Matrix<double>({1.0, 10.0, 100.0}, {1, 3});
+    ASSERT_ALMOST_EQ(m.data_ptr()[2], 300.0 / 2.0);
+
+    // El resultado no puede cambiar la forma del destino
+    Matrix<double> small = col;
+    ASSERT_THROWS(small += m, std::invalid_argument);
+    ASSERT_THROWS(X + Matrix<double>({1.0, 2.0}, {1, 2}), std::invalid_argument);
+    ASSERT_THROWS(X * iota(2, 1, 1.0), std::invalid_argument);
+    ASSERT_THROWS(X / Matrix<double>({1.0, 0.0, 1.0}, {1, 3}),
+                  std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 5: Varios hilos
+  // ---------------------------------------------------------
+  TEST_CASE("Broadcast: Same result with 4 threads");
+  {
+    size_t threads = Utils::get_num_threads();
+    Utils::set_num_threads(4);
+    Matrix<double> X = iota(300, 500, 1.0);
+    Matrix<double> col = iota(300, 1, 1.0);
+    Matrix<double> row = iota(1, 500, 1.0);
+    bool ok = check(X, col, X - col, [](double x, double y) { return x - y; }) &&
+              check(col, row, col * row,
+                    [](double x, double y) { return x * y; });
+    Utils::set_num_threads(threads);
+    ASSERT_EQ(ok, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 6: Operando difundido que es una vista del destino
+  // ---------------------------------------------------------
+  TEST_CASE("Broadcast: In-place update from a view of the destination");
+  {
+    size_t threads = Utils::get_num_threads();
+    bool ok = true;
+    for (size_t n : {1, 4}) {
+      Utils::set_num_threads(n);
+
+      Matrix<double> m = iota(3, 2, 1.0);
+      m -= m.viewRow(0);
+      ok = ok && close(m, Matrix<double>({0, 0, 2, 2, 4, 4}, {3, 2}), 0.0);
+
+      Matrix<double> d({2.0, 4.0, 3.0, 9.0, 5.0, 10.0}, {3, 2});
+      Matrix<double> e = d;
+      d /= d.viewCol(0);
+      e = e / e.viewCol(0);
+      ok = ok && close(d, Matrix<double>({1, 2, 1, 3, 1, 2}, {3, 2}), 0.0) &&
+           close(e, d, 0.0);
+
+      // Vista 1 x 1 y cadena fusionada (sin kernel Simd)
+      Matrix<double> s = iota(2, 3, 2.0);
+      s *= s.viewRow(0).viewCol(0);
+      ok = ok && close(s, iota(2, 3, 2.0) * 2.0, 0.0);
+      Matrix<double> f = iota(2, 3, 1.0);
+      f = (f * 2.0) - f.viewRow(1);
+      ok = ok && close(f, Matrix<double>({-2, -1, 0, 4, 5, 6}, {2, 3}), 0.0);
+
+      // Lo bastante grande para repartirse entre los hilos
+      Matrix<double> X = iota(300, 500, 1.0);
+      Matrix<double> ref = X / Matrix<double>(X.viewCol(0));
+      X /= X.viewCol(0);
+      ok = ok && close(X, ref, 0.0);
+      X = iota(300, 500, 1.0);
+      ref = X - Matrix<double>(X.viewRow(0));
+      X -= X.viewRow(0);
+      ok = ok && close(X, ref, 0.0);
+    }
+    Utils::set_num_threads(threads);
+    ASSERT_EQ(ok, true);
+  }
+
+  return run_test_summary();
+}
@@ -1,5 +1,6 @@
 #include "../src/math/matrix.h"
 #include "../src/nn/cost_func.h"
+#include "../src/utils/thread_pool.h"
 #include "test_utils.h"
 #include <cmath>
 #include <iostream>
@@ -133,5 +134,69 @@ int main() {
     ASSERT_EQ(grad_finite, true);
   }
 
+  // ======================================================================
+  // TEST 4: Mean Absolute Error (MAE)
+  // Fórmula: Mean(|y_pred - y_true|)
+  // Gradiente: sign(y_pred - y_true) / N_elements
+  // ======================================================================
+  TEST_CASE("Mean Absolute Error (MAE)");
+  {
+    // Diferencia: [[-1, 0], [0.5, -2]] -> Suma |d| = 3.5, N = 4
+    Matrix<double> pred({1.0, 2.0, 3.5, 4.0}, {2, 2});
+    Matrix<double> target({2.0, 2.0, 3.0, 6.0}, {2, 2});
+
+    auto mae = std::make_shared<CostFunc::MeanAbsoluteError<double>>();
+    ASSERT_ALMOST_EQ(mae->forward(pred, target), 3.5 / 4.0);
+
+    Matrix<double> grad = mae->backward();
+    const double *pGrad = grad.data_ptr();
+    ASSERT_ALMOST_EQ(pGrad[0], -0.25);
+    ASSERT_ALMOST_EQ(pGrad[1], 0.0);
+    ASSERT_ALMOST_EQ(pGrad[2], 0.25);
+    ASSERT_ALMOST_EQ(pGrad[3], -0.25);
+    ASSERT_THROWS(mae->forward(pred, Matrix<double>({1.0, 2.0}, {1, 2})),
+                  std::invalid_argument);
+  }
+
+  // ======================================================================
+  // TEST 5: Kernels de una pasada sobre varios bloques de la reducción
+  // El resultado no depende del número de hilos
+  // ======================================================================
+  TEST_CASE("MSE / MAE: Single-pass kernels on large inputs");
+  {
+    int rows = 700, cols = 33;
+    AlignedVector<double> p(rows * cols), y(rows * cols);
+    double sq = 0.0, ab = 0.0;
+    for (size_t i = 0; i < p.size(); i++) {
+      p[i] = std::sin(0.37 * i);
+      y[i] = std::cos(0.11 * i);
+      sq += (p[i] - y[i]) * (p[i] - y[i]);
+      ab += std::fabs(p[i] - y[i]);
+    }
+    Matrix<double> pred(AlignedVector<double>(p), {rows, cols});
+    Matrix<double> target(AlignedVector<double>(y), {rows, cols});
+    double n = (double)pred.size();
+
+    CostFunc::MeanSquareError<double> mse;
+    CostFunc::MeanAbsoluteError<double> mae;
+    double lossMse = mse.forward(pred, target);
+    double lossMae = mae.forward(pred, target);
+    ASSERT_ALMOST_EQ(lossMse, sq / n);
+    ASSERT_ALMOST_EQ(lossMae, ab / n);
+
+    Matrix<double> gMse = mse.backward();
+    Matrix<double> gMae = mae.backward();
+    size_t k = 12345;
+    ASSERT_ALMOST_EQ(gMse.data_ptr()[k], 2.0 * (p[k] - y[k]) / n);
+    ASSERT_ALMOST_EQ(gMae.data_ptr()[k] * n, p[k] > y[k] ? 1.0 : -1.0);
+
+    size_t threads = Utils::get_num_threads();
+    Utils::set_num_threads(4);
+    bool same = mse.forward(pred, target) == lossMse &&
+                mae.forward(pred, target) == lossMae;
+    Utils::set_num_threads(threads);
+    ASSERT_EQ(same, true);
+  }
+
   return run_test_summary();
 }
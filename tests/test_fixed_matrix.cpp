@@ -0,0 +1,139 @@
+#include "../src/math/fixed_matrix.h"
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/fixed_dense.h"
+#include "../src/nn/model.h"
+#include "../src/nn/optimizer.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Math;
+
+// ReLU personalizada: FixedAct::ReLU no puede sustituirla
+class CustomReLU : public NN::ActFunc::ReLU<float> {};
+
+int main() {
+  std::cout << "=== TEST SUITE: FIXED MATRIX ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Operaciones y producto frente a Matrix
+  // ---------------------------------------------------------
+  TEST_CASE("Fixed: Element-wise ops and matmul match Matrix");
+  {
+    Matrix<float> a = pattern<float>(3, 40, 1u);
+    Matrix<float> b = pattern<float>(40, 20, 2u);
+    FixedMatrix<float, 3, 40> fa(a);
+    FixedMatrix<float, 40, 20> fb(b);
+    ASSERT_EQ(fa(2, 39), a.data_ptr()[2 * 40 + 39]);
+
+    FixedMatrix<float, 3, 20> fc = Linalg::matmul(fa, fb);
+    Matrix<float> ref = Linalg::matmul(a, b);
+    ASSERT_EQ(close(fc.data(), ref.data_ptr(), ref.size(), 1e-4f), true);
+
+    // Filas de más de Fixed::UNROLL columnas usan el bucle
+    FixedMatrix<float, 20, 40> ft = Linalg::transpose(fb);
+    FixedMatrix<float, 3, 40> wide = Linalg::matmul(fc, ft);
+    Matrix<float> refWide = Linalg::matmul(ref, Linalg::transpose(b));
+    ASSERT_EQ(close(wide.data(), refWide.data_ptr(), refWide.size(), 1e-3f),
+              true);
+
+    FixedMatrix<float, 1, 3> x = {1.0f, 2.0f, 3.0f};
+    FixedMatrix<float, 1, 3> y = {0.5f, 0.5f, 2.0f};
+    FixedMatrix<float, 1, 3> z = (x + y) * 2.0f - x * y;
+    ASSERT_ALMOST_EQ(z(0, 0), 2.5f);
+    ASSERT_ALMOST_EQ(z(0, 2), 4.0f);
+    ASSERT_EQ(z.view().cols(), 3);
+    ASSERT_EQ(z.to_matrix().shape()[1], 3);
+
+    ASSERT_THROWS((FixedMatrix<float, 2, 3>(a)), std::invalid_argument);
+    ASSERT_THROWS((FixedMatrix<float, 1, 2>{1.0f, 2.0f, 3.0f}),
+                  std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Red fija frente al modelo entrenado (64-20-10-10)
+  // ---------------------------------------------------------
+  TEST_CASE("Fixed: FixedNetwork reproduces Model::predict");
+  {
+    auto seq = std::make_shared<NN::Layer::Sequential<float>>();
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        20, std::make_shared<NN::ActFunc::ReLU<float>>()));
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        10, std::make_shared<NN::ActFunc::Tanh<float>>()));
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        10, std::make_shared<NN::ActFunc::Softmax<float>>()));
+
+    NN::Model<float> model;
+    model.set_layers(seq);
+    model.compile(
+        std::make_shared<NN::CostFunc::CategoricalCrossEntropy<float>>(),
+        std::make_shared<NN::Optimizer::Adam<float>>(0.01f));
+
+    Matrix<float> X = pattern<float>(64, 64, 3u);
+    AlignedVector<float> y(64 * 10, 0.0f);
+    for (int i = 0; i < 64; i++) {
+      y[i * 10 + i % 10] = 1.0f;
+    }
+    Matrix<float> Y(std::move(y), {64, 10});
+    for (int i = 0; i < 20; i++) {
+      model.train_step(X, Y);
+    }
+
+    using Net = NN::FixedNetwork<
+        float, NN::Layer::FixedDense<float, 64, 20, NN::FixedAct::ReLU>,
+        NN::Layer::FixedDense<float, 20, 10, NN::FixedAct::Tanh>,
+        NN::Layer::FixedDense<float, 10, 10, NN::FixedAct::Softmax>>;
+    Net net(model.get_layers());
+
+    Matrix<float> ref = model.predict(X);
+    Matrix<float> out = net.predict(X);
+    ASSERT_EQ(out.shape()[0], 64);
+    ASSERT_EQ(close(out.data_ptr(), ref.data_ptr(), ref.size(), 1e-5f), true);
+
+    FixedMatrix<float, 1, 64> sample(X.viewRow(5));
+    FixedMatrix<float, 1, 10> probs = net.predict(sample);
+    ASSERT_EQ(close(probs.data(), ref.data_ptr() + 50, 10, 1e-5f), true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Errores al copiar capas entrenadas
+  // ---------------------------------------------------------
+  TEST_CASE("Fixed: Mismatched shapes, activations and unbuilt layers throw");
+  {
+    auto seq = std::make_shared<NN::Layer::Sequential<float>>();
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        4, std::make_shared<NN::ActFunc::ReLU<float>>()));
+    NN::Model<float> model;
+    model.set_layers(seq);
+
+    using Relu = NN::Layer::FixedDense<float, 3, 4, NN::FixedAct::ReLU>;
+    ASSERT_THROWS(Relu(*model.get_layers()[0]), std::runtime_error);
+
+    model.predict(pattern<float>(2, 3, 4u));
+    Relu ok(*model.get_layers()[0]);
+    ASSERT_EQ(ok.weights()(2, 3),
+              model.get_layers()[0]->params()[0]->data_ptr()[11]);
+
+    using Sig = NN::Layer::FixedDense<float, 3, 4, NN::FixedAct::Sigmoid>;
+    using Wide = NN::Layer::FixedDense<float, 5, 4, NN::FixedAct::ReLU>;
+    ASSERT_THROWS(Sig(*model.get_layers()[0]), std::invalid_argument);
+    ASSERT_THROWS(Wide(*model.get_layers()[0]), std::invalid_argument);
+    using Head = NN::Layer::FixedDense<float, 4, 2>;
+    ASSERT_THROWS((NN::FixedNetwork<float, Relu, Head>(model.get_layers())),
+                  std::invalid_argument);
+
+    auto custom = std::make_shared<NN::Layer::Sequential<float>>();
+    custom->add(std::make_shared<NN::Layer::Dense<float>>(
+        4, std::make_shared<CustomReLU>()));
+    NN::Model<float> customModel;
+    customModel.set_layers(custom);
+    customModel.predict(pattern<float>(2, 3, 4u));
+    ASSERT_THROWS(Relu(*customModel.get_layers()[0]), std::invalid_argument);
+  }
+
+  return run_test_summary();
+}
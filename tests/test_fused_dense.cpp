@@ -0,0 +1,156 @@
+#include "../src/math/gemm.h"
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/fused_dense.h"
+#include "../src/nn/layers.h"
+#include "../src/utils/thread_pool.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Math;
+
+// Misma activación, pero al ser una clase derivada la capa usa la cadena de
+// operaciones (WeightMultiply, AddBias, activación)
+template <typename Act> class Unfused : public Act {};
+
+static float leaky(float x) { return x > 0.0f ? x : 0.1f * x; }
+
+// ReLU con fuga: solo cambia _compute_output, Dense debe respetarlo
+class LeakyReLU : public NN::ActFunc::ReLU<float> {
+public:
+  Matrix<float> _compute_output() override {
+    return Func::apply<float>(*this->input_, leaky);
+  }
+};
+
+// Capa fusionada frente a la cadena de operaciones con los mismos pesos
+template <typename Act>
+static bool compare_layer(int batch, int n_in, int n_out, float tol,
+                          StorageFormat format = StorageFormat::FP32) {
+  NN::Layer::Dense<float> fused(n_out, std::make_shared<Act>());
+  NN::Layer::Dense<float> chain(n_out, std::make_shared<Unfused<Act>>());
+  fused.set_cache_format(format);
+  chain.set_cache_format(format);
+
+  Matrix<float> X = pattern<float>(batch, n_in, 7u);
+  Matrix<float> dY = pattern<float>(batch, n_out, 8u);
+  fused.forward(X);
+  chain.forward(X);
+  *fused.params()[0] = *chain.params()[0];
+  *fused.params()[1] = pattern<float>(1, n_out, 9u);
+  *chain.params()[1] = *fused.params()[1];
+
+  bool ok = true;
+  for (int step = 0; step < 2; step++) {
+    Matrix<float> yF = fused.forward(X);
+    Matrix<float> yC = chain.forward(X);
+    Matrix<float> dxF = fused.backward(dY);
+    Matrix<float> dxC = chain.backward(dY);
+    ok = ok && close(yF, yC, tol) && close(dxF, dxC, tol) &&
+         close(*fused.param_grads()[0], *chain.param_grads()[0], tol) &&
+         close(*fused.param_grads()[1], *chain.param_grads()[1], tol);
+  }
+  return ok;
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: FUSED DENSE ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Epílogo de la GEMM (varios bloques de K y de filas)
+  // ---------------------------------------------------------
+  TEST_CASE("Fused: GEMM epilogue sees every element of C once");
+  {
+    for (int K : {5, 300, 600}) {
+      Matrix<float> A = pattern<float>(200, K, 1u);
+      Matrix<float> B = pattern<float>(K, 70, 2u);
+      Matrix<float> bias = pattern<float>(1, 70, 3u);
+      Matrix<float> ref = Linalg::matmul(A, B);
+
+      Matrix<float> C(AlignedVector<float>(200 * 70, 0.0f), {200, 70});
+      const float *pb = bias.data_ptr();
+      Gemm::gemm(Gemm::Trans::No, Gemm::Trans::No, 200, 70, K, 1.0f,
+                 A.data_ptr(), K, B.data_ptr(), 70, 0.0f, C.data_ptr(), 70,
+                 [pb](float *y, int col, int n) {
+                   for (int j = 0; j < n; j++) {
+                     y[j] = 2.0f * y[j] + pb[col + j];
+                   }
+                 });
+      Matrix<float> expected = ref * 2.0f + bias;
+      ASSERT_EQ(close(C, expected, 1e-4f), true);
+    }
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Forward y backward frente a la cadena de operaciones
+  // ---------------------------------------------------------
+  TEST_CASE("Fused: Dense matches the operation chain for every activation");
+  {
+    ASSERT_EQ(compare_layer<NN::ActFunc::ReLU<float>>(64, 33, 40, 1e-4f), true);
+    ASSERT_EQ(compare_layer<NN::ActFunc::Sigmoid<float>>(64, 33, 40, 1e-4f),
+              true);
+    ASSERT_EQ(compare_layer<NN::ActFunc::Tanh<float>>(3, 300, 17, 1e-4f), true);
+    ASSERT_EQ(compare_layer<NN::ActFunc::Softmax<float>>(50, 20, 10, 1e-4f),
+              true);
+    ASSERT_EQ(compare_layer<NN::ActFunc::Linear<float>>(1, 8, 1, 1e-4f), true);
+
+    // Backward recorre el lote en bloques de filas
+    ASSERT_EQ(compare_layer<NN::ActFunc::ReLU<float>>(600, 40, 70, 1e-4f), true);
+    ASSERT_EQ(compare_layer<NN::ActFunc::Softmax<float>>(600, 12, 300, 1e-4f),
+              true);
+
+    size_t threads = Utils::get_num_threads();
+    Utils::set_num_threads(4);
+    bool threaded =
+        compare_layer<NN::ActFunc::Softmax<float>>(520, 64, 500, 1e-4f) &&
+        compare_layer<NN::ActFunc::Sigmoid<float>>(300, 500, 64, 1e-4f);
+    Utils::set_num_threads(threads);
+    ASSERT_EQ(threaded, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Cachés de 16 bits y activaciones propias
+  // ---------------------------------------------------------
+  TEST_CASE("Fused: 16-bit caches and non-fusable activations");
+  {
+    ASSERT_EQ(compare_layer<NN::ActFunc::Tanh<float>>(32, 16, 24, 1e-4f,
+                                                      StorageFormat::BF16),
+              true);
+
+    NN::Layer::Dense<float> custom(
+        4, std::make_shared<Unfused<NN::ActFunc::ReLU<float>>>());
+    Matrix<float> y = custom.forward(pattern<float>(2, 3, 4u));
+    ASSERT_EQ(y.shape()[1], 4);
+    ASSERT_EQ(custom.backward(pattern<float>(2, 4, 5u)).shape()[1], 3);
+
+    // Una clase derivada de una activación integrada usa su propio forward
+    NN::Layer::Dense<float> derived(8, std::make_shared<LeakyReLU>());
+    Matrix<float> XL = pattern<float>(16, 5, 6u);
+    Matrix<float> yL = derived.forward(XL);
+    Matrix<float> zL =
+        Linalg::matmul(XL, *derived.params()[0]) + *derived.params()[1];
+    bool negatives = false;
+    for (size_t i = 0; i < zL.size(); i++) {
+      negatives = negatives || zL.data()[i] < 0.0f;
+    }
+    ASSERT_EQ(negatives, true);
+    ASSERT_EQ(close(yL, Func::apply<float>(zL, leaky), 1e-5f), true);
+
+    Matrix<float> W = pattern<float>(3, 4, 6u);
+    Matrix<float> out;
+    ASSERT_THROWS(NN::Fused::dense_forward<float>(pattern<float>(2, 5, 1u), W,
+                                                  pattern<float>(1, 4, 2u),
+                                                  NN::Ops::Fusable::ReLU, out),
+                  std::invalid_argument);
+    ASSERT_THROWS(NN::Fused::dense_forward<float>(pattern<float>(2, 3, 1u), W,
+                                                  pattern<float>(1, 4, 2u),
+                                                  NN::Ops::Fusable::None, out),
+                  std::invalid_argument);
+  }
+
+  return run_test_summary();
+}
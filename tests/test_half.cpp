@@ -0,0 +1,258 @@
+#include "../src/math/half.h"
+#include "../src/math/matrix.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/model.h"
+#include "../src/nn/optimizer.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+using namespace Math;
+
+// Red 2 -> 16 -> 1 sobre y = x0 - 2 * x1, opcionalmente en precisión mixta
+static float train_regression(StorageFormat format, int steps,
+                              std::shared_ptr<NN::Model<float>> &model) {
+  const int n = 64;
+  AlignedVector<float> x(n * 2), y(n);
+  for (int i = 0; i < n; i++) {
+    x[2 * i] = (float)(i % 8) / 8.0f;
+    x[2 * i + 1] = (float)(i / 8) / 8.0f;
+    y[i] = x[2 * i] - 2.0f * x[2 * i + 1];
+  }
+  Matrix<float> X(x, {n, 2});
+  Matrix<float> Y(y, {n, 1});
+
+  auto seq = std::make_shared<NN::Layer::Sequential<float>>();
+  seq->add(std::make_shared<NN::Layer::Dense<float>>(
+      16, std::make_shared<NN::ActFunc::Tanh<float>>()));
+  seq->add(std::make_shared<NN::Layer::Dense<float>>(
+      1, std::make_shared<NN::ActFunc::Linear<float>>()));
+
+  std::shared_ptr<NN::Optimizer::Optimizer<float>> opt =
+      std::make_shared<NN::Optimizer::Adam<float>>(0.01f);
+  if (format != StorageFormat::FP32) {
+    opt = std::make_shared<NN::Optimizer::MixedPrecision<float>>(opt, format);
+  }
+
+  model = std::make_shared<NN::Model<float>>();
+  model->set_layers(seq);
+  model->set_cache_format(format);
+  model->compile(std::make_shared<NN::CostFunc::MeanSquareError<float>>(),
+                 opt);
+
+  float loss = 0;
+  for (int i = 0; i < steps; i++) {
+    loss = model->train_step(X, Y);
+  }
+  return loss;
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: HALF PRECISION STORAGE ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Conversiones escalares (redondeo, rango, especiales)
+  // ---------------------------------------------------------
+  TEST_CASE("Half: bf16 and fp16 scalar conversions");
+  {
+    const float inf = std::numeric_limits<float>::infinity();
+
+    ASSERT_EQ(Half::bf16_from_float(1.0f), (uint16_t)0x3F80);
+    ASSERT_EQ(Half::fp16_from_float(1.0f), (uint16_t)0x3C00);
+    ASSERT_EQ(Half::fp16_from_float(-2.0f), (uint16_t)0xC000);
+    ASSERT_EQ(Half::fp16_from_float(65504.0f), (uint16_t)0x7BFF);
+    ASSERT_EQ(Half::fp16_from_float(65520.0f), (uint16_t)0x7C00); // overflow
+    ASSERT_EQ(Half::fp16_from_float(-inf), (uint16_t)0xFC00);
+    ASSERT_EQ(Half::fp16_from_float(std::ldexp(1.0f, -24)), (uint16_t)0x0001);
+    ASSERT_EQ(Half::fp16_from_float(-0.0f), (uint16_t)0x8000);
+
+    // Empates al par más cercano
+    ASSERT_EQ(Half::fp16_from_float(1.0f + std::ldexp(1.0f, -11)),
+              (uint16_t)0x3C00);
+    ASSERT_EQ(Half::fp16_from_float(1.0f + 3 * std::ldexp(1.0f, -11)),
+              (uint16_t)0x3C02);
+    ASSERT_EQ(Half::bf16_from_float(1.0f + std::ldexp(1.0f, -8)),
+              (uint16_t)0x3F80);
+    ASSERT_EQ(Half::bf16_from_float(1.0f + 3 * std::ldexp(1.0f, -8)),
+              (uint16_t)0x3F82);
+
+    ASSERT_EQ(std::isnan(Half::fp16_to_float(Half::fp16_from_float(NAN))),
+              true);
+    ASSERT_EQ(std::isnan(Half::bf16_to_float(Half::bf16_from_float(NAN))),
+              true);
+    ASSERT_EQ(Half::bf16_to_float(Half::bf16_from_float(1e38f)) > 9e37f, true);
+    ASSERT_EQ(Half::fp16_to_float(0x0001), std::ldexp(1.0f, -24));
+    ASSERT_EQ(Half::round(StorageFormat::BF16, 3.14159), 3.140625);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Los kernels de array coinciden con la versión escalar
+  // ---------------------------------------------------------
+  TEST_CASE("Half: Array conversions match the scalar ones");
+  {
+    // Todos los valores fp16 / bf16 ida y vuelta
+    std::vector<uint16_t> all(65536), back(65536);
+    std::vector<float> wide(65536);
+    for (size_t i = 0; i < all.size(); i++) {
+      all[i] = (uint16_t)i;
+    }
+
+    bool ok = true;
+    for (StorageFormat f : {StorageFormat::FP16, StorageFormat::BF16}) {
+      Half::widen(f, all.data(), wide.data(), all.size());
+      Half::narrow(f, wide.data(), back.data(), all.size());
+      for (size_t i = 0; i < all.size(); i++) {
+        float s = Half::to_float(f, all[i]);
+        if (std::isnan(s)) {
+          ok = ok && std::isnan(wide[i]);
+        } else {
+          ok = ok && s == wide[i] && back[i] == all[i];
+        }
+      }
+    }
+    ASSERT_EQ(ok, true);
+
+    // Valores arbitrarios, con cola
+    std::vector<float> src(1003);
+    for (size_t i = 0; i < src.size(); i++) {
+      float mantissa = (float)(i * 7919 % 1000) - 500.0f;
+      src[i] = std::ldexp(mantissa, (int)(i % 40) - 30);
+    }
+    std::vector<uint16_t> packed(src.size());
+    Half::narrow(StorageFormat::FP16, src.data(), packed.data(), src.size());
+    for (size_t i = 0; i < src.size(); i++) {
+      ok = ok && packed[i] == Half::fp16_from_float(src[i]);
+    }
+    ASSERT_EQ(ok, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: HalfMatrix guarda la mitad de bytes
+  // ---------------------------------------------------------
+  TEST_CASE("Half: HalfMatrix round trip");
+  {
+    Matrix<double> A({0.5, -1.25, 3.0, 1000.0, 1e-3, -7.75}, {2, 3});
+    HalfMatrix<double> packed;
+    ASSERT_EQ(packed.empty(), true);
+    ASSERT_THROWS(packed.store(A, StorageFormat::FP32), std::invalid_argument);
+
+    packed.store(A, StorageFormat::FP16);
+    ASSERT_EQ(packed.bytes(), (size_t)12);
+    ASSERT_EQ(packed.shape()[1], 3);
+
+    Matrix<double> B = packed.load();
+    for (size_t i = 0; i < A.size(); i++) {
+      // fp16: 11 bits de mantisa, error relativo <= 2^-11
+      ASSERT_EQ(std::fabs(B.data_ptr()[i] / A.data_ptr()[i] - 1.0) < 4.9e-4,
+                true);
+      ASSERT_EQ(B.data_ptr()[i],
+                Half::round(StorageFormat::FP16, A.data_ptr()[i]));
+    }
+
+    Matrix<double> C({0, 0, 0, 0, 0, 0}, {2, 3});
+    Half::round_into(StorageFormat::BF16, A, C);
+    ASSERT_EQ(C.data_ptr()[3], 1000.0);
+    ASSERT_EQ(C.data_ptr()[4], Half::round(StorageFormat::BF16, 1e-3));
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Entrenamiento en precisión mixta
+  // ---------------------------------------------------------
+  TEST_CASE("Half: Mixed precision training converges like fp32");
+  {
+    std::shared_ptr<NN::Model<float>> m32, m16, mbf;
+    float l32 = train_regression(StorageFormat::FP32, 400, m32);
+    float l16 = train_regression(StorageFormat::FP16, 400, m16);
+    float lbf = train_regression(StorageFormat::BF16, 400, mbf);
+
+    std::cout << "   loss fp32 " << l32 << " | fp16 " << l16 << " | bf16 "
+              << lbf << std::endl;
+    ASSERT_EQ(l32 < 0.01f, true);
+    ASSERT_EQ(l16 < 0.02f, true);
+    ASSERT_EQ(lbf < 0.02f, true);
+
+    // Los pesos del modelo son exactamente representables en 16 bits
+    bool rounded = true;
+    for (const auto &p : mbf->get_parameters()) {
+      for (size_t i = 0; i < p->size(); i++) {
+        float w = p->data_ptr()[i];
+        rounded = rounded && Half::round(StorageFormat::BF16, w) == w;
+      }
+    }
+    ASSERT_EQ(rounded, true);
+
+    // predict y summary siguen funcionando con las cachés empaquetadas
+    Matrix<float> x({0.5f, 0.25f}, {1, 2});
+    ASSERT_EQ(std::fabs(m16->predict(x).data()[0]) < 0.2f, true);
+    ASSERT_EQ(m16->get_layers()[0]->get_output_shape_str(),
+              std::string("(1, 16)"));
+  }
+
+  // ---------------------------------------------------------
+  // CASO 5: Detección de desbordamiento y escalado opcional de la pérdida
+  // ---------------------------------------------------------
+  TEST_CASE("Half: Overflowing gradients skip the step, scaling is opt-in");
+  {
+    auto W = std::make_shared<Matrix<float>>(
+        Matrix<float>({1.0f, 2.0f}, {1, 2}));
+    auto dW = std::make_shared<Matrix<float>>(
+        Matrix<float>({0.0f, 0.0f}, {1, 2}));
+    const float inf = std::numeric_limits<float>::infinity();
+
+    // Por defecto no hay escalado (los gradientes están en T), pero los
+    // pasos con inf/NaN se saltan igualmente
+    NN::Optimizer::MixedPrecision<float> plain(
+        std::make_shared<NN::Optimizer::SGD<float>>(0.5f), StorageFormat::FP16,
+        1.0f, 2);
+    ASSERT_EQ(plain.loss_scale(), 1.0f);
+    plain.setup({W}, {dW});
+    *dW = Matrix<float>({1.0f, 1.0f}, {1, 2});
+    plain.step();
+    ASSERT_EQ(W->data_ptr()[0], 0.5f);
+    *dW = Matrix<float>({inf, 1.0f}, {1, 2});
+    plain.step();
+    ASSERT_EQ(plain.skipped_steps(), 1);
+    ASSERT_EQ(W->data_ptr()[0], 0.5f);
+    for (int i = 0; i < 4; i++) {
+      *dW = Matrix<float>({0.0f, 0.0f}, {1, 2});
+      plain.step();
+    }
+    ASSERT_EQ(plain.loss_scale(), 1.0f);
+    ASSERT_THROWS(NN::Optimizer::MixedPrecision<float>(
+                      std::make_shared<NN::Optimizer::SGD<float>>(0.5f),
+                      StorageFormat::FP16, 0.5f),
+                  std::invalid_argument);
+
+    // Escala explícita: escalado dinámico
+    *W = Matrix<float>({1.0f, 2.0f}, {1, 2});
+    NN::Optimizer::MixedPrecision<float> opt(
+        std::make_shared<NN::Optimizer::SGD<float>>(0.5f), StorageFormat::FP16,
+        32768.0f, 2);
+    ASSERT_EQ(opt.loss_scale(), 32768.0f);
+    opt.setup({W}, {dW});
+
+    // Gradiente escalado: tras desescalar vale 1 -> W -= 0.5
+    *dW = Matrix<float>({32768.0f, 32768.0f}, {1, 2});
+    opt.step();
+    ASSERT_EQ(W->data_ptr()[0], 0.5f);
+    ASSERT_EQ(opt.master_params()[0]->data_ptr()[1], 1.5f);
+
+    *dW = Matrix<float>({inf, 1.0f}, {1, 2});
+    opt.step();
+    ASSERT_EQ(opt.skipped_steps(), 1);
+    ASSERT_EQ(opt.loss_scale(), 16384.0f);
+    ASSERT_EQ(W->data_ptr()[0], 0.5f);
+
+    // Dos pasos limpios: la escala vuelve a crecer
+    for (int i = 0; i < 2; i++) {
+      *dW = Matrix<float>({0.0f, 0.0f}, {1, 2});
+      opt.step();
+    }
+    ASSERT_EQ(opt.loss_scale(), 32768.0f);
+  }
+
+  return run_test_summary();
+}
@@ -1,6 +1,7 @@
 #include "../src/math/matrix.h"
 #include "../src/math/matrix_linalg.h"
 #include "test_utils.h"
+#include <cstdint>
 #include <iostream>
 
 int main() {
@@ -82,6 +83,102 @@ int main() {
   ASSERT_EQ(scalarRes.shape()[1], 1);
   ASSERT_EQ(scalarRes.data_ptr()[0], 32);
 
+  // ---------------------------------------------------------
+  // CASO 5: GEMM por bloques contra la referencia ingenua
+  // Dimensiones que no son múltiplo de MR/NR/KC para forzar los bordes
+  // del empaquetado y varios bloques de K (300 > KC).
+  // ---------------------------------------------------------
+  TEST_CASE("Matmul: Blocked GEMM vs Naive Reference (130x300 * 300x70)");
+
+  {
+    int M = 130, K = 300, N = 70;
+    std::vector<double> dataA((size_t)M * K), dataB((size_t)K * N);
+    for (size_t i = 0; i < dataA.size(); i++)
+      dataA[i] = (double)((int)(i * 7 % 13) - 6);
+    for (size_t i = 0; i < dataB.size(); i++)
+      dataB[i] = (double)((int)(i * 5 % 11) - 5);
+
+    Math::Matrix<double> bigA(dataA, {M, K});
+    Math::Matrix<double> bigB(dataB, {K, N});
+    Math::Matrix<double> bigC = Math::Linalg::matmul(bigA, bigB);
+
+    ASSERT_EQ(bigC.shape()[0], M);
+    ASSERT_EQ(bigC.shape()[1], N);
+
+    int mismatches = 0;
+    for (int i = 0; i < M; i++) {
+      for (int j = 0; j < N; j++) {
+        double ref = 0;
+        for (int k = 0; k < K; k++)
+          ref += dataA[(size_t)i * K + k] * dataB[(size_t)k * N + j];
+        if (bigC.data_ptr()[(size_t)i * N + j] != ref)
+          mismatches++;
+      }
+    }
+    ASSERT_EQ(mismatches, 0);
+  }
+
+  TEST_CASE("Gemm: alpha/beta accumulation into C");
+
+  {
+    // C = 2 * A * B + 1 * C
+    float gA[] = {1, 2, 3, 4, 5, 6};    // 2x3
+    float gB[] = {7, 8, 9, 1, 2, 3};    // 3x2
+    float gC[] = {1, 1, 1, 1};          // 2x2
+    Math::Gemm::gemm(2, 2, 3, 2.0f, gA, 3, gB, 2, 1.0f, gC, 2);
+
+    ASSERT_ALMOST_EQ(gC[0], 63.0f);
+    ASSERT_ALMOST_EQ(gC[1], 39.0f);
+    ASSERT_ALMOST_EQ(gC[2], 171.0f);
+    ASSERT_ALMOST_EQ(gC[3], 111.0f);
+  }
+
+  TEST_CASE("Matmul: Transpose-free variants (A^T * B and A * B^T)");
+
+  {
+    // Sizes large enough to go through the packed path
+    int M = 45, K = 70, N = 33;
+    std::vector<float> dataA((size_t)K * M), dataB((size_t)K * N);
+    for (size_t i = 0; i < dataA.size(); i++)
+      dataA[i] = (float)((int)(i * 3 % 7) - 3);
+    for (size_t i = 0; i < dataB.size(); i++)
+      dataB[i] = (float)((int)(i * 5 % 9) - 4);
+
+    Math::Matrix<float> tA(dataA, {K, M});
+    Math::Matrix<float> tB(dataB, {K, N});
+
+    Math::Matrix<float> tn = Math::Linalg::matmul_tn(tA, tB);
+    Math::Matrix<float> tnRef =
+        Math::Linalg::matmul(Math::Linalg::transpose(tA), tB);
+
+    ASSERT_EQ(tn.shape()[0], M);
+    ASSERT_EQ(tn.shape()[1], N);
+    for (size_t i = 0; i < tn.size(); i++)
+      ASSERT_ALMOST_EQ(tn.data_ptr()[i], tnRef.data_ptr()[i]);
+
+    Math::Matrix<float> tAt = Math::Linalg::transpose(tA); // (M x K)
+    Math::Matrix<float> tBt = Math::Linalg::transpose(tB); // (N x K)
+
+    Math::Matrix<float> nt = Math::Linalg::matmul_nt(tAt, tBt);
+
+    ASSERT_EQ(nt.shape()[0], M);
+    ASSERT_EQ(nt.shape()[1], N);
+    for (size_t i = 0; i < nt.size(); i++)
+      ASSERT_ALMOST_EQ(nt.data_ptr()[i], tnRef.data_ptr()[i]);
+
+    // Small path: (2x3)^T * (2x2)
+    Math::Matrix<int> sA({1, 2, 3, 4, 5, 6}, {2, 3});
+    Math::Matrix<int> sB({1, 0, 0, 1}, {2, 2});
+    Math::Matrix<int> sC = Math::Linalg::matmul_tn(sA, sB);
+    ASSERT_EQ(sC.shape()[0], 3);
+    ASSERT_EQ(sC.data_ptr()[0], 1);
+    ASSERT_EQ(sC.data_ptr()[1], 4);
+    ASSERT_EQ(sC.data_ptr()[4], 3);
+    ASSERT_EQ(sC.data_ptr()[5], 6);
+
+    ASSERT_THROWS(Math::Linalg::matmul_nt(sA, sB), std::invalid_argument);
+  }
+
   TEST_CASE("Transpose: Square Math::Matrix (2x2)");
 
   Math::Matrix<int> square({1, 2, 3, 4}, {2, 2});
@@ -256,5 +353,80 @@ int main() {
   // Debería lanzar excepción sin importar qué lógica uses
   ASSERT_THROWS(matErr + vecErr, std::invalid_argument);
 
+  // ---------------------------------------------------------
+  // ESCENARIO 4: API con destino (out) y axpy
+  // El buffer de salida se reutiliza si la forma no cambia
+  // ---------------------------------------------------------
+  TEST_CASE("Linalg: Destination-passing overloads and axpy");
+  {
+    Math::Matrix<double> a({1.0, 2.0, 3.0, 4.0, 5.0, 6.0}, {2, 3});
+    Math::Matrix<double> b({1.0, 0.0, 0.0, 1.0, 1.0, 1.0}, {3, 2});
+
+    Math::Matrix<double> out;
+    Math::Linalg::matmul(a, b, out);
+    const double *buffer = out.data_ptr();
+
+    ASSERT_EQ(out.shape()[0], 2);
+    ASSERT_EQ(out.shape()[1], 2);
+    ASSERT_ALMOST_EQ(out.data_ptr()[0], 4.0);
+    ASSERT_ALMOST_EQ(out.data_ptr()[3], 11.0);
+
+    // Segunda llamada con la misma forma: sin realocar
+    Math::Linalg::matmul_tn(b, b, out);
+    ASSERT_EQ(out.data_ptr() == buffer, true);
+    ASSERT_ALMOST_EQ(out.data_ptr()[0], 2.0);
+    ASSERT_ALMOST_EQ(out.data_ptr()[1], 1.0);
+
+    Math::Linalg::sum(a, 0, out);
+    ASSERT_EQ(out.shape()[0], 1);
+    ASSERT_ALMOST_EQ(out.data_ptr()[2], 9.0);
+
+    // y = alpha * x + y
+    Math::Matrix<double> y({1.0, 1.0, 1.0, 1.0, 1.0, 1.0}, {2, 3});
+    Math::Linalg::axpy(-0.5, a, y);
+    ASSERT_ALMOST_EQ(y.data_ptr()[0], 0.5);
+    ASSERT_ALMOST_EQ(y.data_ptr()[5], -2.0);
+
+    // Matrices grandes: bloque contiguo y columna con stride en paralelo
+    Math::Matrix<double> big = pattern(50000, 4, 3u);
+    Math::Matrix<double> acc = pattern(50000, 4, 4u);
+    Math::Matrix<double> ref = acc + 2.0 * big;
+    Math::Linalg::axpy(2.0, big, acc);
+    ASSERT_EQ(close(acc, ref, 1e-12), true);
+
+    Math::Matrix<double> col = pattern(50000, 1, 5u);
+    Math::Matrix<double> colRef =
+        col + 3.0 * Math::Matrix<double>(big.viewCol(2));
+    Math::Linalg::axpy(3.0, big.viewCol(2), col);
+    ASSERT_EQ(close(col, colRef, 1e-12), true);
+
+    ASSERT_THROWS(Math::Linalg::axpy(1.0, b, y), std::invalid_argument);
+    ASSERT_THROWS(Math::Linalg::matmul(a, b, a), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // ESCENARIO 5: Almacenamiento alineado y forma inline
+  // ---------------------------------------------------------
+  TEST_CASE("Matrix: 64-byte aligned storage and inline shape");
+  {
+    Math::Matrix<float> small({1.0f, 2.0f, 3.0f}, {1, 3});
+    Math::Matrix<double> prod =
+        Math::Linalg::matmul(Math::Linalg::ones<double>({5, 7}),
+                             Math::Linalg::ones<double>({7, 3}));
+
+    ASSERT_EQ((uintptr_t)small.data_ptr() % 64, (uintptr_t)0);
+    ASSERT_EQ((uintptr_t)prod.data_ptr() % 64, (uintptr_t)0);
+    ASSERT_EQ((uintptr_t)prod.atRow(1).data_ptr() % 64, (uintptr_t)0);
+
+    ASSERT_EQ(prod.shape().size(), (size_t)2);
+    ASSERT_EQ(prod.shape() == Math::Shape(5, 3), true);
+    ASSERT_ALMOST_EQ(prod.data_ptr()[14], 7.0);
+
+    // Formas de otro rango siguen siendo rechazadas
+    ASSERT_THROWS(Math::Matrix<int>(std::vector<int>{1, 2}, std::vector<int>{2}),
+                  std::invalid_argument);
+    ASSERT_THROWS(prod.reshape({15}), std::invalid_argument);
+  }
+
   return run_test_summary();
 }
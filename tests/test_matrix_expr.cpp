@@ -0,0 +1,144 @@
+#include "../src/math/functions.h"
+#include "../src/math/matrix.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace Math;
+
+// Devuelve una matriz temporal (rvalue) para probar la captura por valor
+static Matrix<double> make_row() { return Matrix<double>({1.0, 2.0}, {1, 2}); }
+
+int main() {
+  std::cout << "=== TEST SUITE: EXPRESSION TEMPLATES ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Cadena fusionada (patrón del paso de Adam)
+  // m = 0.9 * m + 0.1 * dW
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Fused chain evaluated on assignment");
+  {
+    Matrix<double> m({1.0, 2.0, 3.0, 4.0}, {2, 2});
+    Matrix<double> dW({10.0, 20.0, 30.0, 40.0}, {2, 2});
+
+    m = (m * 0.9) + (dW * (1.0 - 0.9));
+
+    ASSERT_ALMOST_EQ(m.data_ptr()[0], 1.9);
+    ASSERT_ALMOST_EQ(m.data_ptr()[1], 3.8);
+    ASSERT_ALMOST_EQ(m.data_ptr()[2], 5.7);
+    ASSERT_ALMOST_EQ(m.data_ptr()[3], 7.6);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Escalar a la izquierda no conmutativo
+  // 1 - m  y  1 / m
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Scalar on the left (1 - m, 1 / m)");
+  {
+    Matrix<double> m({0.25, 0.5}, {1, 2});
+
+    Matrix<double> oneMinus = 1.0 - m;
+    ASSERT_ALMOST_EQ(oneMinus.data_ptr()[0], 0.75);
+    ASSERT_ALMOST_EQ(oneMinus.data_ptr()[1], 0.5);
+
+    Matrix<double> inv = 1.0 / m;
+    ASSERT_ALMOST_EQ(inv.data_ptr()[0], 4.0);
+    ASSERT_ALMOST_EQ(inv.data_ptr()[1], 2.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Funciones perezosas (sigmoid = 1 / (1 + exp(-x)))
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Lazy Func::sigmoid");
+  {
+    Matrix<double> x({-1.0, 0.0, 2.0}, {1, 3});
+    Matrix<double> s = Func::sigmoid(x);
+
+    for (size_t i = 0; i < x.size(); i++) {
+      ASSERT_ALMOST_EQ(s.data_ptr()[i], 1.0 / (1.0 + std::exp(-x.data_ptr()[i])));
+    }
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Broadcasting de fila (bias) dentro de una expresión
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Row broadcast inside a chain");
+  {
+    Matrix<int> mat({10, 10, 10, 20, 20, 20}, {2, 3});
+    Matrix<int> bias({1, 2, 3}, {1, 3});
+
+    Matrix<int> res = (mat + bias) * 2;
+
+    ASSERT_EQ(res.shape()[0], 2);
+    ASSERT_EQ(res.shape()[1], 3);
+    ASSERT_EQ(res.data_ptr()[0], 22);
+    ASSERT_EQ(res.data_ptr()[2], 26);
+    ASSERT_EQ(res.data_ptr()[5], 46);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 5: Temporales capturados por valor (sin referencias colgantes)
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Rvalue operands are owned by the expression");
+  {
+    auto lazy = make_row() * 3.0;
+    Matrix<double> res = lazy;
+
+    ASSERT_ALMOST_EQ(res.data_ptr()[0], 3.0);
+    ASSERT_ALMOST_EQ(res.data_ptr()[1], 6.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 6: Asignación que cambia de forma (1 x N -> M x N)
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Assignment resizes when the shape changes");
+  {
+    Matrix<double> b({1.0, 2.0}, {1, 2});
+    Matrix<double> big({1.0, 1.0, 1.0, 1.0, 1.0, 1.0}, {3, 2});
+
+    b = b + big;
+
+    ASSERT_EQ(b.shape()[0], 3);
+    ASSERT_ALMOST_EQ(b.data_ptr()[0], 2.0);
+    ASSERT_ALMOST_EQ(b.data_ptr()[5], 3.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 7: Errores al construir la expresión
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Shape mismatch and zero division throw eagerly");
+  {
+    Matrix<double> a({1.0, 2.0, 3.0, 4.0}, {2, 2});
+    Matrix<double> c({1.0, 2.0, 3.0}, {1, 3});
+    Matrix<double> z({1.0, 0.0, 3.0, 4.0}, {2, 2});
+
+    ASSERT_THROWS(a - c, std::invalid_argument);
+    ASSERT_THROWS(a * c, std::invalid_argument);
+    ASSERT_THROWS(a / z, std::invalid_argument);
+    ASSERT_THROWS(a / 0.0, std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 8: Operadores compuestos en el mismo buffer
+  // ---------------------------------------------------------
+  TEST_CASE("Expr: Compound assignment updates in place");
+  {
+    Matrix<double> w({1.0, 2.0, 3.0, 4.0}, {2, 2});
+    Matrix<double> g({0.5, 0.5, 1.0, 1.0}, {2, 2});
+    const double *buffer = w.data_ptr();
+
+    w -= g * 2.0;
+    w *= 3.0;
+    w += 1.0;
+
+    ASSERT_EQ(w.data_ptr() == buffer, true);
+    ASSERT_ALMOST_EQ(w.data_ptr()[0], 1.0);
+    ASSERT_ALMOST_EQ(w.data_ptr()[3], 7.0);
+
+    Matrix<double> row({1.0, 2.0}, {1, 2});
+    ASSERT_THROWS(row += w, std::invalid_argument);
+  }
+
+  return run_test_summary();
+}
@@ -0,0 +1,100 @@
+#include "../src/math/functions.h"
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "test_utils.h"
+#include <iostream>
+#include <vector>
+
+using namespace Math;
+
+int main() {
+  std::cout << "=== TEST SUITE: MATRIX VIEW ===" << std::endl;
+
+  // Datos de referencia 4 x 3:
+  // [[ 1,  2,  3],
+  //  [ 4,  5,  6],
+  //  [ 7,  8,  9],
+  //  [10, 11, 12]]
+  Matrix<double> X({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}, {4, 3});
+
+  // ---------------------------------------------------------
+  // CASO 1: Cortes sin copia (filas, fila, columna)
+  // ---------------------------------------------------------
+  TEST_CASE("View: Row range, row and column share the buffer");
+  {
+    MatrixView<double> batch = X.viewRows(1, 3);
+    ASSERT_EQ(batch.rows(), 2);
+    ASSERT_EQ(batch.cols(), 3);
+    ASSERT_EQ(batch.data_ptr() == X.data_ptr() + 3, true);
+    ASSERT_ALMOST_EQ(batch.at(1, 2), 9.0);
+
+    MatrixView<double> col = X.viewCol(1);
+    ASSERT_EQ(col.rows(), 4);
+    ASSERT_EQ(col.contiguous(), false);
+    ASSERT_ALMOST_EQ(col.at(3, 0), 11.0);
+
+    // Materializar explícitamente
+    Matrix<double> colCopy = col;
+    ASSERT_EQ(colCopy.shape()[0], 4);
+    ASSERT_ALMOST_EQ(colCopy.data_ptr()[2], 8.0);
+
+    ASSERT_THROWS(X.viewRows(2, 5), std::out_of_range);
+    ASSERT_THROWS(X.viewRows(3, 2), std::invalid_argument);
+    ASSERT_THROWS(X.viewCol(3), std::out_of_range);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Matmul sobre un mini-batch (leading dimension)
+  // ---------------------------------------------------------
+  TEST_CASE("View: Linalg kernels read views in place");
+  {
+    Matrix<double> W({1, 0, 0, 1, 1, 1}, {3, 2});
+    Matrix<double> out;
+
+    Linalg::matmul(X.viewRows(2, 4), W, out);
+    ASSERT_EQ(out.shape()[0], 2);
+    ASSERT_ALMOST_EQ(out.data_ptr()[0], 16.0);
+    ASSERT_ALMOST_EQ(out.data_ptr()[3], 23.0);
+
+    // Columna no contigua: X[:, 0:1]^T * X[:, 2:3]
+    Linalg::matmul_tn(X.viewCol(0), X.viewCol(2), out);
+    ASSERT_ALMOST_EQ(out.data_ptr()[0], 1.0 * 3 + 4 * 6 + 7 * 9 + 10 * 12);
+
+    Linalg::sum(X.viewCol(2), 0, out);
+    ASSERT_ALMOST_EQ(out.data_ptr()[0], 30.0);
+
+    Matrix<double> t = Linalg::transpose(X.viewRows(0, 2));
+    ASSERT_EQ(t.shape()[0], 3);
+    ASSERT_ALMOST_EQ(t.data_ptr()[1], 4.0);
+
+    Matrix<double> sq = Func::apply<double>(
+        X.viewCol(1), [](double v) { return v * v; });
+    ASSERT_ALMOST_EQ(sq.data_ptr()[3], 121.0);
+
+    // La salida no puede solaparse con la entrada
+    ASSERT_THROWS(Linalg::transpose(X.viewRows(0, 2), X),
+                  std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Vistas dentro de expresiones (broadcast de una fila)
+  // ---------------------------------------------------------
+  TEST_CASE("View: Views are expression operands");
+  {
+    Matrix<double> centered = X.viewRows(1, 3) - X.viewRows(0, 2);
+    ASSERT_ALMOST_EQ(centered.data_ptr()[0], 3.0);
+    ASSERT_ALMOST_EQ(centered.data_ptr()[5], 3.0);
+
+    Matrix<double> shifted = X + X.viewRow(0);
+    ASSERT_ALMOST_EQ(shifted.data_ptr()[11], 15.0);
+
+    // Una columna se difunde sobre las columnas (M x 1)
+    Matrix<double> scaled = X / X.viewCol(0);
+    ASSERT_ALMOST_EQ(scaled.data_ptr()[4], 5.0 / 4.0);
+    ASSERT_ALMOST_EQ(scaled.data_ptr()[11], 12.0 / 10.0);
+
+    ASSERT_THROWS(X / X.viewRows(0, 2), std::invalid_argument);
+  }
+
+  return run_test_summary();
+}
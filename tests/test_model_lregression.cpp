@@ -189,5 +189,33 @@ int main() {
               << std::endl;
   }
 
+  // -----------------------------------------------------------------------
+  // TEST 4: Pipeline completo en float32 (datos, modelo, loss y optimizador)
+  // -----------------------------------------------------------------------
+  TEST_CASE("Model<float>: Entrenamiento end-to-end en precision simple");
+  {
+    Matrix<float> Xf({1, 2, 3, 4}, {4, 1});
+    Matrix<float> Yf({2, 4, 6, 8}, {4, 1});
+
+    auto seq = std::make_shared<Layer::Sequential<float>>();
+    seq->add(std::make_shared<Layer::Dense<float>>(
+        1, std::make_shared<ActFunc::Linear<float>>()));
+    Model<float> model;
+    model.set_layers(seq);
+    model.compile(std::make_shared<CostFunc::MeanSquareError<float>>(),
+                  std::make_shared<Optimizer::Adam<float>>(0.05f));
+
+    float first_loss = model.train_step(Xf, Yf);
+    float last_loss = first_loss;
+    for (int i = 0; i < 2000; i++) {
+      last_loss = model.train_step(Xf, Yf);
+    }
+
+    ASSERT_EQ(last_loss < first_loss, true);
+    ASSERT_EQ(last_loss < 0.01f, true);
+    ASSERT_ALMOST_EQ(model.predict(Matrix<float>({5}, {1, 1})).data()[0] / 10.0f,
+                     1.0f);
+  }
+
   return run_test_summary();
 }
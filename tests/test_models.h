@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../src/nn/activation_func.h"
+#include "../src/nn/model.h"
+#include "test_utils.h"
+#include <memory>
+
+// --- MODELOS DE PRUEBA ---
+
+// Softmax derivada: el modelo no la empareja con la pérdida y la capa usa la
+// cadena de operaciones
+template <typename T> class PlainSoftmax : public NN::ActFunc::Softmax<T> {};
+
+// Red 12 -> 16 -> 5 con la cabeza Softmax dada; seq recibe la Sequential
+template <typename Head>
+std::shared_ptr<NN::Model<double>>
+make_model(std::shared_ptr<NN::Layer::Sequential<double>> *seq = nullptr) {
+  auto layers = std::make_shared<NN::Layer::Sequential<double>>();
+  layers->add(std::make_shared<NN::Layer::Dense<double>>(
+      16, std::make_shared<NN::ActFunc::Tanh<double>>()));
+  layers->add(std::make_shared<NN::Layer::Dense<double>>(
+      5, std::make_shared<Head>()));
+  auto model = std::make_shared<NN::Model<double>>();
+  model->set_layers(layers);
+  if (seq) {
+    *seq = layers;
+  }
+  return model;
+}
@@ -0,0 +1,190 @@
+#include "../src/math/matrix.h"
+#include "../src/nn/optimizer.h"
+#include "../src/utils/thread_pool.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Math;
+using Params = std::vector<std::shared_ptr<Matrix<double>>>;
+
+// pattern() de test_utils.h como parámetro compartido
+static std::shared_ptr<Matrix<double>> param(int rows, int cols,
+                                             unsigned seed) {
+  return std::make_shared<Matrix<double>>(pattern(rows, cols, seed));
+}
+
+// Un peso grande (varios bloques del thread pool) y un bias
+static void make_problem(Params &params, Params &grads, int step) {
+  params = {param(300, 200, 1u), param(1, 7, 2u)};
+  grads = {param(300, 200, 10u + step), param(1, 7, 20u + step)};
+}
+
+// Referencias elemento a elemento, con las fórmulas de los artículos
+struct Reference {
+  std::vector<AlignedVector<double>> w, s1, s2;
+
+  explicit Reference(const Params &params) {
+    for (const auto &p : params) {
+      w.push_back(p->data());
+      s1.emplace_back(p->size(), 0.0);
+      s2.emplace_back(p->size(), 0.0);
+    }
+  }
+
+  template <typename F> void apply(const Params &grads, F &&f) {
+    for (size_t i = 0; i < w.size(); i++) {
+      for (size_t j = 0; j < w[i].size(); j++) {
+        f(w[i][j], grads[i]->data_ptr()[j], s1[i][j], s2[i][j]);
+      }
+    }
+  }
+
+  bool matches(const Params &params, double tol) const {
+    for (size_t i = 0; i < w.size(); i++) {
+      for (size_t j = 0; j < w[i].size(); j++) {
+        if (std::fabs(params[i]->data_ptr()[j] - w[i][j]) > tol) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+// Cinco pasos del optimizador frente a la referencia
+template <typename F>
+static bool run(NN::Optimizer::Optimizer<double> &opt, F &&reference) {
+  Params params, grads;
+  make_problem(params, grads, 0);
+  Reference ref(params);
+  for (int step = 1; step <= 5; step++) {
+    grads = {param(300, 200, 10u + step), param(1, 7, 20u + step)};
+    opt.setup(params, grads);
+    opt.step();
+    ref.apply(grads, [&](double &w, double g, double &s1, double &s2) {
+      reference(step, w, g, s1, s2);
+    });
+  }
+  return ref.matches(params, 1e-12);
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: OPTIMIZERS ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: SGD, Momentum, Nesterov y RMSprop
+  // ---------------------------------------------------------
+  TEST_CASE("Optimizer: SGD, Momentum, Nesterov and RMSprop updates");
+  {
+    NN::Optimizer::SGD<double> sgd(0.1);
+    ASSERT_EQ(run(sgd, [](int, double &w, double g, double &, double &) {
+                w -= 0.1 * g;
+              }),
+              true);
+
+    NN::Optimizer::Momentum<double> momentum(0.1, 0.9);
+    ASSERT_EQ(run(momentum, [](int, double &w, double g, double &v, double &) {
+                v = 0.9 * v + g;
+                w -= 0.1 * v;
+              }),
+              true);
+
+    NN::Optimizer::Nesterov<double> nesterov(0.1, 0.8);
+    ASSERT_EQ(run(nesterov, [](int, double &w, double g, double &v, double &) {
+                v = 0.8 * v + g;
+                w -= 0.1 * (g + 0.8 * v);
+              }),
+              true);
+
+    NN::Optimizer::RMSprop<double> rmsprop(0.01, 0.9, 1e-8);
+    ASSERT_EQ(run(rmsprop, [](int, double &w, double g, double &s, double &) {
+                s = 0.9 * s + 0.1 * g * g;
+                w -= 0.01 * g / (std::sqrt(s) + 1e-8);
+              }),
+              true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Adam y AdamW con la corrección de sesgo
+  // ---------------------------------------------------------
+  TEST_CASE("Optimizer: Adam and AdamW match the reference update");
+  {
+    auto adamRef = [](double wd) {
+      return [wd](int t, double &w, double g, double &m, double &v) {
+        m = 0.9 * m + 0.1 * g;
+        v = 0.999 * v + 0.001 * g * g;
+        double mHat = m / (1.0 - std::pow(0.9, t));
+        double vHat = v / (1.0 - std::pow(0.999, t));
+        w -= 0.01 * mHat / (std::sqrt(vHat) + 1e-8) + 0.01 * wd * w;
+      };
+    };
+
+    NN::Optimizer::Adam<double> adam(0.01);
+    ASSERT_EQ(run(adam, adamRef(0.0)), true);
+
+    NN::Optimizer::AdamW<double> adamw(0.01, 0.1);
+    ASSERT_EQ(run(adamw, adamRef(0.1)), true);
+
+    ASSERT_THROWS(NN::Optimizer::AdamW<double>(0.01, -0.1),
+                  std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Estado por parámetro y número de hilos
+  // ---------------------------------------------------------
+  TEST_CASE("Optimizer: State follows the parameters, any thread count");
+  {
+    // Mismo resultado con 1 y 4 hilos
+    Params a, ga, b, gb;
+    make_problem(a, ga, 0);
+    make_problem(b, gb, 0);
+    NN::Optimizer::Adam<double> optA(0.01), optB(0.01);
+    optA.setup(a, ga);
+    optB.setup(b, gb);
+    size_t threads = Utils::get_num_threads();
+    Utils::set_num_threads(1);
+    optA.step();
+    Utils::set_num_threads(4);
+    optB.step();
+    Utils::set_num_threads(threads);
+    bool same = true;
+    for (size_t i = 0; i < a.size(); i++) {
+      for (size_t j = 0; j < a[i]->size(); j++) {
+        same = same && a[i]->data_ptr()[j] == b[i]->data_ptr()[j];
+      }
+    }
+    ASSERT_EQ(same, true);
+
+    // Otros parámetros: el estado se vuelve a crear
+    Params small = {param(2, 3, 3u)};
+    Params smallGrad = {param(2, 3, 4u)};
+    optA.setup(small, smallGrad);
+    optA.step();
+    ASSERT_EQ(std::isfinite(small[0]->data_ptr()[5]), true);
+
+    // Parámetros nuevos con las mismas formas (p. ej. al compilar otra red):
+    // el optimizador empieza de cero, sin momentos ni paso anteriores
+    ASSERT_EQ(run(optA, [](int t, double &w, double g, double &m, double &v) {
+                m = 0.9 * m + 0.1 * g;
+                v = 0.999 * v + 0.001 * g * g;
+                double mHat = m / (1.0 - std::pow(0.9, t));
+                double vHat = v / (1.0 - std::pow(0.999, t));
+                w -= 0.01 * mHat / (std::sqrt(vHat) + 1e-8);
+              }),
+              true);
+    NN::Optimizer::Momentum<double> momentum(0.1, 0.9);
+    auto momentumRef = [](int, double &w, double g, double &v, double &) {
+      v = 0.9 * v + g;
+      w -= 0.1 * v;
+    };
+    ASSERT_EQ(run(momentum, momentumRef) && run(momentum, momentumRef), true);
+
+    optA.setup(small, {param(3, 2, 4u)});
+    ASSERT_THROWS(optA.step(), std::invalid_argument);
+  }
+
+  return run_test_summary();
+}
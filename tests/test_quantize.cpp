@@ -0,0 +1,287 @@
+#include "../src/math/gemm.h"
+#include "../src/math/matrix.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/model.h"
+#include "../src/nn/optimizer.h"
+#include "../src/nn/quantize.h"
+#include "test_utils.h"
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Math;
+
+// Clase derivada de ReLU: puede cambiar su forward, así que no tiene kernel
+// sin estado aunque no redefina nada
+template <typename T> class CustomReLU : public NN::ActFunc::ReLU<T> {};
+
+// Tres nubes gaussianas en 4 dimensiones, etiquetas one-hot
+static void make_blobs(int n, Matrix<float> &X, Matrix<float> &Y,
+                       unsigned seed) {
+  const float centers[3][4] = {
+      {1.0f, 0.0f, -1.0f, 0.5f},
+      {-1.0f, 1.0f, 0.0f, -0.5f},
+      {0.0f, -1.0f, 1.0f, 1.0f},
+  };
+  Matrix<float> noise = pattern<float>(n, 4, seed, 0.6);
+
+  AlignedVector<float> x(n * 4), y(n * 3, 0.0f);
+  for (int i = 0; i < n; i++) {
+    int c = i % 3;
+    for (int k = 0; k < 4; k++) {
+      x[i * 4 + k] = centers[c][k] + noise.data_ptr()[i * 4 + k];
+    }
+    y[i * 3 + c] = 1.0f;
+  }
+  X = Matrix<float>(std::move(x), {n, 4});
+  Y = Matrix<float>(std::move(y), {n, 3});
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: INT8 QUANTIZATION ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: GEMM entera frente a la referencia (con colas)
+  // ---------------------------------------------------------
+  TEST_CASE("Quant: gemm_s8 matches the reference product");
+  {
+    bool ok = true;
+    for (int M : {1, 7, 13}) {
+      for (int K : {1, 5, 64}) {
+        for (int N : {3, 10, 32, 33, 70}) {
+          int Kp = K + (K & 1);
+          std::vector<int16_t> A((size_t)M * Kp, 0);
+          std::vector<int8_t> B((size_t)K * N);
+          for (int i = 0; i < M; i++) {
+            for (int k = 0; k < K; k++) {
+              A[(size_t)i * Kp + k] = (int16_t)((i * 31 + k * 17) % 255 - 127);
+            }
+          }
+          for (size_t i = 0; i < B.size(); i++) {
+            B[i] = (int8_t)((int)(i * 53 % 255) - 127);
+          }
+
+          Gemm::PackedS8 packed = Gemm::pack_s8(K, N, B.data(), N);
+          // Sin relleno de columnas: la última tira tiene su ancho real
+          ok = ok && packed.bytes() == (size_t)Kp * N;
+          std::vector<int32_t> C((size_t)M * N);
+          Gemm::gemm_s8(M, A.data(), Kp, packed, C.data(), N);
+
+          for (int i = 0; i < M; i++) {
+            for (int j = 0; j < N; j++) {
+              int32_t ref = 0;
+              for (int k = 0; k < K; k++) {
+                ref += (int32_t)A[(size_t)i * Kp + k] * B[(size_t)k * N + j];
+              }
+              ok = ok && C[(size_t)i * N + j] == ref;
+            }
+          }
+        }
+      }
+    }
+    ASSERT_EQ(ok, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Una capa cuantizada aproxima la capa en float
+  // ---------------------------------------------------------
+  TEST_CASE("Quant: QuantizedDense approximates the float layer");
+  {
+    Matrix<float> W({0.5f, -0.25f, 1.0f, 0.0f, 0.75f, -1.0f}, {3, 2});
+    Matrix<float> b({0.1f, -0.2f}, {1, 2});
+    Matrix<float> x({1.0f, -0.5f, 0.25f, -1.0f, 0.0f, 0.5f}, {2, 3});
+
+    NN::Quant::QuantizedDense<float> layer(W, b, nullptr, 1.0f / 127.0f);
+    ASSERT_EQ(layer.inputs(), 3);
+    ASSERT_EQ(layer.outputs(), 2);
+    ASSERT_EQ(layer.weight_scales()[1], 1.0f / 127.0f);
+
+    Matrix<float> ref = Linalg::matmul(x, W) + b;
+    Matrix<float> out = layer.forward(x);
+    ASSERT_EQ(close(out, ref, 0.02), true);
+
+    // Entradas fuera del rango calibrado se saturan
+    Matrix<float> big({4.0f, 0.0f, 0.0f}, {1, 3});
+    ASSERT_EQ(std::fabs(layer.forward(big).data()[0] - (0.5f + 0.1f)) < 0.01f,
+              true);
+    ASSERT_THROWS(layer.forward(W), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Clasificador entrenado, inferencia int8 vs float
+  // ---------------------------------------------------------
+  TEST_CASE("Quant: Int8 predict keeps the float argmax");
+  {
+    Matrix<float> X, Y, X_val, Y_val;
+    make_blobs(300, X, Y, 7u);
+    make_blobs(600, X_val, Y_val, 99u);
+
+    auto seq = std::make_shared<NN::Layer::Sequential<float>>();
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        32, std::make_shared<NN::ActFunc::ReLU<float>>()));
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        16, std::make_shared<NN::ActFunc::Tanh<float>>()));
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        3, std::make_shared<NN::ActFunc::Softmax<float>>()));
+
+    NN::Model<float> model;
+    model.set_layers(seq);
+    model.compile(
+        std::make_shared<NN::CostFunc::CategoricalCrossEntropy<float>>(),
+        std::make_shared<NN::Optimizer::Adam<float>>(0.01f));
+    for (int i = 0; i < 300; i++) {
+      model.train_step(X, Y);
+    }
+
+    ASSERT_THROWS(model.predict(X_val, NN::Inference::Int8),
+                  std::runtime_error);
+    ASSERT_EQ(model.quantized() == nullptr, true);
+
+    model.quantize(X_val, 256);
+    const auto *qnet = model.quantized();
+    ASSERT_EQ(qnet->layers().size(), (size_t)3);
+
+    Matrix<float> pf = model.predict(X_val);
+    Matrix<float> pq = model.predict(X_val, NN::Inference::Int8);
+    ASSERT_EQ(pq.shape()[1], 3);
+
+    std::vector<int> classes = qnet->predict_classes(X_val);
+    int agree = 0, correct = 0;
+    for (int i = 0; i < 600; i++) {
+      const float *f = pf.data_ptr() + i * 3;
+      int cf = (int)(std::max_element(f, f + 3) - f);
+      agree += cf == classes[i];
+      correct += Y_val.data_ptr()[i * 3 + classes[i]] == 1.0f;
+    }
+    std::cout << "   argmax agreement " << agree << " / 600, accuracy "
+              << correct << " / 600" << std::endl;
+    ASSERT_EQ(agree >= 588, true); // >= 98%
+    ASSERT_EQ(correct >= 540, true);
+
+    // Pesos en int8 (escalas y bias en float): ocupan menos que en float
+    size_t floatBytes = 0;
+    for (const auto &p : model.get_parameters()) {
+      floatBytes += p->size() * sizeof(float);
+    }
+    std::cout << "   weights " << floatBytes << " B float -> "
+              << qnet->weight_bytes() << " B int8" << std::endl;
+    ASSERT_EQ(qnet->weight_bytes() < floatBytes, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Memoria en una topología realista (64-128-64-10)
+  // ---------------------------------------------------------
+  TEST_CASE("Quant: Int8 weights take a quarter of the float weights");
+  {
+    auto seq = std::make_shared<NN::Layer::Sequential<float>>();
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        128, std::make_shared<NN::ActFunc::ReLU<float>>()));
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        64, std::make_shared<NN::ActFunc::ReLU<float>>()));
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        10, std::make_shared<NN::ActFunc::Softmax<float>>()));
+    NN::Model<float> model;
+    model.set_layers(seq);
+
+    Matrix<float> sample(AlignedVector<float>(32 * 64, 0.5f), {32, 64});
+    model.predict(sample);
+    model.quantize(sample);
+    const auto *qnet = model.quantized();
+
+    size_t floatWeights = 0, floatBytes = 0, int8Weights = 0;
+    for (auto *layer : model.get_layers()) {
+      auto params = layer->params();
+      floatWeights += params[0]->size() * sizeof(float);
+      floatBytes += (params[0]->size() + params[1]->size()) * sizeof(float);
+    }
+    for (const auto &layer : qnet->layers()) {
+      int8Weights += layer.int8_bytes();
+    }
+    std::cout << "   weights " << floatWeights << " B float -> " << int8Weights
+              << " B int8, with scales and bias " << floatBytes << " B -> "
+              << qnet->weight_bytes() << " B" << std::endl;
+    ASSERT_EQ(int8Weights * 4 <= floatWeights, true);
+    // Escala y bias en float por canal de salida
+    ASSERT_EQ(qnet->weight_bytes() * 7 <= floatBytes * 2, true); // >= 3.5x
+  }
+
+  // ---------------------------------------------------------
+  // CASO 5: La inferencia int8 no toca el estado del modelo float
+  // ---------------------------------------------------------
+  TEST_CASE("Quant: Int8 predict is stateless and thread safe");
+  {
+    auto seq = std::make_shared<NN::Layer::Sequential<float>>();
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        48, std::make_shared<NN::ActFunc::ReLU<float>>()));
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        5, std::make_shared<NN::ActFunc::Softmax<float>>()));
+    NN::Model<float> model;
+    model.set_layers(seq);
+
+    Matrix<float> X, Y;
+    make_blobs(90, X, Y, 3u);
+    Matrix<float> floatBefore = model.predict(X);
+    model.quantize(X);
+    // backward lee las cachés del camino float: deben seguir intactas
+    Matrix<float> dY = pattern<float>(90, 5, 4u);
+    Matrix<float> gradBefore = seq->backward(dY);
+
+    const auto *qnet = model.quantized();
+    Matrix<float> ref = qnet->predict(X);
+    std::vector<int> same(4, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&, t] {
+        bool ok = true;
+        for (int r = 0; r < 20; r++) {
+          Matrix<float> out = qnet->predict(X);
+          for (size_t i = 0; i < out.size(); i++) {
+            ok = ok && out.data_ptr()[i] == ref.data_ptr()[i];
+          }
+        }
+        same[t] = ok;
+      });
+    }
+    for (auto &th : threads) {
+      th.join();
+    }
+    ASSERT_EQ(same[0] && same[1] && same[2] && same[3], true);
+    ASSERT_EQ(close(seq->backward(dY), gradBefore, 0.0f), true);
+    ASSERT_EQ(close(model.predict(X), floatBefore, 0.0f), true);
+
+    // Una activación sin kernel sin estado no se puede cuantizar
+    auto custom = std::make_shared<NN::Layer::Sequential<float>>();
+    custom->add(std::make_shared<NN::Layer::Dense<float>>(
+        4, std::make_shared<CustomReLU<float>>()));
+    NN::Model<float> customModel;
+    customModel.set_layers(custom);
+    customModel.predict(X);
+    ASSERT_THROWS(customModel.quantize(X), std::invalid_argument);
+    ASSERT_THROWS(NN::Quant::QuantizedDense<float>(
+                      pattern<float>(4, 3, 1u), pattern<float>(1, 3, 2u),
+                      std::make_shared<CustomReLU<float>>(), 0.1f),
+                  std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 6: Errores de uso
+  // ---------------------------------------------------------
+  TEST_CASE("Quant: Quantizing an unbuilt model fails");
+  {
+    auto seq = std::make_shared<NN::Layer::Sequential<float>>();
+    seq->add(std::make_shared<NN::Layer::Dense<float>>(
+        2, std::make_shared<NN::ActFunc::Linear<float>>()));
+    NN::Model<float> model;
+    model.set_layers(seq);
+    Matrix<float> x({1.0f, 2.0f}, {1, 2});
+    ASSERT_THROWS(model.quantize(x), std::runtime_error);
+
+    NN::Model<float> empty;
+    ASSERT_THROWS(empty.quantize(x), std::runtime_error);
+  }
+
+  return run_test_summary();
+}
@@ -0,0 +1,145 @@
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "../src/math/reduce.h"
+#include "../src/utils/thread_pool.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace Math;
+
+// Valores en [0.1, 1.1): sumas sin cancelación para medir el error relativo
+template <typename T> static Matrix<T> positive_pattern(int rows, int cols) {
+  AlignedVector<T> v((size_t)rows * cols);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = (T)((double)((i * 7919) % 1000) / 1000.0 + 0.1);
+  }
+  return Matrix<T>(std::move(v), {rows, cols});
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: REDUCTIONS ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Precisión en float
+  // ---------------------------------------------------------
+  TEST_CASE("Reduce: Pairwise and Kahan keep float sums accurate");
+  {
+    const size_t n = 1 << 22;
+    std::vector<float> x(n, 0.1f);
+    double exact = (double)n * (double)0.1f;
+
+    float naive = 0;
+    for (float v : x) {
+      naive += v;
+    }
+    float pairwise = Reduce::sum(x.data(), n);
+    float kahan = Reduce::sum(x.data(), n, Reduce::Method::Kahan);
+
+    double errNaive = std::fabs(naive - exact) / exact;
+    double errPair = std::fabs(pairwise - exact) / exact;
+    double errKahan = std::fabs(kahan - exact) / exact;
+    std::cout << "   rel. error naive " << errNaive << " | pairwise " << errPair
+              << " | kahan " << errKahan << std::endl;
+    ASSERT_EQ(errNaive > 1e-2, true);
+    ASSERT_EQ(errPair < 1e-6, true);
+    ASSERT_EQ(errKahan < 1e-6, true);
+
+    Matrix<float> m(AlignedVector<float>(x.begin(), x.end()), {1024, 4096});
+    ASSERT_EQ(Linalg::sum(m).data()[0], pairwise);
+
+    // Sumas por columnas sobre muchas filas
+    Matrix<float> tall(AlignedVector<float>(x.begin(), x.end()),
+                       {(int)n / 4, 4});
+    Matrix<float> cols = Linalg::sum(tall, 0);
+    for (int j = 0; j < 4; j++) {
+      ASSERT_EQ(std::fabs(cols.data()[j] - exact / 4) / (exact / 4) < 1e-5,
+                true);
+    }
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Resultados frente a una referencia en double
+  // ---------------------------------------------------------
+  TEST_CASE("Reduce: Axis sums match the reference, views included");
+  {
+    for (auto dims : {std::vector<int>{1, 1}, std::vector<int>{3, 5},
+                      std::vector<int>{300, 7}, std::vector<int>{129, 1500},
+                      std::vector<int>{1000, 2}}) {
+      Matrix<double> a = positive_pattern<double>(dims[0], dims[1]);
+      Matrix<double> s0 = Linalg::sum(a, 0);
+      Matrix<double> s1 = Linalg::sum(a, 1);
+      double total = 0;
+      for (int j = 0; j < dims[1]; j++) {
+        double ref = 0;
+        for (int i = 0; i < dims[0]; i++) {
+          ref += a.data()[(size_t)i * dims[1] + j];
+        }
+        total += ref;
+        ASSERT_ALMOST_EQ(s0.data()[j], ref);
+      }
+      for (int i = 0; i < dims[0]; i++) {
+        double ref = 0;
+        for (int j = 0; j < dims[1]; j++) {
+          ref += a.data()[(size_t)i * dims[1] + j];
+        }
+        ASSERT_ALMOST_EQ(s1.data()[i], ref);
+      }
+      ASSERT_ALMOST_EQ(Linalg::sum(a).data()[0] / total, 1.0);
+    }
+
+    // Vista con stride: columnas 1..3 de una matriz 200 x 5
+    Matrix<double> a = positive_pattern<double>(200, 5);
+    Matrix<double> out;
+    MatrixView<double> cols = a.viewCol(1);
+    Linalg::sum(cols, 0, out);
+    double ref = 0;
+    for (int i = 0; i < 200; i++) {
+      ref += a.data()[i * 5 + 1];
+    }
+    ASSERT_ALMOST_EQ(out.data()[0], ref);
+    Linalg::sum(cols, out);
+    ASSERT_ALMOST_EQ(out.data()[0], ref);
+
+    Matrix<double> empty(AlignedVector<double>(), {0, 3});
+    ASSERT_EQ(Linalg::sum(empty, 0).data()[2], 0.0);
+    ASSERT_EQ(Linalg::sum(empty).data()[0], 0.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Mismo resultado con cualquier número de hilos
+  // ---------------------------------------------------------
+  TEST_CASE("Reduce: Bit-identical results for 1 to 4 threads");
+  {
+    Matrix<float> a = positive_pattern<float>(5000, 300);
+    std::vector<float> ref0, ref1;
+    float refAll = 0;
+
+    bool equal = true;
+    size_t poolThreads = Utils::get_num_threads();
+    for (size_t threads = 1; threads <= 4; threads++) {
+      Utils::set_num_threads(threads);
+      Matrix<float> s0 = Linalg::sum(a, 0);
+      Matrix<float> s1 = Linalg::sum(a, 1);
+      float all = Linalg::sum(a).data()[0];
+      if (threads == 1) {
+        ref0.assign(s0.data().begin(), s0.data().end());
+        ref1.assign(s1.data().begin(), s1.data().end());
+        refAll = all;
+        continue;
+      }
+      equal = equal && all == refAll;
+      for (size_t i = 0; i < ref0.size(); i++) {
+        equal = equal && s0.data()[i] == ref0[i];
+      }
+      for (size_t i = 0; i < ref1.size(); i++) {
+        equal = equal && s1.data()[i] == ref1[i];
+      }
+    }
+    Utils::set_num_threads(poolThreads);
+    ASSERT_EQ(equal, true);
+  }
+
+  return run_test_summary();
+}
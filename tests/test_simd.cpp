@@ -0,0 +1,103 @@
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "../src/math/simd.h"
+#include "test_utils.h"
+#include <iostream>
+#include <vector>
+
+using namespace Math;
+
+// Compara un kernel con el bucle escalar en todos los ISA disponibles
+template <Simd::BinOp OP, Simd::Form F, typename T>
+static bool matches_scalar(size_t n) {
+  std::vector<T> a(n), b(n), expected(n), got(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = (T)((int)(i * 7 % 19) - 9) * (T)0.25;
+    b[i] = (T)((int)(i * 5 % 13) + 1) * (T)0.5;
+  }
+  Simd::scalar::binary<OP, F>(a.data(), b.data(), expected.data(), n);
+
+  bool ok = true;
+  for (int isa = 0; isa <= (int)Simd::detect_isa(); isa++) {
+    Simd::set_isa((Simd::Isa)isa);
+    std::fill(got.begin(), got.end(), (T)-1);
+    Simd::binary<OP, F>(a.data(), b.data(), got.data(), n);
+    for (size_t i = 0; i < n; i++) {
+      ok = ok && got[i] == expected[i];
+    }
+  }
+  Simd::set_isa(Simd::detect_isa());
+  return ok;
+}
+
+template <typename T> static bool all_kernels(size_t n) {
+  using Simd::BinOp;
+  using Simd::Form;
+  return matches_scalar<BinOp::Add, Form::VV, T>(n) &&
+         matches_scalar<BinOp::Sub, Form::VS, T>(n) &&
+         matches_scalar<BinOp::Sub, Form::SV, T>(n) &&
+         matches_scalar<BinOp::Mul, Form::VV, T>(n) &&
+         matches_scalar<BinOp::Div, Form::VV, T>(n) &&
+         matches_scalar<BinOp::Div, Form::SV, T>(n);
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: SIMD KERNELS ===" << std::endl;
+  std::cout << "ISA detectado: " << Simd::isa_name(Simd::detect_isa())
+            << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Todos los ISA dan el resultado escalar exacto
+  // ---------------------------------------------------------
+  TEST_CASE("Simd: Kernels match the scalar loop on every ISA");
+  {
+    // Longitudes con cola: menores, iguales y mayores que un registro
+    for (size_t n : {1, 3, 8, 17, 33, 100}) {
+      ASSERT_EQ(all_kernels<float>(n), true);
+      ASSERT_EQ(all_kernels<double>(n), true);
+    }
+
+    ASSERT_EQ(Simd::set_isa(Simd::Isa::Scalar) == Simd::Isa::Scalar, true);
+    ASSERT_EQ(Simd::set_isa(Simd::Isa::AVX512) == Simd::detect_isa(), true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Los operadores de Matrix pasan por los kernels
+  // ---------------------------------------------------------
+  TEST_CASE("Simd: Matrix operators, broadcast and views");
+  {
+    Matrix<float> A({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}, {3, 4});
+    Matrix<float> B({2, 2, 2, 2, 4, 4, 4, 4, 8, 8, 8, 8}, {3, 4});
+    Matrix<float> row({1, 0, -1, 2}, {1, 4});
+
+    Matrix<float> q = A / B;
+    ASSERT_ALMOST_EQ(q.data_ptr()[4], 1.25f);
+    ASSERT_ALMOST_EQ(q.data_ptr()[11], 1.5f);
+
+    Matrix<float> r = 1.0f - A;
+    ASSERT_ALMOST_EQ(r.data_ptr()[9], -9.0f);
+
+    // Broadcast de una fila y vista de una columna (no contigua)
+    Matrix<float> s = A + row;
+    ASSERT_ALMOST_EQ(s.data_ptr()[6], 6.0f);
+    ASSERT_ALMOST_EQ(s.data_ptr()[11], 14.0f);
+
+    Matrix<float> c = A.viewCol(3) * 2.0f;
+    ASSERT_EQ(c.shape()[0], 3);
+    ASSERT_ALMOST_EQ(c.data_ptr()[2], 24.0f);
+
+    // Actualización in-place
+    A -= B;
+    ASSERT_ALMOST_EQ(A.data_ptr()[0], -1.0f);
+    ASSERT_ALMOST_EQ(A.data_ptr()[11], 4.0f);
+
+    Linalg::scal(0.5f, A);
+    ASSERT_ALMOST_EQ(A.data_ptr()[11], 2.0f);
+
+    Matrix<double> D({1, 2, 3, 4, 5, 6}, {2, 3});
+    Matrix<double> E = D + std::vector<double>{10, 20, 30};
+    ASSERT_ALMOST_EQ(E.data_ptr()[5], 36.0);
+  }
+
+  return run_test_summary();
+}
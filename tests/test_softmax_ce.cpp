@@ -0,0 +1,260 @@
+#include "../src/math/matrix.h"
+#include "../src/math/sparse.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/cost_func.h"
+#include "../src/nn/model.h"
+#include "../src/nn/optimizer.h"
+#include "test_models.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Math;
+
+// Softmax con temperatura 2: softmax(z / 2)
+class TemperatureSoftmax : public NN::ActFunc::Softmax<double> {
+public:
+  Matrix<double> _compute_output() override {
+    Matrix<double> z = *this->input_ / 2.0;
+    NN::Fused::softmax_rows(z.data_ptr(), z.data_ptr(), (size_t)z.shape()[0],
+                            (size_t)z.shape()[1]);
+    return z;
+  }
+  Matrix<double>
+  _compute_input_grad(const Matrix<double> &output_grad) override {
+    return NN::ActFunc::Softmax<double>::_compute_input_grad(output_grad) /
+           2.0;
+  }
+};
+
+static Matrix<double> one_hot(int rows, int classes) {
+  AlignedVector<double> v((size_t)rows * classes, 0.0);
+  for (int i = 0; i < rows; i++) {
+    v[(size_t)i * classes + (i * 7) % classes] = 1.0;
+  }
+  return Matrix<double>(std::move(v), {rows, classes});
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: SOFTMAX + CROSS ENTROPY ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Pérdida y gradiente desde los logits
+  // ---------------------------------------------------------
+  TEST_CASE("SoftmaxCE: forward_logits matches Softmax + CCE");
+  {
+    Matrix<double> Z = pattern(6, 5, 1u, 3.0);
+    Matrix<double> Y = one_hot(6, 5);
+
+    NN::ActFunc::Softmax<double> softmax;
+    Matrix<double> P = softmax.forward(Z);
+    NN::CostFunc::CategoricalCrossEntropy<double> cce;
+    double lossRef = cce.forward(P, Y);
+    Matrix<double> gradRef = softmax.backward(cce.backward());
+
+    double loss = cce.forward_logits(Z, Y);
+    Matrix<double> grad = cce.backward();
+    ASSERT_ALMOST_EQ(loss, lossRef);
+    ASSERT_EQ(close(grad, gradRef, 1e-6), true);
+    ASSERT_EQ(close(grad, (P - Y) / 6.0, 1e-12), true);
+
+    // Con las probabilidades ya calculadas no hay exponenciales
+    ASSERT_ALMOST_EQ(cce.forward_logits(Z, P, Y), lossRef);
+    ASSERT_EQ(close(cce.backward(), gradRef, 1e-6), true);
+
+    // La siguiente llamada a forward vuelve al camino normal
+    cce.forward(P, Y);
+    ASSERT_EQ(close(cce.backward(), gradRef, 1e-6), false);
+    ASSERT_THROWS(cce.forward_logits(Z, one_hot(6, 4)), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Logits grandes (log-sum-exp frente a eps)
+  // ---------------------------------------------------------
+  TEST_CASE("SoftmaxCE: Large logits give the exact loss");
+  {
+    Matrix<double> Z({1000.0, 0.0, 500.0, 500.0}, {2, 2});
+    Matrix<double> Y({0.0, 1.0, 1.0, 0.0}, {2, 2});
+    NN::CostFunc::CategoricalCrossEntropy<double> cce;
+
+    // (1000 + log 2) / 2, el camino con eps se queda en ~-log(1e-9)
+    double loss = cce.forward_logits(Z, Y);
+    ASSERT_ALMOST_EQ(loss, (1000.0 + std::log(2.0)) / 2.0);
+    Matrix<double> grad = cce.backward();
+    ASSERT_ALMOST_EQ(grad.data_ptr()[0], 0.5);
+    ASSERT_ALMOST_EQ(grad.data_ptr()[1], -0.5);
+    ASSERT_ALMOST_EQ(grad.data_ptr()[2], -0.25);
+
+    Matrix<double> P({1.0, 0.0, 0.5, 0.5}, {2, 2});
+    ASSERT_ALMOST_EQ(cce.forward_logits(Z, P, Y),
+                     (1000.0 + std::log(2.0)) / 2.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Entrenamiento fusionado frente al encadenado
+  // ---------------------------------------------------------
+  TEST_CASE("SoftmaxCE: Model fuses the pair and trains like the chain");
+  {
+    std::shared_ptr<NN::Layer::Sequential<double>> seqF, seqC;
+    auto fused = make_model<NN::ActFunc::Softmax<double>>(&seqF);
+    auto chain = make_model<PlainSoftmax<double>>(&seqC);
+
+    Matrix<double> X = pattern(40, 12, 2u);
+    Matrix<double> Y = one_hot(40, 5);
+    fused->predict(X);
+    chain->predict(X);
+    auto pf = fused->get_parameters(), pc = chain->get_parameters();
+    for (size_t i = 0; i < pf.size(); i++) {
+      *pf[i] = *pc[i];
+    }
+
+    fused->compile(
+        std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>(),
+        std::make_shared<NN::Optimizer::SGD<double>>(0.1));
+    chain->compile(
+        std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>(),
+        std::make_shared<NN::Optimizer::SGD<double>>(0.1));
+    auto *head = dynamic_cast<NN::Layer::Dense<double> *>(
+        fused->get_layers().back());
+    ASSERT_EQ(head->softmax_loss_fused(), true);
+
+    bool same = true;
+    for (int step = 0; step < 10; step++) {
+      double lf = fused->train_step(X, Y);
+      double lc = chain->train_step(X, Y);
+      same = same && std::fabs(lf - lc) < 1e-6;
+    }
+    ASSERT_EQ(same, true);
+    ASSERT_ALMOST_EQ(fused->evaluate(X, Y), chain->evaluate(X, Y));
+
+    // predict sigue devolviendo probabilidades
+    Matrix<double> P = fused->predict(X);
+    ASSERT_EQ(close(P, chain->predict(X), 1e-6), true);
+    ASSERT_ALMOST_EQ(Linalg::sum(P.viewRow(3)).data_ptr()[0], 1.0);
+
+    // Otra pérdida deshace la fusión
+    fused->compile(std::make_shared<NN::CostFunc::MeanSquareError<double>>(),
+                   std::make_shared<NN::Optimizer::SGD<double>>(0.1));
+    ASSERT_EQ(head->softmax_loss_fused(), false);
+    ASSERT_THROWS(head->logits(), std::runtime_error);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Entrada dispersa en la capa de salida
+  // ---------------------------------------------------------
+  TEST_CASE("SoftmaxCE: Sparse input into a fused softmax head");
+  {
+    auto build = [](auto act) {
+      auto seq = std::make_shared<NN::Layer::Sequential<double>>();
+      seq->add(std::make_shared<NN::Layer::Dense<double>>(4, act));
+      auto model = std::make_shared<NN::Model<double>>();
+      model->set_layers(seq);
+      return model;
+    };
+    auto fused = build(std::make_shared<NN::ActFunc::Softmax<double>>());
+    auto chain = build(std::make_shared<PlainSoftmax<double>>());
+
+    Matrix<double> dense = pattern(30, 20, 3u);
+    for (size_t i = 0; i < dense.size(); i += 3) {
+      dense.data_ptr()[i] = 0.0;
+    }
+    auto X = SparseMatrix<double>::from_dense(dense);
+    Matrix<double> Y = one_hot(30, 4);
+    fused->predict(X);
+    chain->predict(X);
+    auto pf = fused->get_parameters(), pc = chain->get_parameters();
+    for (size_t i = 0; i < pf.size(); i++) {
+      *pf[i] = *pc[i];
+    }
+    for (auto &m : {fused, chain}) {
+      m->compile(
+          std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>(),
+          std::make_shared<NN::Optimizer::SGD<double>>(0.5));
+    }
+
+    bool same = true;
+    for (int step = 0; step < 5; step++) {
+      same = same &&
+             std::fabs(fused->train_step(X, Y) - chain->train_step(X, Y)) <
+                 1e-6;
+    }
+    ASSERT_EQ(same, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 5: Cambiar la red de un modelo ya compilado
+  // ---------------------------------------------------------
+  TEST_CASE("SoftmaxCE: set_layers releases the fused head of the old network");
+  {
+    auto model = std::make_shared<NN::Model<double>>();
+    auto net = [] {
+      auto seq = std::make_shared<NN::Layer::Sequential<double>>();
+      seq->add(std::make_shared<NN::Layer::Dense<double>>(
+          4, std::make_shared<NN::ActFunc::Softmax<double>>()));
+      return seq;
+    };
+    auto cce = [] {
+      return std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>();
+    };
+    Matrix<double> X = pattern(8, 6, 4u);
+    Matrix<double> Y = one_hot(8, 4);
+
+    // La red anterior se destruye al reemplazarla
+    model->set_layers(net());
+    model->compile(cce(), std::make_shared<NN::Optimizer::SGD<double>>(0.1));
+    model->train_step(X, Y);
+    model->set_layers(net());
+    model->compile(cce(), std::make_shared<NN::Optimizer::SGD<double>>(0.1));
+    double loss = model->train_step(X, Y);
+    ASSERT_EQ(std::isfinite(loss), true);
+
+    // Sin compile: la pérdida se empareja con la nueva cabeza
+    auto kept = net();
+    model->set_layers(kept);
+    model->train_step(X, Y);
+    auto *head = dynamic_cast<NN::Layer::Dense<double> *>(
+        model->get_layers().back());
+    ASSERT_EQ(head->softmax_loss_fused(), true);
+
+    // La red que sigue viva fuera del modelo queda sin fusionar
+    model->set_layers(net());
+    ASSERT_EQ(head->softmax_loss_fused(), false);
+    ASSERT_EQ(std::isfinite(model->train_step(X, Y)), true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 6: Una Softmax derivada no se fusiona con la pérdida
+  // ---------------------------------------------------------
+  TEST_CASE("SoftmaxCE: A Softmax subclass keeps its own forward");
+  {
+    auto model = make_model<TemperatureSoftmax>();
+    auto plain = make_model<NN::ActFunc::Softmax<double>>();
+    Matrix<double> X = pattern(8, 12, 6u);
+    model->predict(X);
+    plain->predict(X);
+    auto pm = model->get_parameters(), pp = plain->get_parameters();
+    for (size_t i = 0; i < pm.size(); i++) {
+      *pm[i] = *pp[i];
+    }
+
+    model->compile(
+        std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>(),
+        std::make_shared<NN::Optimizer::SGD<double>>(0.1));
+    auto *head = dynamic_cast<NN::Layer::Dense<double> *>(
+        model->get_layers().back());
+    ASSERT_EQ(head->softmax_loss_fused(), false);
+    ASSERT_THROWS(head->fuse_softmax_loss(true), std::invalid_argument);
+
+    // softmax(z / 2) al cuadrado y normalizada por fila es softmax(z)
+    Matrix<double> P = model->predict(X);
+    Matrix<double> Q = P * P;
+    Matrix<double> rows = Linalg::sum(Q, 1);
+    Matrix<double> expected = plain->predict(X);
+    ASSERT_EQ(close(expected, Q / rows, 1e-9), true);
+    ASSERT_EQ(close(P, expected, 1e-3), false);
+    ASSERT_EQ(std::isfinite(model->train_step(X, one_hot(8, 5))), true);
+  }
+
+  return run_test_summary();
+}
@@ -0,0 +1,150 @@
+#include "../src/math/matrix.h"
+#include "../src/math/sparse.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/model.h"
+#include "../src/nn/optimizer.h"
+#include "../src/utils/split_shuffle.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Math;
+
+// Matriz densa con ~90% de ceros
+static Matrix<double> mostly_zeros(int rows, int cols, unsigned seed) {
+  AlignedVector<double> v((size_t)rows * cols, 0.0);
+  unsigned state = seed;
+  for (auto &x : v) {
+    unsigned r = lcg_next(state);
+    if ((r >> 16) % 10 == 0) {
+      x = (double)((r >> 8) % 17) / 4.0 - 2.0;
+    }
+  }
+  return Matrix<double>(std::move(v), {rows, cols});
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: SPARSE MATRIX ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Construcción CSR y conversión
+  // ---------------------------------------------------------
+  TEST_CASE("Sparse: CSR layout and dense round trip");
+  {
+    Matrix<int> D({0, 3, 0, 0, 0, 0, 0, 0, 1, 0, 0, 2}, {3, 4});
+    auto S = SparseMatrix<double>::from_dense(D);
+    ASSERT_EQ(S.nnz(), (size_t)3);
+    ASSERT_EQ(S.row_ptr()[1], 1);
+    ASSERT_EQ(S.row_ptr()[2], 1); // fila vacía
+    ASSERT_EQ(S.col_idx()[2], 3);
+    ASSERT_ALMOST_EQ(S.density(), 0.25);
+
+    Matrix<double> back = S.to_dense();
+    for (size_t i = 0; i < D.size(); i++) {
+      ASSERT_EQ(back.data_ptr()[i], (double)D.data_ptr()[i]);
+    }
+
+    auto rows = S.gather_rows({2, 0});
+    ASSERT_EQ(rows.rows(), 2);
+    ASSERT_EQ(rows.values()[0], 1.0);
+    ASSERT_EQ(S.slice_rows(1, 2).nnz(), (size_t)0);
+    ASSERT_THROWS(S.slice_rows(2, 4), std::out_of_range);
+
+    // Índices desordenados o fuera de rango
+    ASSERT_THROWS(SparseMatrix<double>(1, 3, {0, 2}, {2, 1}, {1.0, 1.0}),
+                  std::invalid_argument);
+    ASSERT_THROWS(SparseMatrix<double>(1, 3, {0, 1}, {3}, {1.0}),
+                  std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Kernels disperso x denso
+  // ---------------------------------------------------------
+  TEST_CASE("Sparse: spmm and spmm_tn match the dense products");
+  {
+    Matrix<double> X = mostly_zeros(37, 150, 3u);
+    Matrix<double> W = mostly_zeros(150, 70, 5u) + 0.5;
+    Matrix<double> dY = mostly_zeros(37, 70, 7u) - 0.25;
+    auto S = SparseMatrix<double>::from_dense(X);
+
+    ASSERT_EQ(close(Linalg::spmm(S, W), Linalg::matmul(X, W), 1e-9), true);
+    ASSERT_EQ(close(Linalg::spmm_tn(S, dY), Linalg::matmul_tn(X, dY), 1e-9),
+              true);
+
+    // Buffer reutilizado con datos previos y vistas de filas
+    Matrix<double> out = Linalg::matmul(X, W);
+    Linalg::spmm_tn(S, dY.viewRows(0, 37), out);
+    ASSERT_EQ(close(out, Linalg::matmul_tn(X, dY), 1e-9), true);
+    ASSERT_THROWS(Linalg::spmm(S, dY), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Dense con entrada dispersa = entrada densa
+  // ---------------------------------------------------------
+  TEST_CASE("Sparse: Dense layer gives the same output and gradients");
+  {
+    Matrix<double> X = mostly_zeros(16, 64, 11u);
+    auto S = SparseMatrix<double>::from_dense(X);
+    Matrix<double> dY = mostly_zeros(16, 8, 13u) + 0.1;
+
+    NN::Layer::Dense<double> layer(8,
+                                   std::make_shared<NN::ActFunc::Tanh<double>>());
+    Matrix<double> outSparse = layer.forward(S); // construye la capa
+    layer.backward(dY);
+    Matrix<double> dW = *layer.param_grads()[0];
+    Matrix<double> db = *layer.param_grads()[1];
+
+    Matrix<double> outDense = layer.forward(X);
+    layer.backward(dY);
+    ASSERT_EQ(close(outSparse, outDense, 1e-9), true);
+    ASSERT_EQ(close(dW, *layer.param_grads()[0], 1e-9), true);
+    ASSERT_EQ(close(db, *layer.param_grads()[1], 1e-9), true);
+
+    NN::Layer::Sequential<double> empty;
+    ASSERT_THROWS(empty.forward(S), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Split y entrenamiento de un modelo con entradas CSR
+  // ---------------------------------------------------------
+  TEST_CASE("Sparse: SplitShuffle and Model training on CSR inputs");
+  {
+    // y = suma de las features 0..3, el resto es ruido disperso
+    Matrix<double> X = mostly_zeros(200, 100, 17u);
+    AlignedVector<double> y(200);
+    for (int i = 0; i < 200; i++) {
+      y[i] = 0;
+      for (int k = 0; k < 4; k++) {
+        y[i] += X.data_ptr()[i * 100 + k];
+      }
+    }
+    Matrix<double> Y(std::move(y), {200, 1});
+    auto S = SparseMatrix<double>::from_dense(X);
+
+    auto dense = Utils::SplitShuffle::split(X, Y, 0.75f, 42);
+    auto sparse = Utils::SplitShuffle::split(S, Y, 0.75f, 42);
+    ASSERT_EQ(sparse.X_train.rows(), 150);
+    ASSERT_EQ(close(sparse.X_val.to_dense(), dense.X_val, 1e-9), true);
+    ASSERT_EQ(close(sparse.Y_train, dense.Y_train, 1e-9), true);
+
+    auto seq = std::make_shared<NN::Layer::Sequential<double>>();
+    seq->add(std::make_shared<NN::Layer::Dense<double>>(
+        1, std::make_shared<NN::ActFunc::Linear<double>>()));
+    NN::Model<double> model;
+    model.set_layers(seq);
+    model.compile(std::make_shared<NN::CostFunc::MeanSquareError<double>>(),
+                  std::make_shared<NN::Optimizer::Adam<double>>(0.05));
+
+    model.fit(sparse.X_train, sparse.Y_train, sparse.X_val, sparse.Y_val, 400,
+              {}, 1000);
+    double loss = model.evaluate(sparse.X_val, sparse.Y_val);
+    ASSERT_EQ(loss < 0.05, true);
+    ASSERT_EQ(close(model.predict(sparse.X_val), model.predict(dense.X_val),
+                    1e-9),
+              true);
+  }
+
+  return run_test_summary();
+}
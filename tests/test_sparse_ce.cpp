@@ -0,0 +1,173 @@
+#include "../src/math/matrix.h"
+#include "../src/nn/activation_func.h"
+#include "../src/nn/cost_func.h"
+#include "../src/nn/model.h"
+#include "../src/nn/optimizer.h"
+#include "../src/utils/encoding.h"
+#include "../src/utils/split_shuffle.h"
+#include "test_models.h"
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Math;
+
+static Matrix<int> labels_for(int rows, int classes) {
+  AlignedVector<int> v((size_t)rows);
+  for (int i = 0; i < rows; i++) {
+    v[i] = (i * 7) % classes;
+  }
+  return Matrix<int>(std::move(v), {rows, 1});
+}
+
+static void copy_parameters(NN::Model<double> &dst, NN::Model<double> &src,
+                            const Matrix<double> &x) {
+  dst.predict(x);
+  src.predict(x);
+  auto pd = dst.get_parameters(), ps = src.get_parameters();
+  for (size_t i = 0; i < pd.size(); i++) {
+    *pd[i] = *ps[i];
+  }
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: SPARSE CROSS ENTROPY ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Etiquetas enteras frente a la matriz One-Hot
+  // ---------------------------------------------------------
+  TEST_CASE("SparseCE: Integer labels match the one-hot loss and gradient");
+  {
+    Matrix<double> Z = pattern(7, 5, 1u, 3.0);
+    Matrix<int> labels = labels_for(7, 5);
+    Matrix<double> Y = Data::Encoder::toOneHot<double>(labels, 5);
+
+    NN::ActFunc::Softmax<double> softmax;
+    Matrix<double> P = softmax.forward(Z);
+    NN::CostFunc::CategoricalCrossEntropy<double> cce;
+    NN::CostFunc::SparseCategoricalCrossEntropy<double> sparse;
+
+    // Probabilidades: -1 / (N p) solo en la columna de la etiqueta
+    double lossRef = cce.forward(P, Y);
+    Matrix<double> gradRef = cce.backward();
+    ASSERT_ALMOST_EQ(sparse.forward(P, labels), lossRef);
+    ASSERT_EQ(close(sparse.backward(), gradRef, 1e-9), true);
+
+    // Logits, con y sin las probabilidades ya calculadas
+    lossRef = cce.forward_logits(Z, Y);
+    gradRef = cce.backward();
+    ASSERT_ALMOST_EQ(sparse.forward_logits(Z, labels), lossRef);
+    ASSERT_EQ(close(sparse.backward(), gradRef, 1e-12), true);
+    ASSERT_ALMOST_EQ(sparse.forward_logits(Z, P, labels), lossRef);
+    ASSERT_EQ(close(sparse.backward(), gradRef, 1e-12), true);
+
+    // Los objetivos One-Hot siguen funcionando como en la clase base
+    ASSERT_ALMOST_EQ(sparse.forward(P, Y), cce.forward(P, Y));
+    ASSERT_EQ(close(sparse.backward(), cce.backward(), 1e-12), true);
+
+    Matrix<int> bad({0, 1, 2, 3, 4, 5, 0}, {7, 1});
+    ASSERT_THROWS(sparse.forward(P, bad), std::out_of_range);
+    ASSERT_THROWS(sparse.forward_logits(Z, labels_for(6, 5)),
+                  std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Entrenamiento con etiquetas frente a One-Hot
+  // ---------------------------------------------------------
+  TEST_CASE("SparseCE: Model trains on labels like on one-hot targets");
+  {
+    Matrix<double> X = pattern(40, 12, 2u);
+    Matrix<int> labels = labels_for(40, 5);
+    Matrix<double> Y = Data::Encoder::toOneHot<double>(labels, 5);
+
+    auto sgd = [] { return std::make_shared<NN::Optimizer::SGD<double>>(0.1); };
+    auto sparseLoss = [] {
+      return std::make_shared<
+          NN::CostFunc::SparseCategoricalCrossEntropy<double>>();
+    };
+
+    // Cabeza fusionada (logits) y cabeza encadenada (probabilidades)
+    bool same = true;
+    for (int fusedHead = 0; fusedHead < 2; fusedHead++) {
+      auto ref = make_model<NN::ActFunc::Softmax<double>>();
+      auto model = fusedHead ? make_model<NN::ActFunc::Softmax<double>>()
+                             : make_model<PlainSoftmax<double>>();
+      copy_parameters(*model, *ref, X);
+      ref->compile(
+          std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>(),
+          sgd());
+      model->compile(sparseLoss(), sgd());
+
+      for (int step = 0; step < 10; step++) {
+        same = same && std::fabs(model->train_step(X, labels) -
+                                 ref->train_step(X, Y)) < 1e-6;
+      }
+      same = same &&
+             std::fabs(model->evaluate(X, labels) - ref->evaluate(X, Y)) < 1e-6;
+    }
+    ASSERT_EQ(same, true);
+
+    // fit con validación sobre etiquetas
+    auto model = make_model<NN::ActFunc::Softmax<double>>();
+    model->compile(sparseLoss(), sgd());
+    double before = model->evaluate(X, labels);
+    Matrix<double> xVal = pattern(10, 12, 3u);
+    model->fit(X, labels, xVal, labels_for(10, 5), 20, {}, 100);
+    ASSERT_EQ(model->evaluate(X, labels) < before, true);
+
+    // Otra pérdida no sabe qué hacer con índices de clase
+    model->compile(
+        std::make_shared<NN::CostFunc::CategoricalCrossEntropy<double>>(),
+        sgd());
+    ASSERT_THROWS(model->train_step(X, labels), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Reconstruir el mismo modelo (como el botón Compile de la GUI)
+  // ---------------------------------------------------------
+  TEST_CASE("SparseCE: Rebuilding a model keeps the fused head valid");
+  {
+    NN::Model<double> model;
+    Matrix<double> X = pattern(30, 12, 6u);
+    Matrix<int> labels = labels_for(30, 5);
+
+    bool finite = true;
+    for (int rebuild = 0; rebuild < 3; rebuild++) {
+      auto seq = std::make_shared<NN::Layer::Sequential<double>>();
+      seq->add(std::make_shared<NN::Layer::Dense<double>>(
+          5, std::make_shared<NN::ActFunc::Softmax<double>>()));
+      model.set_layers(seq);
+      model.compile(
+          std::make_shared<NN::CostFunc::SparseCategoricalCrossEntropy<double>>(),
+          std::make_shared<NN::Optimizer::SGD<double>>(0.1));
+      auto *head =
+          dynamic_cast<NN::Layer::Dense<double> *>(model.get_layers().back());
+      finite = finite && head->softmax_loss_fused() &&
+               std::isfinite(model.train_step(X, labels)) &&
+               std::isfinite(model.evaluate(X, labels));
+    }
+    ASSERT_EQ(finite, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: SplitShuffle con etiquetas enteras
+  // ---------------------------------------------------------
+  TEST_CASE("SparseCE: SplitShuffle keeps integer labels as indices");
+  {
+    Matrix<double> X = pattern(50, 4, 4u);
+    Matrix<int> labels = labels_for(50, 10);
+    Matrix<double> Y = Data::Encoder::toOneHot<double>(labels, 10);
+
+    auto byIndex = Utils::SplitShuffle::split(X, labels, 0.8f, 7);
+    auto oneHot = Utils::SplitShuffle::split(X, Y, 0.8f, 7);
+    ASSERT_EQ(byIndex.Y_train.shape()[1], 1);
+    ASSERT_EQ(byIndex.Y_val.shape()[0], 10);
+    ASSERT_EQ(close(byIndex.X_train, oneHot.X_train, 0.0), true);
+    ASSERT_EQ(close(Data::Encoder::toOneHot<double>(byIndex.Y_val, 10),
+                    oneHot.Y_val, 0.0),
+              true);
+  }
+
+  return run_test_summary();
+}
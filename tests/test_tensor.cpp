@@ -0,0 +1,247 @@
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "../src/math/tensor.h"
+#include "../src/utils/thread_pool.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace Math;
+
+// iota de test_utils.h con la forma dims
+template <typename T> static Tensor<T> iota_tensor(const std::vector<int> &dims) {
+  int n = 1;
+  for (int d : dims) {
+    n *= d;
+  }
+  return Tensor<T>(iota<T>(1, n).data(), dims);
+}
+
+// Producto de referencia de un lote, indice a indice
+static bool check_bmm(const Tensor<double> &a, const Tensor<double> &b,
+                      const Tensor<double> &c) {
+  bool shared = b.rank() == 2;
+  for (int n = 0; n < a.dim(0); n++) {
+    for (int i = 0; i < a.dim(1); i++) {
+      for (int j = 0; j < c.dim(2); j++) {
+        double ref = 0;
+        for (int k = 0; k < a.dim(2); k++) {
+          ref += a.at({n, i, k}) * (shared ? b.at({k, j}) : b.at({n, k, j}));
+        }
+        if (std::abs(ref - c.at({n, i, j})) > 1e-9) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: TENSOR ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Forma, strides e indexado
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: Rank, strides and indexing of an NCHW batch");
+  {
+    Tensor<float> t = iota_tensor<float>({2, 3, 4, 5});
+    ASSERT_EQ(t.rank(), (size_t)4);
+    ASSERT_EQ(t.size(), (size_t)120);
+    ASSERT_EQ(t.strides()[0], (ptrdiff_t)60);
+    ASSERT_EQ(t.strides()[3], (ptrdiff_t)1);
+    ASSERT_EQ(t.is_contiguous(), true);
+    ASSERT_EQ(t.at({1, 2, 3, 4}), 119.0f);
+    ASSERT_EQ(t.at({1, 0, 2, 1}), 71.0f);
+    ASSERT_THROWS(t.at({2, 0, 0, 0}), std::out_of_range);
+    ASSERT_THROWS(t.at({0, 0, 0}), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Vistas sin copia
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: Slice, select and permute share the buffer");
+  {
+    Tensor<float> t = iota_tensor<float>({2, 3, 4, 5});
+
+    Tensor<float> channel = t.select(1, 2); // N x H x W
+    ASSERT_EQ(channel.rank(), (size_t)3);
+    ASSERT_EQ(channel.shares_storage(t), true);
+    ASSERT_EQ(channel.at({1, 3, 4}), t.at({1, 2, 3, 4}));
+
+    Tensor<float> rows = t.slice(2, 1, 3);
+    ASSERT_EQ(rows.dim(2), 2);
+    ASSERT_EQ(rows.is_contiguous(), false);
+    ASSERT_EQ(rows.at({0, 1, 0, 2}), t.at({0, 1, 1, 2}));
+
+    Tensor<float> nhwc = t.permute({0, 2, 3, 1});
+    ASSERT_EQ(nhwc.dim(3), 3);
+    ASSERT_EQ(nhwc.at({1, 3, 4, 2}), t.at({1, 2, 3, 4}));
+    ASSERT_THROWS(t.permute({0, 0, 1, 2}), std::invalid_argument);
+
+    // Escribir en una vista modifica el original
+    channel.at({0, 0, 0}) = -1.0f;
+    ASSERT_EQ(t.at({0, 2, 0, 0}), -1.0f);
+    rows.fill(7.0f);
+    ASSERT_EQ(t.at({1, 2, 2, 4}), 7.0f);
+    ASSERT_EQ(t.at({1, 2, 3, 4}), 119.0f);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Copias compactas y reshape
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: contiguous() packs strided views, reshape infers -1");
+  {
+    Tensor<float> t = iota_tensor<float>({2, 3, 4});
+    Tensor<float> packed = t.permute({2, 0, 1}).contiguous();
+    ASSERT_EQ(packed.is_contiguous(), true);
+    ASSERT_EQ(packed.shares_storage(t), false);
+    bool ok = true;
+    for (int k = 0; k < 4; k++) {
+      for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 3; j++) {
+          ok = ok && packed.at({k, i, j}) == t.at({i, j, k});
+        }
+      }
+    }
+    ASSERT_EQ(ok, true);
+
+    Tensor<float> flat = t.reshape({-1, 4});
+    ASSERT_EQ(flat.dim(0), 6);
+    ASSERT_EQ(flat.shares_storage(t), true); // contiguo: vista
+    Tensor<float> moved = t.transpose(0, 2).reshape({4, 6});
+    ASSERT_EQ(moved.shares_storage(t), false); // con strides: copia
+    ASSERT_EQ(moved.at({1, 0}), t.at({0, 0, 1}));
+    ASSERT_THROWS(t.reshape({5, -1}), std::invalid_argument);
+    ASSERT_THROWS(t.reshape({-1, -1}), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Escalares (rango 0)
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: Selecting down to a scalar gives one element");
+  {
+    Tensor<double> v = iota_tensor<double>({3});
+    Tensor<double> s = v.select(0, 1);
+    ASSERT_EQ(s.rank(), (size_t)0);
+    ASSERT_EQ(s.size(), (size_t)1);
+    ASSERT_EQ(s.at({}), 1.0);
+
+    Tensor<double> copy = s.clone();
+    ASSERT_EQ(copy.size(), (size_t)1);
+    ASSERT_EQ(copy.shares_storage(v), false);
+    ASSERT_EQ(copy.at({}), 1.0);
+    ASSERT_EQ(s.contiguous().at({}), 1.0);
+
+    // Desde una vista con strides: la traspuesta en [2][1] es el [1][2]
+    Tensor<double> t = iota_tensor<double>({2, 3}).transpose(0, 1);
+    Tensor<double> scalar = t.select(0, 2).select(0, 1).clone();
+    ASSERT_EQ(scalar.at({}), 5.0);
+
+    int rows = 0;
+    s.for_each_row([&](size_t pos, ptrdiff_t) {
+      rows++;
+      ASSERT_EQ(pos, (size_t)1);
+    });
+    ASSERT_EQ(rows, 1);
+
+    Tensor<double> zero(std::vector<int>{});
+    ASSERT_EQ(zero.size(), (size_t)1);
+    zero.fill(7.0);
+    ASSERT_EQ(zero.at({}), 7.0);
+    ASSERT_EQ(Tensor<double>().size(), (size_t)0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 5: Puente con Matrix
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: 2-D slices run the Matrix kernels in place");
+  {
+    Matrix<float> m({1, 2, 3, 4, 5, 6}, {2, 3});
+    Tensor<float> t(m);
+    ASSERT_EQ(t.at({1, 2}), 6.0f);
+    Matrix<float> back = t.to_matrix();
+    ASSERT_EQ(back.shape() == m.shape(), true);
+    ASSERT_EQ(back.data() == m.data(), true);
+
+    Tensor<float> batch = iota_tensor<float>({3, 4, 5});
+    MatrixView<float> v = batch.select(0, 1).slice(1, 1, 4).matrix();
+    ASSERT_EQ(v.rows(), 4);
+    ASSERT_EQ(v.cols(), 3);
+    ASSERT_EQ((int)v.ld(), 5);
+    ASSERT_EQ(v.data_ptr()[v.ld() + 0], batch.at({1, 1, 1}));
+    Matrix<float> total = Linalg::sum(batch.select(0, 2).matrix());
+    ASSERT_ALMOST_EQ(total.data()[0], (float)(40 + 59) * 10);
+    ASSERT_THROWS(batch.select(0, 0).transpose(0, 1).matrix(),
+                  std::invalid_argument);
+    ASSERT_THROWS(batch.matrix(), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 6: GEMM por lotes
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: Batched GEMM on packed, permuted and shared operands");
+  {
+    Tensor<double> a = iota_tensor<double>({4, 5, 6});
+    Tensor<double> b = iota_tensor<double>({4, 6, 3});
+    for (size_t i = 0; i < b.size(); i++) {
+      b.data_ptr()[i] = std::sin((double)i);
+    }
+    ASSERT_EQ(check_bmm(a, b, Linalg::bmm(a, b)), true);
+
+    // B^T leido como columna mayor, sin copia
+    Tensor<double> bt = iota_tensor<double>({4, 3, 6}).transpose(1, 2);
+    ASSERT_EQ(check_bmm(a, bt, Linalg::bmm(a, bt)), true);
+
+    // Sin dimension contigua: se compacta antes del GEMM
+    Tensor<double> odd = iota_tensor<double>({4, 6, 3, 2}).select(3, 1);
+    ASSERT_EQ(check_bmm(a, odd, Linalg::bmm(a, odd)), true);
+
+    // Pesos compartidos por todo el lote
+    Tensor<double> w = iota_tensor<double>({6, 2});
+    ASSERT_EQ(check_bmm(a, w, Linalg::bmm(a, w)), true);
+
+    ASSERT_THROWS(Linalg::bmm(a, a), std::invalid_argument);
+    ASSERT_THROWS(Linalg::bmm(w, w), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 7: Varios hilos
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: Batched GEMM with 4 threads");
+  {
+    size_t threads = Utils::get_num_threads();
+    Utils::set_num_threads(4);
+    Tensor<double> a = iota_tensor<double>({16, 20, 30});
+    Tensor<double> b = iota_tensor<double>({16, 30, 10});
+    bool ok = check_bmm(a, b, Linalg::bmm(a, b));
+    Utils::set_num_threads(threads);
+    ASSERT_EQ(ok, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 8: Tensor construido por defecto (sin buffer)
+  // ---------------------------------------------------------
+  TEST_CASE("Tensor: A default-constructed tensor is usable");
+  {
+    Tensor<float> t;
+    ASSERT_EQ(t.size(), (size_t)0);
+    ASSERT_EQ(t.data_ptr() == nullptr, true);
+
+    std::ostringstream os;
+    os << t;
+    ASSERT_EQ(os.str().empty(), false);
+
+    t.fill(1.0f);
+    Tensor<float> c = t.clone();
+    ASSERT_EQ(c.size(), (size_t)0);
+    ASSERT_EQ(c.dims() == t.dims(), true);
+    Tensor<float> p = t.contiguous();
+    ASSERT_EQ(p.size(), (size_t)0);
+    ASSERT_EQ(p.dims() == t.dims(), true);
+  }
+
+  return run_test_summary();
+}
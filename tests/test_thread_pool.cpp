@@ -0,0 +1,175 @@
+#include "../src/math/functions.h"
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "../src/utils/thread_pool.h"
+#include "test_utils.h"
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace Math;
+
+int main() {
+  std::cout << "=== TEST SUITE: THREAD POOL ===" << std::endl;
+
+  Utils::set_num_threads(4);
+
+  // ---------------------------------------------------------
+  // CASO 1: Cada índice se visita exactamente una vez
+  // ---------------------------------------------------------
+  TEST_CASE("ThreadPool: parallel_for covers the range exactly once");
+  {
+    ASSERT_EQ(Utils::get_num_threads(), (size_t)4);
+
+    const size_t n = 100000;
+    std::vector<std::atomic<int>> hits(n);
+    for (auto &h : hits) {
+      h = 0;
+    }
+
+    Utils::parallel_for(0, n, 1000, [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        hits[i]++;
+      }
+    });
+
+    bool once = true;
+    for (auto &h : hits) {
+      once = once && h == 1;
+    }
+    ASSERT_EQ(once, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Rangos pequeños y llamadas anidadas van en serie
+  // ---------------------------------------------------------
+  TEST_CASE("ThreadPool: Small ranges and nested calls run inline");
+  {
+    std::thread::id caller = std::this_thread::get_id();
+    int calls = 0;
+    bool sameThread = true;
+
+    // Menos de dos granos: una sola llamada en el hilo que invoca
+    Utils::parallel_for(0, 100, 64, [&](size_t lo, size_t hi) {
+      calls++;
+      sameThread = std::this_thread::get_id() == caller;
+      ASSERT_EQ(lo, (size_t)0);
+      ASSERT_EQ(hi, (size_t)100);
+    });
+    ASSERT_EQ(calls, 1);
+    ASSERT_EQ(sameThread, true);
+
+    // Dentro de una región paralela no se crean más tareas
+    std::atomic<int> innerCalls{0};
+    std::atomic<int> outerCalls{0};
+    Utils::parallel_for(0, 64, 1, [&](size_t, size_t) {
+      outerCalls++;
+      std::thread::id self = std::this_thread::get_id();
+      Utils::parallel_for(0, 1000, 1, [&](size_t a, size_t b) {
+        innerCalls++;
+        if (std::this_thread::get_id() != self || a != 0 || b != 1000) {
+          innerCalls += 1000;
+        }
+      });
+    });
+    ASSERT_EQ(innerCalls.load(), outerCalls.load());
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Las excepciones llegan al hilo que invoca
+  // ---------------------------------------------------------
+  TEST_CASE("ThreadPool: Exceptions propagate to the caller");
+  {
+    ASSERT_THROWS(Utils::parallel_for(0, 10000, 10,
+                                      [](size_t lo, size_t hi) {
+                                        if (lo <= 5000 && 5000 < hi) {
+                                          throw std::runtime_error("boom");
+                                        }
+                                      }),
+                  std::runtime_error);
+
+    // El pool sigue utilizable tras el error
+    std::atomic<size_t> total{0};
+    Utils::parallel_for(0, 10000, 10,
+                        [&](size_t lo, size_t hi) { total += hi - lo; });
+    ASSERT_EQ(total.load(), (size_t)10000);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Los kernels dan el mismo resultado con 1 y N hilos
+  // ---------------------------------------------------------
+  TEST_CASE("ThreadPool: Kernels match between 1 and N threads");
+  {
+    const int n = 300;
+    AlignedVector<double> da((size_t)n * n), db((size_t)n * n);
+    for (size_t i = 0; i < da.size(); i++) {
+      da[i] = (double)((i * 7) % 13) - 6.0;
+      db[i] = (double)((i * 5) % 11) * 0.5;
+    }
+    Matrix<double> a(da, {n, n});
+    Matrix<double> b(db, {n, n});
+
+    Utils::set_num_threads(1);
+    ASSERT_EQ(Utils::get_num_threads(), (size_t)1);
+    Matrix<double> mm1 = Linalg::matmul(a, b);
+    Matrix<double> ew1 = a * b + a;
+    Matrix<double> t1 = Linalg::transpose(a);
+    Matrix<double> s1 = Linalg::sum(a, 0);
+
+    Utils::set_num_threads(4);
+    Matrix<double> mm4 = Linalg::matmul(a, b);
+    Matrix<double> ew4 = a * b + a;
+    Matrix<double> t4 = Linalg::transpose(a);
+    Matrix<double> s4 = Linalg::sum(a, 0);
+
+    bool equal = true;
+    for (size_t i = 0; i < mm1.size(); i++) {
+      equal = equal && mm1.data()[i] == mm4.data()[i] &&
+              ew1.data()[i] == ew4.data()[i] && t1.data()[i] == t4.data()[i];
+    }
+    for (size_t i = 0; i < s1.size(); i++) {
+      equal = equal && s1.data()[i] == s4.data()[i];
+    }
+    ASSERT_EQ(equal, true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 5: Redimensionar el pool mientras otro hilo lo usa
+  // ---------------------------------------------------------
+  TEST_CASE("ThreadPool: set_num_threads from another thread");
+  {
+    const size_t n = 100000;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> once{true};
+    std::thread user([&] {
+      std::vector<int> hits(n);
+      while (!stop) {
+        std::fill(hits.begin(), hits.end(), 0);
+        Utils::parallel_for(0, n, 1000, [&](size_t lo, size_t hi) {
+          for (size_t i = lo; i < hi; i++) {
+            hits[i]++;
+          }
+        });
+        size_t threads = Utils::get_num_threads();
+        bool ok = threads >= 1 && threads <= 4;
+        for (int h : hits) {
+          ok = ok && h == 1;
+        }
+        if (!ok) {
+          once = false;
+        }
+      }
+    });
+    for (int i = 0; i < 50; i++) {
+      Utils::set_num_threads(1 + i % 4);
+    }
+    stop = true;
+    user.join();
+    Utils::set_num_threads(4);
+    ASSERT_EQ(once.load(), true);
+  }
+
+  return run_test_summary();
+}
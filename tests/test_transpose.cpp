@@ -0,0 +1,113 @@
+#include "../src/math/matrix.h"
+#include "../src/math/matrix_linalg.h"
+#include "../src/math/simd.h"
+#include "../src/utils/thread_pool.h"
+#include "test_utils.h"
+#include <iostream>
+#include <vector>
+
+using namespace Math;
+
+// out == m^T elemento a elemento
+template <typename T>
+static bool is_transpose(const MatrixView<T> &m, const Matrix<T> &out) {
+  if (out.shape()[0] != m.cols() || out.shape()[1] != m.rows()) {
+    return false;
+  }
+  for (int i = 0; i < m.rows(); i++) {
+    for (int j = 0; j < m.cols(); j++) {
+      if (out.data()[(size_t)j * m.rows() + i] != m.data_ptr()[i * m.ld() + j]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename T> static bool check_shapes() {
+  bool ok = true;
+  for (int rows : {1, 3, 8, 31, 33, 100}) {
+    for (int cols : {1, 4, 9, 32, 65}) {
+      Matrix<T> m = iota<T>(rows, cols);
+      ok = ok && is_transpose<T>(m, Linalg::transpose(m));
+    }
+  }
+  return ok;
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: TRANSPOSE ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Todas las formas, tipos e ISA
+  // ---------------------------------------------------------
+  TEST_CASE("Transpose: Tiled kernel matches on every shape and ISA");
+  {
+    bool ok = true;
+    for (int isa = 0; isa <= (int)Simd::detect_isa(); isa++) {
+      Simd::set_isa((Simd::Isa)isa);
+      ok = ok && check_shapes<float>() && check_shapes<double>();
+    }
+    Simd::set_isa(Simd::detect_isa());
+    ASSERT_EQ(ok, true);
+    ASSERT_EQ(check_shapes<int>(), true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Vistas con leading dimension
+  // ---------------------------------------------------------
+  TEST_CASE("Transpose: Row ranges and columns of larger matrices");
+  {
+    Matrix<float> m = iota<float>(70, 50);
+    Matrix<float> out;
+    Linalg::transpose<float>(m.viewRows(5, 60), out);
+    ASSERT_EQ(is_transpose<float>(m.viewRows(5, 60), out), true);
+    ASSERT_EQ(is_transpose<float>(m.viewCol(7), Linalg::transpose(m.viewCol(7))),
+              true);
+    ASSERT_THROWS(Linalg::transpose<float>(out, out), std::invalid_argument);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Transpuesta in-place
+  // ---------------------------------------------------------
+  TEST_CASE("Transpose: In-place on square and rectangular matrices");
+  {
+    bool ok = true;
+    for (int n : {1, 7, 32, 45, 130}) {
+      Matrix<double> m = iota<double>(n, n);
+      Matrix<double> ref = Linalg::transpose(m);
+      const double *before = m.data_ptr();
+      Linalg::transpose_inplace(m);
+      ok = ok && m.data_ptr() == before; // sin buffer nuevo
+      for (size_t i = 0; i < m.size(); i++) {
+        ok = ok && m.data()[i] == ref.data()[i];
+      }
+    }
+    ASSERT_EQ(ok, true);
+
+    Matrix<float> r = iota<float>(3, 70);
+    Matrix<float> copy = r;
+    Linalg::transpose_inplace(r);
+    ASSERT_EQ(is_transpose<float>(copy, r), true);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Varios hilos
+  // ---------------------------------------------------------
+  TEST_CASE("Transpose: Same result with 4 threads");
+  {
+    Utils::set_num_threads(4);
+    Matrix<float> m = iota<float>(513, 1025);
+    Matrix<float> sq = iota<float>(300, 300);
+    Matrix<float> ref = Linalg::transpose(sq);
+    Linalg::transpose_inplace(sq);
+    bool ok = is_transpose<float>(m, Linalg::transpose(m));
+    for (size_t i = 0; i < sq.size(); i++) {
+      ok = ok && sq.data()[i] == ref.data()[i];
+    }
+    Utils::set_num_threads(std::thread::hardware_concurrency());
+    ASSERT_EQ(ok, true);
+  }
+
+  return run_test_summary();
+}
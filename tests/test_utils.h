@@ -1,9 +1,14 @@
 #pragma once
 
+#include "../src/math/matrix.h"
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <type_traits>
 
 // --- COLORES ANSI ---
 #define COLOR_RESET "\033[0m"
@@ -81,6 +86,58 @@ void print_failure(const char *file, int line, const std::string &msg,
     }                                                                          \
   } while (0)
 
+// --- DATOS DE PRUEBA ---
+
+// Generador congruencial de los tests: reproducible en cualquier plataforma
+inline unsigned lcg_next(unsigned &state) {
+  state = state * 1103515245u + 12345u;
+  return state;
+}
+
+// Matriz rows x cols con valores en [-scale, scale], fijada por la semilla
+template <typename T = double>
+Math::Matrix<T> pattern(int rows, int cols, unsigned seed,
+                        double scale = 1.0) {
+  Math::AlignedVector<T> v((size_t)rows * cols);
+  unsigned state = seed;
+  for (auto &x : v) {
+    x = (T)(scale * ((double)((lcg_next(state) >> 8) % 2001) / 1000.0 - 1.0));
+  }
+  return Math::Matrix<T>(std::move(v), {rows, cols});
+}
+
+// Matriz rows x cols con start, start + 1, ... en orden de filas
+template <typename T = double>
+Math::Matrix<T> iota(int rows, int cols, double start = 0.0) {
+  Math::AlignedVector<T> v((size_t)rows * cols);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = (T)(start + (double)i);
+  }
+  return Math::Matrix<T>(std::move(v), {rows, cols});
+}
+
+// |a - b| <= tol elemento a elemento, relativo a |b| cuando |b| > 1
+template <typename T>
+bool close(const T *a, const T *b, size_t n, double tol) {
+  for (size_t i = 0; i < n; i++) {
+    double ref = (double)b[i];
+    double diff = std::fabs((double)a[i] - ref);
+    // Negado para que un NaN cuente como diferente
+    if (!(diff <= tol * std::max(1.0, std::fabs(ref)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// b no participa en la deducción: admite expresiones como (P - Y) / 6.0
+template <typename T>
+bool close(const Math::Matrix<T> &a,
+           const Math::Matrix<std::common_type_t<T>> &b, double tol) {
+  return a.shape() == b.shape() &&
+         close(a.data_ptr(), b.data_ptr(), a.size(), tol);
+}
+
 inline int run_test_summary() {
   std::lock_guard<std::mutex> lock(g_io_mutex);
   if (g_failed_tests == 0) {
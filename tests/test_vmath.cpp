@@ -0,0 +1,171 @@
+#include "../src/math/functions.h"
+#include "../src/math/matrix.h"
+#include "../src/math/vmath.h"
+#include "../src/nn/activation_func.h"
+#include "test_utils.h"
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace Math;
+
+// Error en ULP de `got` frente a una referencia en long double
+template <typename T> static double ulp_error(T got, long double ref) {
+  T r = (T)ref;
+  if (std::isnan(ref) || std::isinf(ref)) {
+    return (std::isnan(got) == std::isnan(ref) && (std::isnan(got) || got == r))
+               ? 0.0
+               : 1e30;
+  }
+  T ulp = std::nextafter(std::fabs(r), std::numeric_limits<T>::infinity()) -
+          std::fabs(r);
+  return (double)(std::fabs((long double)got - ref) / ulp);
+}
+
+// Máximo error de un kernel de array sobre [lo, hi] en todos los ISA
+template <typename T, typename F, typename R>
+static double max_ulp(F kernel, R reference, double lo, double hi,
+                      VMath::Precision p) {
+  const size_t n = 20011;
+  std::vector<T> x(n), y(n);
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (T)(lo + (hi - lo) * (double)i / (double)(n - 1));
+  }
+
+  double worst = 0;
+  for (int isa = 0; isa <= (int)Simd::detect_isa(); isa++) {
+    Simd::set_isa((Simd::Isa)isa);
+    kernel(x.data(), y.data(), n, p);
+    for (size_t i = 0; i < n; i++) {
+      worst = std::max(worst, ulp_error<T>(y[i], reference((long double)x[i])));
+    }
+  }
+  Simd::set_isa(Simd::detect_isa());
+  return worst;
+}
+
+// Cotas documentadas en vmath.h, en ULP
+struct Bounds {
+  double exp, log, tanh, sigmoid;
+};
+
+// Cota relativa expresada en ULP de T (1 ULP >= epsilon / 2 relativo)
+template <typename T> static double relative_bound(double rel) {
+  return rel / (double)(std::numeric_limits<T>::epsilon() / 2);
+}
+
+template <typename T> static void check_bounds(VMath::Precision p,
+                                               Bounds bound) {
+  using P = const T *;
+  auto exp_k = [](P x, T *y, size_t n, VMath::Precision q) {
+    VMath::exp(x, y, n, q);
+  };
+  auto log_k = [](P x, T *y, size_t n, VMath::Precision q) {
+    VMath::log(x, y, n, q);
+  };
+  auto tanh_k = [](P x, T *y, size_t n, VMath::Precision q) {
+    VMath::tanh(x, y, n, q);
+  };
+  auto sigmoid_k = [](P x, T *y, size_t n, VMath::Precision q) {
+    VMath::sigmoid(x, y, n, q);
+  };
+  auto sigmoid_ref = [](long double v) { return 1.0L / (1.0L + expl(-v)); };
+  auto tanh_ref = [](long double v) { return tanhl(v); };
+
+  double expHi = sizeof(T) == 4 ? 88.0 : 709.0;
+  ASSERT_EQ(max_ulp<T>(exp_k, [](long double v) { return expl(v); }, -80.0,
+                       expHi, p) <= bound.exp,
+            true);
+  ASSERT_EQ(max_ulp<T>(log_k, [](long double v) { return logl(v); }, 1e-6,
+                       1e6, p) <= bound.log,
+            true);
+  ASSERT_EQ(max_ulp<T>(tanh_k, tanh_ref, -12.0, 12.0, p) <= bound.tanh, true);
+  // Cerca de 0, donde expm1 y el cociente acumulan más error
+  ASSERT_EQ(max_ulp<T>(tanh_k, tanh_ref, -0.3, 0.3, p) <= bound.tanh, true);
+  ASSERT_EQ(max_ulp<T>(sigmoid_k, sigmoid_ref, -60.0, 60.0, p) <=
+                bound.sigmoid,
+            true);
+}
+
+int main() {
+  std::cout << "=== TEST SUITE: VMATH ===" << std::endl;
+
+  // ---------------------------------------------------------
+  // CASO 1: Cotas de error documentadas (modo Accurate)
+  // ---------------------------------------------------------
+  TEST_CASE("VMath: Accurate kernels stay within their documented bounds");
+  {
+    check_bounds<float>(VMath::Precision::Accurate, {2.0, 2.0, 3.0, 3.0});
+    check_bounds<double>(VMath::Precision::Accurate, {2.0, 2.0, 3.0, 3.0});
+  }
+
+  // ---------------------------------------------------------
+  // CASO 2: Modo Fast
+  // ---------------------------------------------------------
+  TEST_CASE("VMath: Fast kernels stay within their documented bounds");
+  {
+    check_bounds<float>(VMath::Precision::Fast, {3.0, 3.0, 8.0, 4.0});
+    check_bounds<double>(
+        VMath::Precision::Fast,
+        {relative_bound<double>(1e-11), relative_bound<double>(5e-11),
+         relative_bound<double>(5e-11), relative_bound<double>(1e-11)});
+  }
+
+  // ---------------------------------------------------------
+  // CASO 3: Valores especiales
+  // ---------------------------------------------------------
+  TEST_CASE("VMath: Infinities, NaN, zeros and subnormals");
+  {
+    const double inf = std::numeric_limits<double>::infinity();
+    ASSERT_EQ(VMath::exp(inf), inf);
+    ASSERT_EQ(VMath::exp(-inf), 0.0);
+    ASSERT_EQ(VMath::exp(1000.0), inf);
+    ASSERT_EQ(std::isnan(VMath::exp(std::nan(""))), true);
+    ASSERT_EQ(VMath::exp(-745.0) > 0.0, true); // subnormal
+
+    ASSERT_EQ(VMath::log(0.0), -inf);
+    ASSERT_EQ(VMath::log(inf), inf);
+    ASSERT_EQ(std::isnan(VMath::log(-1.0)), true);
+    ASSERT_ALMOST_EQ(VMath::log(1e-310), std::log(1e-310));
+
+    ASSERT_EQ(VMath::tanh(50.0f), 1.0f);
+    ASSERT_EQ(VMath::tanh(-50.0f), -1.0f);
+    ASSERT_EQ(std::signbit(VMath::tanh(-0.0)), true);
+    ASSERT_EQ(VMath::sigmoid(-1000.0), 0.0);
+    ASSERT_EQ(VMath::sigmoid(1000.0), 1.0);
+  }
+
+  // ---------------------------------------------------------
+  // CASO 4: Func:: y Softmax usan los kernels
+  // ---------------------------------------------------------
+  TEST_CASE("VMath: Func expressions and Softmax");
+  {
+    Matrix<double> X({-2.0, -0.5, 0.0, 0.5, 2.0, 4.0}, {2, 3});
+
+    Matrix<double> s = Func::sigmoid(X);
+    Matrix<double> t = Func::tanh(X.viewCol(1));
+    Matrix<double> l = Func::log(X * X + 1.0);
+    for (size_t i = 0; i < X.size(); i++) {
+      double v = X.data_ptr()[i];
+      ASSERT_ALMOST_EQ(s.data_ptr()[i], 1.0 / (1.0 + std::exp(-v)));
+      ASSERT_ALMOST_EQ(l.data_ptr()[i], std::log(v * v + 1.0));
+    }
+    ASSERT_ALMOST_EQ(t.data_ptr()[1], std::tanh(2.0));
+
+    NN::ActFunc::Softmax<double> softmax;
+    Matrix<double> p = softmax.forward(X);
+    for (int r = 0; r < 2; r++) {
+      double sum = 0;
+      for (int c = 0; c < 3; c++) {
+        sum += p.data_ptr()[r * 3 + c];
+      }
+      ASSERT_ALMOST_EQ(sum, 1.0);
+    }
+    ASSERT_ALMOST_EQ(p.data_ptr()[0],
+                     std::exp(-2.0) /
+                         (std::exp(-2.0) + std::exp(-0.5) + std::exp(0.0)));
+  }
+
+  return run_test_summary();
+}